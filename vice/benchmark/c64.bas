@@ -0,0 +1,13 @@
+10 rem vice benchmark for the c64 and c64sc: basic, screen, sprites,
+20 rem sid and the disk drive, until the cycle limit is reached
+30 s=54272:for i=0 to 24:poke s+i,0:next
+40 poke s+24,15:poke s+5,9:poke s+6,240:poke s+4,33
+50 v=53248:for i=0 to 7:poke 2040+i,13
+60 poke v+i*2,24+i*32:poke v+i*2+1,60+i*16:next:poke v+21,255
+100 n=n+1:poke s+1,n and 63
+110 print n;sqr(n);sin(n)
+120 poke v+1,50+(n and 127)
+130 if n-int(n/50)*50 then 100
+140 open 2,8,2,"@0:bench,s,w":for i=1 to 20:print#2,i*n:next:close 2
+150 open 2,8,2,"bench,s,r":for i=1 to 20:input#2,a:next:close 2
+160 goto 100
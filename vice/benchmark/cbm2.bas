@@ -0,0 +1,10 @@
+10 rem vice benchmark for the cbm-ii: basic, screen, sid and the disk
+20 rem drive, until the cycle limit is reached; poke goes to bank 15
+30 s=55808:for i=0 to 24:poke s+i,0:next
+40 poke s+24,15:poke s+5,9:poke s+6,240:poke s+4,33
+100 n=n+1:poke s+1,n and 63
+110 print n;sqr(n);sin(n)
+130 if n-int(n/50)*50 then 100
+140 open 2,8,2,"@0:bench,s,w":for i=1 to 20:print#2,i*n:next:close 2
+150 open 2,8,2,"bench,s,r":for i=1 to 20:input#2,a:next:close 2
+160 goto 100
@@ -0,0 +1,111 @@
+#!/bin/sh
+#
+# run.sh - Run the benchmark programs on the emulators and collect the
+#          results.
+#
+# This file is part of VICE, the Versatile Commodore Emulator.
+# See README for copyright notice.
+#
+#  This program is free software; you can redistribute it and/or modify
+#  it under the terms of the GNU General Public License as published by
+#  the Free Software Foundation; either version 2 of the License, or
+#  (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software
+#  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+#  02111-1307  USA.
+#
+# Usage: run.sh [-b <bindir>] [-o <outdir>] [-c <cycles>] [<emulator>...]
+#
+# For each emulator (all of them if none is given) the BASIC program of
+# its machine is tokenized with petcat and written to a new disk image
+# with c1541, which is then autostarted in benchmark mode with true drive
+# emulation.  The JSON written by each emulator is kept in <outdir> as
+# <emulator>.json, and all of them are collected in <outdir>/results.json.
+#
+# <bindir> is where the emulators, petcat and c1541 are (default: src of
+# the build tree this script is run from), <outdir> defaults to
+# benchmark-results, and <cycles> is passed to -limitcycles (default: 10
+# emulated seconds).
+
+srcdir=`dirname "$0"`
+bindir=src
+outdir=benchmark-results
+cycles=
+
+while test $# -gt 0; do
+    case "$1" in
+        -b) bindir="$2"; shift 2 ;;
+        -o) outdir="$2"; shift 2 ;;
+        -c) cycles="$2"; shift 2 ;;
+        -*) echo "usage: $0 [-b <bindir>] [-o <outdir>] [-c <cycles>] [<emulator>...]" >&2
+            exit 1 ;;
+        *) break ;;
+    esac
+done
+
+if test $# -eq 0; then
+    set -- x64 x64sc x128 xvic xplus4 xpet xcbm2
+fi
+
+mkdir -p "$outdir" || exit 1
+
+failed=0
+results="$outdir/results.json"
+echo "{" > "$results"
+separator=
+
+for emu in "$@"; do
+    # program, petcat BASIC version and drive type of each machine
+    case "$emu" in
+        x64|x64sc) prog=c64;   basic=2;  drive=1541 ;;
+        x128)      prog=c128;  basic=70; drive=1541 ;;
+        xvic)      prog=vic20; basic=2;  drive=1541 ;;
+        xplus4)    prog=plus4; basic=3;  drive=1541 ;;
+        xpet)      prog=pet;   basic=40; drive=2031 ;;
+        xcbm2)     prog=cbm2;  basic=40; drive=2031 ;;
+        *) echo "$0: unknown emulator $emu" >&2
+           failed=1
+           continue ;;
+    esac
+
+    prg="$outdir/$emu.prg"
+    d64="$outdir/$emu.d64"
+    json="$outdir/$emu.json"
+    rm -f "$prg" "$d64" "$json"
+
+    if ! "$bindir/petcat" -w$basic -o "$prg" -- "$srcdir/$prog.bas" \
+       || ! "$bindir/c1541" -format "benchmark,vb" d64 "$d64" \
+                            -write "$prg" bench > /dev/null; then
+        echo "$0: cannot create the disk image for $emu" >&2
+        failed=1
+        continue
+    fi
+
+    "$bindir/$emu" -default -console -truedrive -drive8type $drive \
+        -basicload ${cycles:+-limitcycles $cycles} \
+        -benchmark "$json" -autostart "$d64" > "$outdir/$emu.log" 2>&1
+
+    if test ! -s "$json"; then
+        echo "$0: $emu did not write a result, see $outdir/$emu.log" >&2
+        failed=1
+        continue
+    fi
+
+    speed=`sed -n 's/.*"speed_percent": \([0-9.]*\).*/\1/p' "$json"`
+    echo "$emu: $speed%"
+
+    printf '%s  "%s": ' "$separator" "$emu" >> "$results"
+    sed -e '1!s/^/  /' "$json" >> "$results"
+    separator=,
+done
+
+echo "}" >> "$results"
+
+exit $failed
@@ -0,0 +1,9 @@
+10 rem vice benchmark for the vic-20: basic, screen, vic sound and the
+20 rem disk drive, until the cycle limit is reached
+30 s=36874:poke s+4,15
+100 n=n+1:poke s+2,128+(n and 127)
+110 print n;sqr(n);sin(n)
+130 if n-int(n/50)*50 then 100
+140 open 2,8,2,"@0:bench,s,w":for i=1 to 20:print#2,i*n:next:close 2
+150 open 2,8,2,"bench,s,r":for i=1 to 20:input#2,a:next:close 2
+160 goto 100
@@ -54,6 +54,7 @@ void alarm_context_init(alarm_context_t *context, const char *name)
 
     context->num_pending_alarms = 0;
     context->next_pending_alarm_clk = (CLOCK) ~0L;
+    context->next_pending_alarm_idx = -1;
 }
 
 void alarm_context_destroy(alarm_context_t *context)
@@ -85,6 +86,8 @@ void alarm_context_time_warp(alarm_context_t *context, CLOCK warp_amount,
         return;
     }
 
+    /* Every pending alarm moves by the same amount, so the heap order is
+       preserved.  */
     for (i = 0; i < context->num_pending_alarms; i++) {
         if (warp_direction > 0) {
             context->pending_alarms[i].clk += warp_amount;
@@ -167,7 +170,8 @@ void alarm_destroy(alarm_t *alarm)
 void alarm_unset(alarm_t *alarm)
 {
     alarm_context_t *context;
-    int idx;
+    alarm_t *moved;
+    int idx, last, slot;
 
     idx = alarm->pending_idx;
 
@@ -176,33 +180,39 @@ void alarm_unset(alarm_t *alarm)
     }
     context = alarm->context;
 
-    if (context->num_pending_alarms > 1) {
-        int last;
-
-        last = --context->num_pending_alarms;
+    last = (int)(--context->num_pending_alarms);
+
+    /* The alarm in the last slot takes over the slot of the unset one,
+       which moves it after the alarms with the same clock in between.  */
+    slot = context->pending_alarms[idx].slot;
+    moved = context->pending_slots[last];
+    if (moved != alarm) {
+        context->pending_slots[slot] = moved;
+        context->pending_alarms[moved->pending_idx].slot = slot;
+        if (moved->pending_idx != 0) {
+            alarm_context_sift_down(context, moved->pending_idx);
+        }
+        idx = alarm->pending_idx;
+    }
 
-        if (last != idx) {
-            /* Let's copy the struct by hand to make sure stupid compilers
-               don't do stupid things.  */
-            context->pending_alarms[idx].alarm
-                = context->pending_alarms[last].alarm;
-            context->pending_alarms[idx].clk
-                = context->pending_alarms[last].clk;
+    if (last != idx) {
+        pending_alarms_t old_entry;
 
-            context->pending_alarms[idx].alarm->pending_idx = idx;
-        }
+        /* Fill the hole with the last heap entry and restore the heap
+           order from there.  */
+        old_entry = context->pending_alarms[idx];
+        context->pending_alarms[idx] = context->pending_alarms[last];
 
-        if (context->next_pending_alarm_idx == idx) {
-            alarm_context_update_next_pending(context);
-        } else if (context->next_pending_alarm_idx == last) {
-            context->next_pending_alarm_idx = idx;
+        if (idx != 0 && alarm_context_before(&context->pending_alarms[idx],
+                                             &old_entry)) {
+            alarm_context_sift_up(context, idx);
+        } else {
+            alarm_context_sift_down(context, idx);
         }
-    } else {
-        context->num_pending_alarms = 0;
-        context->next_pending_alarm_clk = (CLOCK) ~0L;
-        context->next_pending_alarm_idx = -1;
     }
 
+    alarm_context_update_next_pending(context);
+
     alarm->pending_idx = -1;
 }
 
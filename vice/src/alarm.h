@@ -28,6 +28,7 @@
 #ifndef VICE_ALARM_H
 #define VICE_ALARM_H
 
+#include "benchmark.h"
 #include "types.h"
 
 #define ALARM_CONTEXT_MAX_PENDING_ALARMS 0x100
@@ -45,7 +46,7 @@ struct alarm_s {
     /* Callback to be called when the alarm is dispatched.  */
     alarm_callback_t callback;
 
-    /* Index into the pending alarm list.  If < 0, the alarm is not
+    /* Index into the pending alarm heap.  If < 0, the alarm is not
        pending.  */
     int pending_idx;
 
@@ -63,6 +64,9 @@ struct pending_alarms_s {
 
     /* Clock tick at which this alarm should be activated.  */
     CLOCK clk;
+
+    /* Index into `pending_slots' of the context.  */
+    int slot;
 };
 typedef struct pending_alarms_s pending_alarms_t;
 
@@ -74,11 +78,20 @@ struct alarm_context_s {
     /* Alarm list.  */
     struct alarm_s *alarms;
 
-    /* Pending alarm array.  Statically allocated because it's slightly
-       faster this way.  */
+    /* Pending alarm array, kept as a binary min-heap ordered by clock so
+       that the next alarm to dispatch is always at index 0.  Statically
+       allocated because it's slightly faster this way.  */
     pending_alarms_t pending_alarms[ALARM_CONTEXT_MAX_PENDING_ALARMS];
     unsigned int num_pending_alarms;
 
+    /* The pending alarms in the order they were set in, except that an
+       unset alarm is replaced by the last one.  Of the alarms with the
+       same clock, the one in the highest slot is dispatched first, and
+       the next pending alarm is only replaced by an earlier one or when
+       it is set or unset itself.  This is the order in which the pending
+       alarms used to be scanned, which the emulation may depend on.  */
+    alarm_t *pending_slots[ALARM_CONTEXT_MAX_PENDING_ALARMS];
+
     /* Clock tick for the next pending alarm.  */
     CLOCK next_pending_alarm_clk;
 
@@ -111,23 +124,80 @@ inline static CLOCK alarm_context_next_pending_clk(alarm_context_t *context)
 
 inline static void alarm_context_update_next_pending(alarm_context_t *context)
 {
-    CLOCK next_pending_alarm_clk = (CLOCK)~0L;
-    int next_pending_alarm_idx;
-    unsigned int i;
+    if (context->num_pending_alarms > 0) {
+        context->next_pending_alarm_clk = context->pending_alarms[0].clk;
+        context->next_pending_alarm_idx = 0;
+    } else {
+        context->next_pending_alarm_clk = (CLOCK)~0L;
+        context->next_pending_alarm_idx = -1;
+    }
+}
+
+/* Return nonzero if heap entry `a' is dispatched before `b'.  */
+inline static int alarm_context_before(const pending_alarms_t *a,
+                                       const pending_alarms_t *b)
+{
+    return a->clk < b->clk || (a->clk == b->clk && a->slot > b->slot);
+}
 
-    next_pending_alarm_idx = context->next_pending_alarm_idx;
+/* Move the heap entry at `idx' towards the leaves until none of its
+   children is dispatched before it.  */
+inline static void alarm_context_sift_down(alarm_context_t *context, int idx)
+{
+    pending_alarms_t *heap = context->pending_alarms;
+    int num = (int)(context->num_pending_alarms);
+    pending_alarms_t entry = heap[idx];
 
-    for (i = 0; i < context->num_pending_alarms; i++) {
-        CLOCK pending_clk = context->pending_alarms[i].clk;
+    for (;;) {
+        int child = (idx << 1) + 1;
 
-        if (pending_clk <= next_pending_alarm_clk) {
-            next_pending_alarm_clk = pending_clk;
-            next_pending_alarm_idx = (int)i;
+        if (child >= num) {
+            break;
+        }
+        if (child + 1 < num
+            && alarm_context_before(&heap[child + 1], &heap[child])) {
+            child++;
         }
+        if (!alarm_context_before(&heap[child], &entry)) {
+            break;
+        }
+        heap[idx] = heap[child];
+        heap[idx].alarm->pending_idx = idx;
+        idx = child;
     }
 
-    context->next_pending_alarm_clk = next_pending_alarm_clk;
-    context->next_pending_alarm_idx = next_pending_alarm_idx;
+    heap[idx] = entry;
+    entry.alarm->pending_idx = idx;
+}
+
+/* Move the heap entry at `idx' towards the root until its parent is not
+   dispatched after it.  The next pending alarm at the root is only
+   replaced by an earlier one, and is then moved down to its place.  */
+inline static void alarm_context_sift_up(alarm_context_t *context, int idx)
+{
+    pending_alarms_t *heap = context->pending_alarms;
+    pending_alarms_t entry = heap[idx];
+
+    while (idx > 0) {
+        int parent = (idx - 1) >> 1;
+
+        if (parent == 0 ? heap[0].clk <= entry.clk
+                        : !alarm_context_before(&entry, &heap[parent])) {
+            break;
+        }
+        heap[idx] = heap[parent];
+        heap[idx].alarm->pending_idx = idx;
+        if (parent == 0) {
+            heap[0] = entry;
+            entry.alarm->pending_idx = 0;
+            alarm_context_sift_down(context, idx);
+            return;
+        }
+        idx = parent;
+    }
+
+    heap[idx] = entry;
+    entry.alarm->pending_idx = idx;
 }
 
 inline static void alarm_context_dispatch(alarm_context_t *context,
@@ -142,7 +212,9 @@ inline static void alarm_context_dispatch(alarm_context_t *context,
     idx = context->next_pending_alarm_idx;
     alarm = context->pending_alarms[idx].alarm;
 
+    BENCHMARK_ENTER(BENCHMARK_ALARMS);
     (alarm->callback)(offset, alarm->data);
+    BENCHMARK_LEAVE();
 }
 
 inline static void alarm_set(alarm_t *alarm, CLOCK cpu_clk)
@@ -166,24 +238,28 @@ inline static void alarm_set(alarm_t *alarm, CLOCK cpu_clk)
 
         context->pending_alarms[new_idx].alarm = alarm;
         context->pending_alarms[new_idx].clk = cpu_clk;
+        context->pending_alarms[new_idx].slot = new_idx;
+        context->pending_slots[new_idx] = alarm;
 
         context->num_pending_alarms++;
 
-        if (cpu_clk < context->next_pending_alarm_clk) {
-            context->next_pending_alarm_clk = cpu_clk;
-            context->next_pending_alarm_idx = new_idx;
-        }
-
-        alarm->pending_idx = new_idx;
+        alarm_context_sift_up(context, new_idx);
     } else {
+        CLOCK old_clk;
+
         /* Already pending: modify.  */
 
+        old_clk = context->pending_alarms[idx].clk;
         context->pending_alarms[idx].clk = cpu_clk;
-        if (context->next_pending_alarm_clk > cpu_clk
-            || idx == context->next_pending_alarm_idx) {
-            alarm_context_update_next_pending(context);
+
+        if (idx != 0 && cpu_clk < old_clk) {
+            alarm_context_sift_up(context, idx);
+        } else if (cpu_clk != old_clk || idx == 0) {
+            alarm_context_sift_down(context, idx);
         }
     }
+
+    alarm_context_update_next_pending(context);
 }
 
 #endif
@@ -0,0 +1,572 @@
+/*
+ * alarmbench.c - Replay alarm traces on the pending alarm heap.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/* Run by `make check'.  Replays traces of alarm operations with the
+   pending alarm heap of alarm.c and with a linear scan over the pending
+   alarms, as alarm.c used to do, and prints the operations per second of
+   each.  Fails if either dispatches an alarm other than the one recorded
+   in the trace.
+
+   The traces given on the command line are replayed, or else one that is
+   recorded here from a model of the alarms of a C64 and its drive, with
+   the linear scan.  With `-o <file>' that trace is also written out.  A
+   trace is a text file with one operation per line:
+
+     n <alarms>           number of alarms, on the first line
+     s <alarm> <clk>      set <alarm> (from 0) to <clk>
+     u <alarm>            unset <alarm>
+     d <clk> <alarm>      dispatch at CPU clock <clk>, which must be
+                          <alarm>; what its callback did follows
+
+   alarm.c is included here to get the inline functions of alarm.h with
+   the same compiler flags.  */
+
+#include "alarm.c"
+
+#include <string.h>
+#include <time.h>
+
+#define ALARMBENCH_MAX_ALARMS  ALARM_CONTEXT_MAX_PENDING_ALARMS
+
+/* Emulated cycles of the recorded trace.  */
+#define ALARMBENCH_CYCLES      4000000
+
+/* Host seconds each replay is repeated for at least.  */
+#define ALARMBENCH_SECONDS     0.5
+
+int benchmark_enabled = 0;
+
+void benchmark_enter(int subsystem)
+{
+}
+
+void benchmark_leave(void)
+{
+}
+
+#ifdef LIB_DEBUG_PINPOINT
+void *lib_malloc_pinpoint(size_t size, const char *name, unsigned int line)
+{
+    return malloc(size);
+}
+
+void lib_free_pinpoint(const void *p, const char *name, unsigned int line)
+{
+    free((void *)p);
+}
+
+char *lib_stralloc_pinpoint(const char *str, const char *name, unsigned int line)
+{
+    return strcpy(malloc(strlen(str) + 1), str);
+}
+#else
+void *lib_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+void lib_free(const void *ptr)
+{
+    free((void *)ptr);
+}
+
+char *lib_stralloc(const char *str)
+{
+    return strcpy(malloc(strlen(str) + 1), str);
+}
+#endif
+
+int log_error(log_t log, const char *format, ...)
+{
+    printf("%s\n", format);
+    return 0;
+}
+
+/* ------------------------------------------------------------------------- */
+
+typedef struct alarmbench_op_s {
+    char op;
+    int alarm;
+    CLOCK clk;
+} alarmbench_op_t;
+
+typedef struct alarmbench_trace_s {
+    const char *name;
+    int num_alarms;
+    alarmbench_op_t *ops;
+    int num_ops;
+    int max_ops;
+} alarmbench_trace_t;
+
+static void trace_add(alarmbench_trace_t *trace, char op, int alarm, CLOCK clk)
+{
+    if (trace->num_ops == trace->max_ops) {
+        trace->max_ops = trace->max_ops ? trace->max_ops * 2 : 0x10000;
+        trace->ops = realloc(trace->ops,
+                             trace->max_ops * sizeof(alarmbench_op_t));
+    }
+    trace->ops[trace->num_ops].op = op;
+    trace->ops[trace->num_ops].alarm = alarm;
+    trace->ops[trace->num_ops].clk = clk;
+    trace->num_ops++;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* The linear scan, kept in its own arrays.  */
+
+static int ref_pending_idx[ALARMBENCH_MAX_ALARMS];
+static int ref_pending_alarm[ALARMBENCH_MAX_ALARMS];
+static CLOCK ref_pending_clk[ALARMBENCH_MAX_ALARMS];
+static unsigned int ref_num_pending;
+static CLOCK ref_next_clk;
+static int ref_next_idx;
+
+static void ref_init(int num_alarms)
+{
+    int i;
+
+    for (i = 0; i < num_alarms; i++) {
+        ref_pending_idx[i] = -1;
+    }
+    ref_num_pending = 0;
+    ref_next_clk = (CLOCK)~0L;
+    ref_next_idx = -1;
+}
+
+static void ref_update_next_pending(void)
+{
+    CLOCK next_clk = (CLOCK)~0L;
+    int next_idx = ref_next_idx;
+    unsigned int i;
+
+    for (i = 0; i < ref_num_pending; i++) {
+        if (ref_pending_clk[i] <= next_clk) {
+            next_clk = ref_pending_clk[i];
+            next_idx = (int)i;
+        }
+    }
+
+    ref_next_clk = next_clk;
+    ref_next_idx = next_idx;
+}
+
+static void ref_set(int alarm, CLOCK clk)
+{
+    int idx = ref_pending_idx[alarm];
+
+    if (idx < 0) {
+        idx = (int)(ref_num_pending++);
+        ref_pending_alarm[idx] = alarm;
+        ref_pending_clk[idx] = clk;
+        if (clk < ref_next_clk) {
+            ref_next_clk = clk;
+            ref_next_idx = idx;
+        }
+        ref_pending_idx[alarm] = idx;
+    } else {
+        ref_pending_clk[idx] = clk;
+        if (ref_next_clk > clk || idx == ref_next_idx) {
+            ref_update_next_pending();
+        }
+    }
+}
+
+static void ref_unset(int alarm)
+{
+    int idx = ref_pending_idx[alarm];
+    int last;
+
+    if (idx < 0) {
+        return;
+    }
+
+    if (ref_num_pending > 1) {
+        last = (int)(--ref_num_pending);
+        if (last != idx) {
+            ref_pending_alarm[idx] = ref_pending_alarm[last];
+            ref_pending_clk[idx] = ref_pending_clk[last];
+            ref_pending_idx[ref_pending_alarm[idx]] = idx;
+        }
+        if (ref_next_idx == idx) {
+            ref_update_next_pending();
+        } else if (ref_next_idx == last) {
+            ref_next_idx = idx;
+        }
+    } else {
+        ref_num_pending = 0;
+        ref_next_clk = (CLOCK)~0L;
+        ref_next_idx = -1;
+    }
+
+    ref_pending_idx[alarm] = -1;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Record a trace with the linear scan.  The model has a raster alarm
+   every line, timers that run continuously, are reprogrammed or stopped
+   now and then, and one-shot alarms.  Many of the periods are multiples
+   of the line length, so alarms often fall on the same clock.  */
+
+#define MODEL_RASTER    0
+#define MODEL_TIMERS    1
+#define MODEL_NUM_TIMERS 8
+#define MODEL_ONESHOTS  (MODEL_TIMERS + MODEL_NUM_TIMERS)
+#define MODEL_NUM_ONESHOTS 8
+#define MODEL_ALARMS    (MODEL_ONESHOTS + MODEL_NUM_ONESHOTS)
+
+#define MODEL_LINE      63
+
+static uint32_t seed = 1;
+
+/* Fixed sequence, so the trace is the same on every run.  */
+static uint32_t model_random(void)
+{
+    seed = seed * 1103515245 + 12345;
+    return seed >> 8;
+}
+
+static CLOCK model_period[MODEL_ALARMS];
+
+static CLOCK model_new_period(void)
+{
+    if (model_random() & 1) {
+        return MODEL_LINE * (1 + model_random() % 40);
+    }
+    return 1 + model_random() % 5000;
+}
+
+static void model_set(alarmbench_trace_t *trace, int alarm, CLOCK clk)
+{
+    ref_set(alarm, clk);
+    trace_add(trace, 's', alarm, clk);
+}
+
+static void model_unset(alarmbench_trace_t *trace, int alarm)
+{
+    ref_unset(alarm);
+    trace_add(trace, 'u', alarm, 0);
+}
+
+static void model_record(alarmbench_trace_t *trace)
+{
+    CLOCK clk = 0, alarm_clk;
+    int i, alarm;
+
+    trace->name = "C64 model";
+    trace->num_alarms = MODEL_ALARMS;
+    ref_init(MODEL_ALARMS);
+
+    model_set(trace, MODEL_RASTER, MODEL_LINE);
+    for (i = MODEL_TIMERS; i < MODEL_ONESHOTS; i++) {
+        model_period[i] = model_new_period();
+        model_set(trace, i, model_period[i]);
+    }
+
+    while (clk < ALARMBENCH_CYCLES) {
+        /* One instruction.  */
+        clk += 2 + model_random() % 6;
+
+        while (ref_next_clk <= clk) {
+            alarm = ref_pending_alarm[ref_next_idx];
+            alarm_clk = ref_next_clk;
+            trace_add(trace, 'd', alarm, clk);
+
+            if (alarm == MODEL_RASTER) {
+                model_set(trace, alarm, alarm_clk + MODEL_LINE);
+            } else if (alarm < MODEL_ONESHOTS && model_period[alarm] != 0) {
+                model_set(trace, alarm, alarm_clk + model_period[alarm]);
+            } else {
+                model_unset(trace, alarm);
+            }
+        }
+
+        /* Now and then, a timer is reprogrammed or stopped, or a one-shot
+           alarm is set, often on the clock of another pending alarm.  */
+        if (model_random() % 64 == 0) {
+            alarm = MODEL_TIMERS
+                    + (int)(model_random() % (MODEL_NUM_TIMERS
+                                              + MODEL_NUM_ONESHOTS));
+            if (alarm < MODEL_ONESHOTS && model_random() % 4 == 0) {
+                model_period[alarm] = 0;
+                model_unset(trace, alarm);
+                continue;
+            }
+            if (alarm < MODEL_ONESHOTS) {
+                model_period[alarm] = model_new_period();
+            }
+            if (ref_num_pending > 0 && (model_random() & 1)) {
+                alarm_clk = ref_pending_clk[model_random() % ref_num_pending];
+            } else {
+                alarm_clk = clk + 1 + model_random() % (MODEL_LINE * 4);
+            }
+            model_set(trace, alarm, alarm_clk);
+        }
+    }
+}
+
+/* ------------------------------------------------------------------------- */
+
+static int trace_read(alarmbench_trace_t *trace, const char *name)
+{
+    FILE *f;
+    char op;
+    int alarm, n, line = 1;
+    unsigned long clk;
+
+    f = fopen(name, "r");
+    if (f == NULL) {
+        printf("%s: cannot open.\n", name);
+        return -1;
+    }
+
+    trace->name = name;
+    if (fscanf(f, " n %d", &trace->num_alarms) != 1
+        || trace->num_alarms <= 0
+        || trace->num_alarms > ALARMBENCH_MAX_ALARMS) {
+        printf("%s:1: bad number of alarms.\n", name);
+        fclose(f);
+        return -1;
+    }
+
+    while (fscanf(f, " %c", &op) == 1) {
+        line++;
+        alarm = 0;
+        clk = 0;
+        switch (op) {
+            case 's':
+                n = fscanf(f, "%d %lu", &alarm, &clk) == 2;
+                break;
+            case 'u':
+                n = fscanf(f, "%d", &alarm) == 1;
+                break;
+            case 'd':
+                n = fscanf(f, "%lu %d", &clk, &alarm) == 2;
+                break;
+            default:
+                n = 0;
+                break;
+        }
+        if (!n || alarm < 0 || alarm >= trace->num_alarms) {
+            printf("%s:%d: bad operation.\n", name, line);
+            fclose(f);
+            return -1;
+        }
+        trace_add(trace, op, alarm, (CLOCK)clk);
+    }
+
+    fclose(f);
+    return 0;
+}
+
+static int trace_write(const alarmbench_trace_t *trace, const char *name)
+{
+    FILE *f;
+    int i;
+
+    f = fopen(name, "w");
+    if (f == NULL) {
+        printf("%s: cannot create.\n", name);
+        return -1;
+    }
+
+    fprintf(f, "n %d\n", trace->num_alarms);
+    for (i = 0; i < trace->num_ops; i++) {
+        const alarmbench_op_t *op = &trace->ops[i];
+
+        switch (op->op) {
+            case 's':
+                fprintf(f, "s %d %lu\n", op->alarm, (unsigned long)op->clk);
+                break;
+            case 'u':
+                fprintf(f, "u %d\n", op->alarm);
+                break;
+            default:
+                fprintf(f, "d %lu %d\n", (unsigned long)op->clk, op->alarm);
+                break;
+        }
+    }
+
+    return fclose(f) == 0 ? 0 : -1;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static alarm_t *dispatched;
+
+static void replay_callback(CLOCK offset, void *data)
+{
+    dispatched = data;
+}
+
+/* Replay `trace' with the heap.  Return the index of the first dispatch
+   that differs from the trace, or -1.  */
+static int replay_heap(const alarmbench_trace_t *trace, alarm_t **alarms,
+                       alarm_context_t *context)
+{
+    int i;
+
+    for (i = 0; i < trace->num_ops; i++) {
+        const alarmbench_op_t *op = &trace->ops[i];
+
+        switch (op->op) {
+            case 's':
+                alarm_set(alarms[op->alarm], op->clk);
+                break;
+            case 'u':
+                alarm_unset(alarms[op->alarm]);
+                break;
+            default:
+                if (alarm_context_next_pending_clk(context) > op->clk) {
+                    return i;
+                }
+                alarm_context_dispatch(context, op->clk);
+                if (dispatched != alarms[op->alarm]) {
+                    return i;
+                }
+                break;
+        }
+    }
+
+    return -1;
+}
+
+/* Replay `trace' with the linear scan.  */
+static int replay_ref(const alarmbench_trace_t *trace)
+{
+    int i;
+
+    for (i = 0; i < trace->num_ops; i++) {
+        const alarmbench_op_t *op = &trace->ops[i];
+
+        switch (op->op) {
+            case 's':
+                ref_set(op->alarm, op->clk);
+                break;
+            case 'u':
+                ref_unset(op->alarm);
+                break;
+            default:
+                if (ref_next_clk > op->clk
+                    || ref_pending_alarm[ref_next_idx] != op->alarm) {
+                    return i;
+                }
+                break;
+        }
+    }
+
+    return -1;
+}
+
+static double elapsed(clock_t start)
+{
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+static int bench(const alarmbench_trace_t *trace)
+{
+    alarm_context_t *context;
+    alarm_t *alarms[ALARMBENCH_MAX_ALARMS];
+    clock_t start;
+    double seconds = 0, ref_seconds = 0, ops;
+    int i, runs, ref_runs, heap_failed = -1, ref_failed = -1;
+
+    context = alarm_context_new("Bench");
+    for (i = 0; i < trace->num_alarms; i++) {
+        alarms[i] = alarm_new(context, "Bench", replay_callback, NULL);
+        alarms[i]->data = alarms[i];
+    }
+
+    start = clock();
+    runs = 0;
+    do {
+        for (i = 0; i < trace->num_alarms; i++) {
+            alarm_unset(alarms[i]);
+        }
+        heap_failed = replay_heap(trace, alarms, context);
+        runs++;
+    } while (heap_failed < 0 && (seconds = elapsed(start)) < ALARMBENCH_SECONDS);
+
+    start = clock();
+    ref_runs = 0;
+    do {
+        ref_init(trace->num_alarms);
+        ref_failed = replay_ref(trace);
+        ref_runs++;
+    } while (ref_failed < 0 && (ref_seconds = elapsed(start)) < ALARMBENCH_SECONDS);
+
+    alarm_context_destroy(context);
+
+    if (heap_failed >= 0 || ref_failed >= 0) {
+        i = heap_failed >= 0 ? heap_failed : ref_failed;
+        printf("%s: the %s dispatches another alarm than alarm %d at operation %d.\n",
+               trace->name, heap_failed >= 0 ? "heap" : "linear scan",
+               trace->ops[i].alarm, i + 1);
+        return 1;
+    }
+
+    ops = (double)trace->num_ops;
+    printf("%s: %d alarms, %d operations, dispatch order as recorded.\n",
+           trace->name, trace->num_alarms, trace->num_ops);
+    printf("%s: heap %.0f, linear scan %.0f operations per second.\n",
+           trace->name,
+           seconds > 0 ? ops * runs / seconds : 0,
+           ref_seconds > 0 ? ops * ref_runs / ref_seconds : 0);
+
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    alarmbench_trace_t trace;
+    const char *output = NULL;
+    int i, failed = 0, replayed = 0;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            output = argv[++i];
+            continue;
+        }
+        memset(&trace, 0, sizeof(trace));
+        if (trace_read(&trace, argv[i]) < 0) {
+            failed = 1;
+        } else {
+            failed |= bench(&trace);
+        }
+        free(trace.ops);
+        replayed = 1;
+    }
+
+    if (!replayed) {
+        memset(&trace, 0, sizeof(trace));
+        model_record(&trace);
+        if (output != NULL && trace_write(&trace, output) < 0) {
+            failed = 1;
+        }
+        failed |= bench(&trace);
+        free(trace.ops);
+    }
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -440,6 +440,8 @@ void video_canvas_refresh(video_canvas_t *canvas, unsigned int xs, unsigned int
 /* Window got a WM_PAINT and needs a refresh */
 void video_canvas_update(HWND hwnd, HDC hdc, int xclient, int yclient, int w, int h)
 {
+    videothread_sync();
+
     if (video_dx9_enabled()) {
         video_canvas_update_dx9(hwnd, hdc, xclient, yclient, w, h);
     } else {
@@ -48,6 +48,7 @@
 #include "datasette.h"
 #include "drive.h"
 #include "fileio.h"
+#include "forkserver.h"
 #include "fsdevice.h"
 #include "imagecontents.h"
 #include "tapecontents.h"
@@ -662,6 +663,8 @@ static void autostart_done(void)
 {
     autostartmode = AUTOSTART_DONE;
 
+    forkserver_autostart_done();
+
     if (machine_class == VICE_MACHINE_C128) {
         /* restore original state of key */
         resources_set_int("C128ColumnKey", c128_column4080_key);
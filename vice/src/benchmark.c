@@ -0,0 +1,283 @@
+/*
+ * benchmark.c - Measure the emulation speed per subsystem.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/* With `-benchmark <file>' the emulator runs in warp mode with the dummy
+   sound device until the cycle limit (`-limitcycles') is reached, and then
+   writes the emulation speed to <file> as JSON and exits.  The host time
+   is split up between the subsystems with BENCHMARK_ENTER() and
+   BENCHMARK_LEAVE() around their entry points: the time between two of
+   these calls is accounted to the innermost subsystem entered, so a
+   subsystem's time does not include the subsystems it calls.  Everything
+   that happens inside the drive CPUs is counted as drive time, and only
+   the main thread is measured.  benchmark/run.sh runs the same program
+   on each machine with it.  */
+
+#include "vice.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "archdep.h"
+#include "benchmark.h"
+#include "clkguard.h"
+#include "cmdline.h"
+#include "lib.h"
+#include "log.h"
+#include "machine.h"
+#include "maincpu.h"
+#include "resources.h"
+#include "translate.h"
+#include "types.h"
+#include "video.h"
+#include "vsync.h"
+#include "vsyncapi.h"
+
+#ifdef USE_WORKER_THREADS
+#include <pthread.h>
+#endif
+
+/* Emulated seconds to run if no cycle limit is given.  */
+#define BENCHMARK_DEFAULT_SECONDS  10
+
+/* Maximum nesting of subsystems.  */
+#define BENCHMARK_DEPTH  16
+
+typedef struct benchmark_counter_s {
+    const char *name;
+    unsigned long time;
+    unsigned long calls;
+} benchmark_counter_t;
+
+int benchmark_enabled = 0;
+
+static char *benchmark_file = NULL;
+
+static benchmark_counter_t counters[BENCHMARK_NUM] = {
+    { "maincpu", 0, 0 },
+    { "alarms", 0, 0 },
+    { "video", 0, 0 },
+    { "sound", 0, 0 },
+    { "drives", 0, 0 },
+    { "vsync", 0, 0 },
+};
+
+/* Subsystems entered, the innermost one last.  */
+static int stack[BENCHMARK_DEPTH];
+static int depth = 0;
+
+/* Number of BENCHMARK_ENTER() calls that have not been accounted, because
+   they happened inside the drive CPUs.  */
+static int nested = 0;
+
+/* Host time when main_program() was entered.  */
+static unsigned long program_time;
+
+static unsigned long start_time;
+static unsigned long last_time;
+static int start_frame;
+
+/* Cycles subtracted from maincpu_clk by the clock guard.  */
+static unsigned long cycles_base = 0;
+
+#ifdef USE_WORKER_THREADS
+static pthread_t main_thread;
+
+#define BENCHMARK_MAIN_THREAD() pthread_equal(pthread_self(), main_thread)
+#else
+#define BENCHMARK_MAIN_THREAD() 1
+#endif
+
+void benchmark_enter(int subsystem)
+{
+    unsigned long now;
+
+    if (!BENCHMARK_MAIN_THREAD() || depth == 0) {
+        return;
+    }
+
+    if (nested > 0 || stack[depth - 1] == BENCHMARK_DRIVES
+        || depth == BENCHMARK_DEPTH) {
+        nested++;
+        return;
+    }
+
+    now = vsyncarch_gettime();
+    counters[stack[depth - 1]].time += now - last_time;
+    last_time = now;
+
+    stack[depth++] = subsystem;
+    counters[subsystem].calls++;
+}
+
+void benchmark_leave(void)
+{
+    unsigned long now;
+
+    if (!BENCHMARK_MAIN_THREAD() || depth <= 1) {
+        return;
+    }
+
+    if (nested > 0) {
+        nested--;
+        return;
+    }
+
+    now = vsyncarch_gettime();
+    counters[stack[--depth]].time += now - last_time;
+    last_time = now;
+}
+
+static void clk_overflow_callback(CLOCK sub, void *data)
+{
+    cycles_base += sub;
+}
+
+/* Called first thing in main_program(), to measure the startup time.  */
+void benchmark_init(void)
+{
+    program_time = vsyncarch_gettime();
+}
+
+/* Called right before the main CPU starts.  */
+void benchmark_start(void)
+{
+    if (!benchmark_enabled) {
+        return;
+    }
+
+    if (maincpu_clk_limit == 0) {
+        maincpu_clk_limit = (CLOCK)(machine_get_cycles_per_second()
+                                    * BENCHMARK_DEFAULT_SECONDS);
+    }
+
+    clk_guard_add_callback(maincpu_clk_guard, clk_overflow_callback, NULL);
+
+#ifdef USE_WORKER_THREADS
+    main_thread = pthread_self();
+#endif
+    stack[0] = BENCHMARK_MAINCPU;
+    depth = 1;
+    start_frame = vsync_frame_counter;
+    start_time = last_time = vsyncarch_gettime();
+}
+
+static void benchmark_write(FILE *f, double seconds, unsigned long cycles)
+{
+    double freq = (double)vsyncarch_frequency();
+    double cycles_per_second = seconds > 0.0 ? cycles / seconds : 0.0;
+    videothread_stats_t video;
+    int i;
+
+    videothread_get_stats(&video);
+
+    fprintf(f, "{\n");
+    fprintf(f, "  \"machine\": \"%s\",\n", machine_get_name());
+    fprintf(f, "  \"startup_seconds\": %.6f,\n",
+            (start_time - program_time) / freq);
+    fprintf(f, "  \"cycles\": %lu,\n", cycles);
+    fprintf(f, "  \"frames\": %d,\n", vsync_frame_counter - start_frame);
+    fprintf(f, "  \"seconds\": %.6f,\n", seconds);
+    fprintf(f, "  \"cycles_per_second\": %.0f,\n", cycles_per_second);
+    fprintf(f, "  \"speed_percent\": %.2f,\n",
+            cycles_per_second * 100.0 / machine_get_cycles_per_second());
+    fprintf(f, "  \"subsystems\": {\n");
+    for (i = 0; i < BENCHMARK_NUM; i++) {
+        fprintf(f, "    \"%s\": { \"seconds\": %.6f, \"calls\": %lu }%s\n",
+                counters[i].name, counters[i].time / freq, counters[i].calls,
+                i < BENCHMARK_NUM - 1 ? "," : "");
+    }
+    fprintf(f, "  },\n");
+    fprintf(f, "  \"video_thread\": { \"presented\": %lu, \"dropped\": %lu, "
+            "\"latency_ms_average\": %.3f, \"latency_ms_max\": %.3f }\n",
+            video.presented, video.dropped, video.latency_average,
+            video.latency_max);
+    fprintf(f, "}\n");
+}
+
+/* Called when the cycle limit has been reached.  Write the results and
+   exit if in benchmark mode, return otherwise.  */
+void benchmark_finish(void)
+{
+    unsigned long now;
+    unsigned long cycles;
+    FILE *f;
+
+    if (!benchmark_enabled || depth == 0) {
+        return;
+    }
+
+    now = vsyncarch_gettime();
+    counters[stack[depth - 1]].time += now - last_time;
+    benchmark_enabled = 0;
+
+    cycles = cycles_base + maincpu_clk;
+
+    if (strcmp(benchmark_file, "-") == 0) {
+        f = stdout;
+    } else {
+        f = fopen(benchmark_file, MODE_WRITE_TEXT);
+        if (f == NULL) {
+            log_error(LOG_DEFAULT, "Cannot write benchmark results to `%s'.",
+                      benchmark_file);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    benchmark_write(f, (double)(now - start_time) / vsyncarch_frequency(),
+                    cycles);
+
+    if (f != stdout) {
+        fclose(f);
+    } else {
+        fflush(f);
+    }
+
+    exit(EXIT_SUCCESS);
+}
+
+static int cmdline_benchmark(const char *param, void *extra_param)
+{
+    lib_free(benchmark_file);
+    benchmark_file = lib_stralloc(param);
+    benchmark_enabled = 1;
+
+    resources_set_int("WarpMode", 1);
+    resources_set_string("SoundDeviceName", "dummy");
+
+    return 0;
+}
+
+static const cmdline_option_t cmdline_options[] = {
+    { "-benchmark", CALL_FUNCTION, 1,
+      cmdline_benchmark, NULL, NULL, NULL,
+      USE_PARAM_STRING, USE_DESCRIPTION_STRING,
+      IDCLS_UNUSED, IDCLS_UNUSED,
+      "<file>", "Run at full speed until the cycle limit and write the speed per subsystem to <file> (- for stdout) as JSON" },
+    CMDLINE_LIST_END
+};
+
+int benchmark_cmdline_options_init(void)
+{
+    return cmdline_register_options(cmdline_options);
+}
@@ -0,0 +1,63 @@
+/*
+ * benchmark.h - Measure the emulation speed per subsystem.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#ifndef VICE_BENCHMARK_H
+#define VICE_BENCHMARK_H
+
+/* Subsystems the host time is accounted to.  Everything not covered by
+   one of the others is counted as main CPU time.  */
+#define BENCHMARK_MAINCPU   0
+#define BENCHMARK_ALARMS    1
+#define BENCHMARK_VIDEO     2
+#define BENCHMARK_SOUND     3
+#define BENCHMARK_DRIVES    4
+#define BENCHMARK_VSYNC     5
+#define BENCHMARK_NUM       6
+
+extern int benchmark_enabled;
+
+extern void benchmark_enter(int subsystem);
+extern void benchmark_leave(void);
+
+/* Account the host time until the matching BENCHMARK_LEAVE() to
+   `subsystem'.  */
+#define BENCHMARK_ENTER(subsystem)        \
+    do {                                  \
+        if (benchmark_enabled) {          \
+            benchmark_enter(subsystem);   \
+        }                                 \
+    } while (0)
+
+#define BENCHMARK_LEAVE()                 \
+    do {                                  \
+        if (benchmark_enabled) {          \
+            benchmark_leave();            \
+        }                                 \
+    } while (0)
+
+extern int benchmark_cmdline_options_init(void);
+extern void benchmark_init(void);
+extern void benchmark_start(void);
+extern void benchmark_finish(void);
+
+#endif
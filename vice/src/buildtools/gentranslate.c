@@ -150,6 +150,7 @@ void generate_translate_h(char *in_filename, char *out_filename)
             }
         }
     }
+    fprintf(outfile, "ID_END\n");
     fprintf(outfile, "};\n");
     fprintf(outfile, "#endif\n");
 
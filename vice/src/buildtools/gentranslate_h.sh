@@ -153,5 +153,6 @@ else
   done
 fi
 
+echo "ID_END"
 echo "};"
 echo "#endif"
@@ -955,7 +955,15 @@ static int lookup_and_execute_command(int nargs, char **args)
             fprintf(stderr, "syntax: %s\n", cp->syntax);
             return -1;
         } else {
-            int retval;
+            int retval, i;
+
+            /* Some commands open the image file by name, so write back
+               what the previous command changed.  */
+            for (i = 0; i < DRIVE_COUNT; i++) {
+                if (drives[i] != NULL) {
+                    disk_image_sync(drives[i]->image);
+                }
+            }
 
             retval = command_list[match].func(nargs, args);
             print_error_message(retval);
@@ -4679,6 +4687,14 @@ int main(int argc, char **argv)
         drives[i] = lib_calloc(1, sizeof *drives[i]);
     }
 
+    /* In batch mode, keep the images in memory and write them back after
+       each command.  */
+    for (i = 1; i < argc && *argv[i] != '-'; i++) {
+    }
+    if (i < argc) {
+        disk_image_write_back_set(INT_MAX);
+    }
+
     /* The first arguments without leading `-' are interpreted as disk images
        to attach.  */
     for (i = 1; i < argc && *argv[i] != '-'; i++) {
@@ -77,6 +77,47 @@ static io_source_list_t c64io_d700_head = { NULL, NULL, NULL };
 static io_source_list_t c64io_de00_head = { NULL, NULL, NULL };
 static io_source_list_t c64io_df00_head = { NULL, NULL, NULL };
 
+/* For each address of a page, the devices that can be read and stored to
+   there.  If there is only one, it is called directly; otherwise the list
+   is walked to handle priorities and collisions.  Rebuilt whenever a
+   device of the page is registered or unregistered.  */
+typedef struct io_source_entry_s {
+    io_source_t *read;
+    io_source_t *store;
+    uint8_t reads;
+    uint8_t stores;
+} io_source_entry_t;
+
+static io_source_entry_t c64io_d000_table[0x100];
+static io_source_entry_t c64io_d100_table[0x100];
+static io_source_entry_t c64io_d200_table[0x100];
+static io_source_entry_t c64io_d300_table[0x100];
+static io_source_entry_t c64io_d400_table[0x100];
+static io_source_entry_t c64io_d500_table[0x100];
+static io_source_entry_t c64io_d600_table[0x100];
+static io_source_entry_t c64io_d700_table[0x100];
+static io_source_entry_t c64io_de00_table[0x100];
+static io_source_entry_t c64io_df00_table[0x100];
+
+typedef struct c64io_page_s {
+    uint16_t base;
+    io_source_list_t *head;
+    io_source_entry_t *table;
+} c64io_page_t;
+
+static c64io_page_t c64io_pages[] = {
+    { 0xd000, &c64io_d000_head, c64io_d000_table },
+    { 0xd100, &c64io_d100_head, c64io_d100_table },
+    { 0xd200, &c64io_d200_head, c64io_d200_table },
+    { 0xd300, &c64io_d300_head, c64io_d300_table },
+    { 0xd400, &c64io_d400_head, c64io_d400_table },
+    { 0xd500, &c64io_d500_head, c64io_d500_table },
+    { 0xd600, &c64io_d600_head, c64io_d600_table },
+    { 0xd700, &c64io_d700_head, c64io_d700_table },
+    { 0xde00, &c64io_de00_head, c64io_de00_table },
+    { 0xdf00, &c64io_df00_head, c64io_df00_table },
+};
+
 static void io_source_detach(io_source_detach_t *source)
 {
     switch (source->det_id) {
@@ -292,8 +333,9 @@ static void io_source_log_collisions(uint16_t addr, int amount, io_source_list_t
     }
 }
 
-static inline uint8_t io_read(io_source_list_t *list, uint16_t addr)
+static inline uint8_t io_read(io_source_list_t *list, io_source_entry_t *table, uint16_t addr)
 {
+    io_source_entry_t *entry = &table[addr & 0xff];
     io_source_list_t *current = list->next;
     int io_source_counter = 0;
     int io_source_valid = 0;
@@ -304,6 +346,14 @@ static inline uint8_t io_read(io_source_list_t *list, uint16_t addr)
 
     vicii_handle_pending_alarms_external(0);
 
+    if (entry->reads == 0) {
+        return vicii_read_phi1();
+    }
+    if (entry->reads == 1) {
+        retval = entry->read->read((uint16_t)(addr & entry->read->address_mask));
+        return entry->read->io_source_valid ? retval : vicii_read_phi1();
+    }
+
     while (current) {
         if (current->device->read != NULL) {
             if ((addr >= current->device->start_address) && (addr <= current->device->end_address)) {
@@ -390,8 +440,9 @@ static inline uint8_t io_peek(io_source_list_t *list, uint16_t addr)
     return vicii_read_phi1();
 }
 
-static inline void io_store(io_source_list_t *list, uint16_t addr, uint8_t value)
+static inline void io_store(io_source_list_t *list, io_source_entry_t *table, uint16_t addr, uint8_t value)
 {
+    io_source_entry_t *entry = &table[addr & 0xff];
     int writes = 0;
     uint16_t addy = 0xffff;
     io_source_list_t *current = list->next;
@@ -399,6 +450,14 @@ static inline void io_store(io_source_list_t *list, uint16_t addr, uint8_t value
 
     vicii_handle_pending_alarms_external_write();
 
+    if (entry->stores == 0) {
+        return;
+    }
+    if (entry->stores == 1) {
+        entry->store->store((uint16_t)(addr & entry->store->address_mask), value);
+        return;
+    }
+
     while (current) {
         if (current->device->store != NULL) {
             if (addr >= current->device->start_address && addr <= current->device->end_address) {
@@ -422,45 +481,54 @@ static inline void io_store(io_source_list_t *list, uint16_t addr, uint8_t value
 
 /* ---------------------------------------------------------------------------------------------------------- */
 
+/* Rebuild the dispatch table of `page'.  */
+static void io_source_table_update(c64io_page_t *page)
+{
+    io_source_list_t *current;
+    io_source_entry_t *entry;
+    io_source_t *device;
+    unsigned int i, addr;
+
+    memset(page->table, 0, sizeof(io_source_entry_t) * 0x100);
+
+    for (current = page->head->next; current; current = current->next) {
+        device = current->device;
+        for (i = 0; i < 0x100; i++) {
+            addr = page->base + i;
+            if (addr < device->start_address || addr > device->end_address) {
+                continue;
+            }
+            entry = &page->table[i];
+            if (device->read != NULL && entry->reads < 0xff) {
+                if (entry->reads++ == 0) {
+                    entry->read = device;
+                }
+            }
+            if (device->store != NULL && entry->stores < 0xff) {
+                if (entry->stores++ == 0) {
+                    entry->store = device;
+                }
+            }
+        }
+    }
+}
+
 io_source_list_t *io_source_register(io_source_t *device)
 {
     io_source_list_t *current = NULL;
     io_source_list_t *retval = lib_malloc(sizeof(io_source_list_t));
+    c64io_page_t *page = NULL;
+    unsigned int i;
 
     assert(device != NULL);
     DBG(("IO: register id:%d name:%s\n", device->cart_id, device->name));
 
-    switch (device->start_address & 0xff00) {
-        case 0xd000:
-            current = &c64io_d000_head;
-            break;
-        case 0xd100:
-            current = &c64io_d100_head;
-            break;
-        case 0xd200:
-            current = &c64io_d200_head;
-            break;
-        case 0xd300:
-            current = &c64io_d300_head;
-            break;
-        case 0xd400:
-            current = &c64io_d400_head;
-            break;
-        case 0xd500:
-            current = &c64io_d500_head;
-            break;
-        case 0xd600:
-            current = &c64io_d600_head;
-            break;
-        case 0xd700:
-            current = &c64io_d700_head;
-            break;
-        case 0xde00:
-            current = &c64io_de00_head;
-            break;
-        case 0xdf00:
-            current = &c64io_df00_head;
+    for (i = 0; i < sizeof(c64io_pages) / sizeof(c64io_pages[0]); i++) {
+        if (c64io_pages[i].base == (device->start_address & 0xff00)) {
+            page = &c64io_pages[i];
+            current = page->head;
             break;
+        }
     }
 
     while (current->next != NULL) {
@@ -472,12 +540,16 @@ io_source_list_t *io_source_register(io_source_t *device)
     retval->next = NULL;
     retval->device->order = order++;
 
+    io_source_table_update(page);
+
     return retval;
 }
 
 void io_source_unregister(io_source_list_t *device)
 {
     io_source_list_t *prev;
+    io_source_list_t *head;
+    unsigned int i;
 
     assert(device != NULL);
     DBG(("IO: unregister id:%d name:%s\n", device->device->cart_id, device->device->name));
@@ -496,6 +568,15 @@ void io_source_unregister(io_source_list_t *device)
     }
 
     lib_free(device);
+
+    for (head = prev; head->previous != NULL; head = head->previous) {
+    }
+    for (i = 0; i < sizeof(c64io_pages) / sizeof(c64io_pages[0]); i++) {
+        if (c64io_pages[i].head == head) {
+            io_source_table_update(&c64io_pages[i]);
+            break;
+        }
+    }
 }
 
 void cartio_shutdown(void)
@@ -573,7 +654,7 @@ void cartio_set_highest_order(unsigned int nr)
 uint8_t c64io_d000_read(uint16_t addr)
 {
     DBGRW(("IO: io-d000 r %04x\n", addr));
-    return io_read(&c64io_d000_head, addr);
+    return io_read(&c64io_d000_head, c64io_d000_table, addr);
 }
 
 uint8_t c64io_d000_peek(uint16_t addr)
@@ -585,13 +666,13 @@ uint8_t c64io_d000_peek(uint16_t addr)
 void c64io_d000_store(uint16_t addr, uint8_t value)
 {
     DBGRW(("IO: io-d000 w %04x %02x\n", addr, value));
-    io_store(&c64io_d000_head, addr, value);
+    io_store(&c64io_d000_head, c64io_d000_table, addr, value);
 }
 
 uint8_t c64io_d100_read(uint16_t addr)
 {
     DBGRW(("IO: io-d100 r %04x\n", addr));
-    return io_read(&c64io_d100_head, addr);
+    return io_read(&c64io_d100_head, c64io_d100_table, addr);
 }
 
 uint8_t c64io_d100_peek(uint16_t addr)
@@ -603,13 +684,13 @@ uint8_t c64io_d100_peek(uint16_t addr)
 void c64io_d100_store(uint16_t addr, uint8_t value)
 {
     DBGRW(("IO: io-d100 w %04x %02x\n", addr, value));
-    io_store(&c64io_d100_head, addr, value);
+    io_store(&c64io_d100_head, c64io_d100_table, addr, value);
 }
 
 uint8_t c64io_d200_read(uint16_t addr)
 {
     DBGRW(("IO: io-d200 r %04x\n", addr));
-    return io_read(&c64io_d200_head, addr);
+    return io_read(&c64io_d200_head, c64io_d200_table, addr);
 }
 
 uint8_t c64io_d200_peek(uint16_t addr)
@@ -621,13 +702,13 @@ uint8_t c64io_d200_peek(uint16_t addr)
 void c64io_d200_store(uint16_t addr, uint8_t value)
 {
     DBGRW(("IO: io-d200 w %04x %02x\n", addr, value));
-    io_store(&c64io_d200_head, addr, value);
+    io_store(&c64io_d200_head, c64io_d200_table, addr, value);
 }
 
 uint8_t c64io_d300_read(uint16_t addr)
 {
     DBGRW(("IO: io-d300 r %04x\n", addr));
-    return io_read(&c64io_d300_head, addr);
+    return io_read(&c64io_d300_head, c64io_d300_table, addr);
 }
 
 uint8_t c64io_d300_peek(uint16_t addr)
@@ -639,13 +720,13 @@ uint8_t c64io_d300_peek(uint16_t addr)
 void c64io_d300_store(uint16_t addr, uint8_t value)
 {
     DBGRW(("IO: io-d300 w %04x %02x\n", addr, value));
-    io_store(&c64io_d300_head, addr, value);
+    io_store(&c64io_d300_head, c64io_d300_table, addr, value);
 }
 
 uint8_t c64io_d400_read(uint16_t addr)
 {
     DBGRW(("IO: io-d400 r %04x\n", addr));
-    return io_read(&c64io_d400_head, addr);
+    return io_read(&c64io_d400_head, c64io_d400_table, addr);
 }
 
 uint8_t c64io_d400_peek(uint16_t addr)
@@ -657,13 +738,13 @@ uint8_t c64io_d400_peek(uint16_t addr)
 void c64io_d400_store(uint16_t addr, uint8_t value)
 {
     DBGRW(("IO: io-d400 w %04x %02x\n", addr, value));
-    io_store(&c64io_d400_head, addr, value);
+    io_store(&c64io_d400_head, c64io_d400_table, addr, value);
 }
 
 uint8_t c64io_d500_read(uint16_t addr)
 {
     DBGRW(("IO: io-d500 r %04x\n", addr));
-    return io_read(&c64io_d500_head, addr);
+    return io_read(&c64io_d500_head, c64io_d500_table, addr);
 }
 
 uint8_t c64io_d500_peek(uint16_t addr)
@@ -675,13 +756,13 @@ uint8_t c64io_d500_peek(uint16_t addr)
 void c64io_d500_store(uint16_t addr, uint8_t value)
 {
     DBGRW(("IO: io-d500 w %04x %02x\n", addr, value));
-    io_store(&c64io_d500_head, addr, value);
+    io_store(&c64io_d500_head, c64io_d500_table, addr, value);
 }
 
 uint8_t c64io_d600_read(uint16_t addr)
 {
     DBGRW(("IO: io-d600 r %04x\n", addr));
-    return io_read(&c64io_d600_head, addr);
+    return io_read(&c64io_d600_head, c64io_d600_table, addr);
 }
 
 uint8_t c64io_d600_peek(uint16_t addr)
@@ -693,13 +774,13 @@ uint8_t c64io_d600_peek(uint16_t addr)
 void c64io_d600_store(uint16_t addr, uint8_t value)
 {
     DBGRW(("IO: io-d600 w %04x %02x\n", addr, value));
-    io_store(&c64io_d600_head, addr, value);
+    io_store(&c64io_d600_head, c64io_d600_table, addr, value);
 }
 
 uint8_t c64io_d700_read(uint16_t addr)
 {
     DBGRW(("IO: io-d700 r %04x\n", addr));
-    return io_read(&c64io_d700_head, addr);
+    return io_read(&c64io_d700_head, c64io_d700_table, addr);
 }
 
 uint8_t c64io_d700_peek(uint16_t addr)
@@ -711,13 +792,13 @@ uint8_t c64io_d700_peek(uint16_t addr)
 void c64io_d700_store(uint16_t addr, uint8_t value)
 {
     DBGRW(("IO: io-d700 w %04x %02x\n", addr, value));
-    io_store(&c64io_d700_head, addr, value);
+    io_store(&c64io_d700_head, c64io_d700_table, addr, value);
 }
 
 uint8_t c64io_de00_read(uint16_t addr)
 {
     DBGRW(("IO: io-de00 r %04x\n", addr));
-    return io_read(&c64io_de00_head, addr);
+    return io_read(&c64io_de00_head, c64io_de00_table, addr);
 }
 
 uint8_t c64io_de00_peek(uint16_t addr)
@@ -729,13 +810,13 @@ uint8_t c64io_de00_peek(uint16_t addr)
 void c64io_de00_store(uint16_t addr, uint8_t value)
 {
     DBGRW(("IO: io-de00 w %04x %02x\n", addr, value));
-    io_store(&c64io_de00_head, addr, value);
+    io_store(&c64io_de00_head, c64io_de00_table, addr, value);
 }
 
 uint8_t c64io_df00_read(uint16_t addr)
 {
     DBGRW(("IO: io-df00 r %04x\n", addr));
-    return io_read(&c64io_df00_head, addr);
+    return io_read(&c64io_df00_head, c64io_df00_table, addr);
 }
 
 uint8_t c64io_df00_peek(uint16_t addr)
@@ -747,7 +828,7 @@ uint8_t c64io_df00_peek(uint16_t addr)
 void c64io_df00_store(uint16_t addr, uint8_t value)
 {
     DBGRW(("IO: io-df00 w %04x %02x\n", addr, value));
-    io_store(&c64io_df00_head, addr, value);
+    io_store(&c64io_df00_head, c64io_df00_table, addr, value);
 }
 
 /* ---------------------------------------------------------------------------------------------------------- */
@@ -43,7 +43,9 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "alarm.h"
 #include "archdep.h"
+#include "c64mem.h"
 #include "cartio.h"
 #include "cartridge.h"
 #include "cmdline.h"
@@ -1160,6 +1162,114 @@ static void reu_dma_update_regs(uint16_t host_addr, unsigned int reu_addr, int l
     }
 }
 
+/*! \brief number of bytes of a DMA copy that can be done in one go
+
+  \param host_addr
+    The host (computer) address where the copy continues
+
+  \param reu_addr
+    The REU address where the copy continues
+
+  \param host_step
+    The increment to use for the host address; must be either 0 or 1
+
+  \param reu_step
+    The increment to use for the REU address; must be either 0 or 1
+
+  \param len
+    The remaining transfer length
+
+  \param host_write
+    Non-zero if the copy goes to the host
+
+  \return
+    The number of bytes that can be copied between mem_ram and reu_ram
+    directly, 0 if the next byte has to be transferred the normal way.
+
+  \remark
+    This is only the case on x64, where the REU just counts the cycles it
+    steals, and only for host RAM that is mapped in plainly (no watchpoints,
+    I/O, cartridge or RAM expansion) and for REU addresses backed up by
+    DRAM without a wrap around in between.  The copy must also end before
+    the next alarm is due, so VIC-II fetches and all other events happen
+    exactly as if the bytes were transferred one by one.
+*/
+static int reu_dma_bulk_len(uint16_t host_addr, unsigned int reu_addr, int host_step, int reu_step, int len, int host_write)
+{
+    CLOCK next_alarm_clk;
+    unsigned int offset, avail;
+
+    if (reu_ba.enabled || machine_class != VICE_MACHINE_C64) {
+        return 0;
+    }
+
+    if (host_write) {
+        if (_mem_write_tab_ptr[host_addr >> 8] != ram_store) {
+            return 0;
+        }
+    } else {
+        if (_mem_read_tab_ptr[host_addr >> 8] != ram_read) {
+            return 0;
+        }
+    }
+    if (host_step && len > 0x100 - (host_addr & 0xff)) {
+        len = 0x100 - (host_addr & 0xff);
+    }
+
+    /* every byte takes one cycle and the alarms are served after each */
+    next_alarm_clk = alarm_context_next_pending_clk(maincpu_alarm_context);
+    if (next_alarm_clk <= maincpu_clk + 1) {
+        return 0;
+    }
+    if ((CLOCK)len >= next_alarm_clk - maincpu_clk) {
+        len = (int)(next_alarm_clk - maincpu_clk - 1);
+    }
+
+    if ((reu_addr & 0x0007ffff) >= rec_options.wrap_around) {
+        return 0;
+    }
+    offset = reu_addr & (rec_options.dram_wrap_around - 1);
+    if (offset >= rec_options.not_backedup_addresses) {
+        return 0;
+    }
+    if (reu_step) {
+        avail = rec_options.wrap_around - (reu_addr & 0x0007ffff);
+        if (avail > rec_options.not_backedup_addresses - offset) {
+            avail = rec_options.not_backedup_addresses - offset;
+        }
+        if (avail > rec_options.dram_wrap_around - offset) {
+            avail = rec_options.dram_wrap_around - offset;
+        }
+        if ((unsigned int)len > avail) {
+            len = (int)avail;
+        }
+    }
+
+    return len;
+}
+
+/*! \brief advance the REU address after a DMA copy done in one go
+
+  \param reu_addr
+    The REU address where the copy started
+
+  \param reu_step
+    The increment to use for the REU address; must be either 0 or 1
+
+  \param n
+    The number of bytes copied, as returned by reu_dma_bulk_len()
+
+  \return
+    The REU address the copy stopped at
+*/
+inline static unsigned int reu_dma_bulk_advance(unsigned int reu_addr, int reu_step, int n)
+{
+    if (!reu_step) {
+        return reu_addr;
+    }
+    return increment_reu_with_wrap_around(reu_addr + n - 1, 1);
+}
+
 /*! \brief DMA operation writing from the host to the REU
 
   \param host_addr
@@ -1180,6 +1290,8 @@ static void reu_dma_update_regs(uint16_t host_addr, unsigned int reu_addr, int l
 static void reu_dma_host_to_reu(uint16_t host_addr, unsigned int reu_addr, int host_step, int reu_step, int len)
 {
     uint8_t value;
+    uint8_t *dest;
+    int n;
     DEBUG_LOG(DEBUG_LEVEL_TRANSFER_HIGH_LEVEL, (reu_log, "copy ext $%05X %s<= main $%04X%s, $%04X (%d) bytes.",
                                                 reu_addr, reu_step ? "" : "(fixed) ", host_addr, host_step ? "" : " (fixed)", len, len));
 
@@ -1188,6 +1300,23 @@ static void reu_dma_host_to_reu(uint16_t host_addr, unsigned int reu_addr, int h
     assert(len >= 1);
 
     while (len) {
+        n = reu_dma_bulk_len(host_addr, reu_addr, host_step, reu_step, len, 0);
+        if (n > 0) {
+            dest = reu_ram + (reu_addr & (rec_options.dram_wrap_around - 1));
+            if (!reu_step) {
+                *dest = mem_ram[host_addr + (host_step ? n - 1 : 0)];
+            } else if (host_step) {
+                memcpy(dest, mem_ram + host_addr, (size_t)n);
+            } else {
+                memset(dest, mem_ram[host_addr], (size_t)n);
+            }
+            maincpu_clk += n;
+            host_addr = (host_addr + host_step * n) & 0xffff;
+            reu_addr = reu_dma_bulk_advance(reu_addr, reu_step, n);
+            len -= n;
+            continue;
+        }
+
         reu_clk_inc_pre();
         machine_handle_pending_alarms(0);
         value = mem_read(host_addr);
@@ -1223,6 +1352,8 @@ static void reu_dma_host_to_reu(uint16_t host_addr, unsigned int reu_addr, int h
 static void reu_dma_reu_to_host(uint16_t host_addr, unsigned int reu_addr, int host_step, int reu_step, int len)
 {
     uint8_t value;
+    uint8_t *src;
+    int n;
     DEBUG_LOG(DEBUG_LEVEL_TRANSFER_HIGH_LEVEL, (reu_log, "copy ext $%05X %s=> main $%04X%s, $%04X (%d) bytes.",
                                                 reu_addr, reu_step ? "" : "(fixed) ", host_addr, host_step ? "" : " (fixed)", len, len));
 
@@ -1231,6 +1362,23 @@ static void reu_dma_reu_to_host(uint16_t host_addr, unsigned int reu_addr, int h
     assert(len >= 1);
 
     while (len) {
+        n = reu_dma_bulk_len(host_addr, reu_addr, host_step, reu_step, len, 1);
+        if (n > 0) {
+            src = reu_ram + (reu_addr & (rec_options.dram_wrap_around - 1));
+            if (!host_step) {
+                mem_ram[host_addr] = src[reu_step ? n - 1 : 0];
+            } else if (reu_step) {
+                memcpy(mem_ram + host_addr, src, (size_t)n);
+            } else {
+                memset(mem_ram + host_addr, *src, (size_t)n);
+            }
+            maincpu_clk += n;
+            host_addr = (host_addr + host_step * n) & 0xffff;
+            reu_addr = reu_dma_bulk_advance(reu_addr, reu_step, n);
+            len -= n;
+            continue;
+        }
+
         DEBUG_LOG(DEBUG_LEVEL_TRANSFER_LOW_LEVEL, (reu_log, "Transferring byte: %x from ext $%05X to main $%04X.", reu_ram[reu_addr % reu_size], reu_addr, host_addr));
         reu_clk_inc_pre();
         value = read_from_reu(reu_addr);
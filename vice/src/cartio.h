@@ -194,6 +194,8 @@ typedef struct io_source_detach_s {
     unsigned int order;
 } io_source_detach_t;
 
+/* The address range and the read/store functions of a device must not be
+   changed while it is registered; unregister it first.  */
 extern io_source_list_t *io_source_register(io_source_t *device);
 extern void io_source_unregister(io_source_list_t *device);
 
@@ -826,6 +826,32 @@ uint8_t viacore_read_(via_context_t *via_context, uint16_t addr)
     return via_context->via[addr];
 }
 
+/* Return nonzero if reading register `addr' again yields the same value
+   and has no further side effects, as long as nothing is stored to the
+   VIA, no VIA alarm occurs and the inputs do not change.  Only port B
+   (unless PB7 shows timer 1) and the interrupt flags qualify.  */
+int viacore_read_stable(via_context_t *via_context, uint16_t addr)
+{
+    switch (addr & 0xf) {
+        case VIA_PRB:
+            return !(via_context->via[VIA_ACR] & 0x80);
+        case VIA_IFR:
+            return 1;
+    }
+    return 0;
+}
+
+/* The CPU has skipped `cycles' cycles of a loop that only reads stable
+   registers, the last round of which started at `since'.  Each round reads
+   the same values, so only the time of the last read moves on.  */
+void viacore_read_skipped(via_context_t *via_context, CLOCK since,
+                          CLOCK cycles)
+{
+    if (via_context->read_clk >= since) {
+        via_context->read_clk += cycles;
+    }
+}
+
 /* return value of a register without side effects */
 /* FIXME: this is buggy/incomplete */
 uint8_t viacore_peek(via_context_t *via_context, uint16_t addr)
@@ -352,13 +352,18 @@ inline static int datasette_move_buffer_forward(int offset)
     /* reads buffer to fit the next gap-read
        tap_buffer[next_tap] ~ current_file_seek_position
     */
+    long len;
+
     if (next_tap + offset >= last_tap) {
-        if (fseek(current_image->fd, current_image->current_file_seek_position
-                  + current_image->offset, SEEK_SET)) {
+        len = tap_read_data(current_image,
+                            current_image->current_file_seek_position
+                            + current_image->offset,
+                            tap_buffer, TAP_BUFFER_LENGTH);
+        if (len < 0) {
             log_error(datasette_log, "Cannot read in tap-file.");
             return 0;
         }
-        last_tap = (long)fread(tap_buffer, 1, TAP_BUFFER_LENGTH, current_image->fd);
+        last_tap = len;
         next_tap = 0;
         if (next_tap >= last_tap) {
             return 0;
@@ -372,18 +377,23 @@ inline static int datasette_move_buffer_back(int offset)
     /* reads buffer to fit the next gap-read at current_file_seek_position-1
        tap_buffer[next_tap] ~ current_file_seek_position
     */
+    long len;
+
     if (next_tap + offset < 0) {
         if (current_image->current_file_seek_position >= TAP_BUFFER_LENGTH) {
             next_tap = TAP_BUFFER_LENGTH;
         } else {
             next_tap = current_image->current_file_seek_position;
         }
-        if (fseek(current_image->fd, current_image->current_file_seek_position
-                  - next_tap + current_image->offset, SEEK_SET)) {
+        len = tap_read_data(current_image,
+                            current_image->current_file_seek_position
+                            - next_tap + current_image->offset,
+                            tap_buffer, TAP_BUFFER_LENGTH);
+        if (len < 0) {
             log_error(datasette_log, "Cannot read in tap-file.");
             return 0;
         }
-        last_tap = (long)fread(tap_buffer, 1, TAP_BUFFER_LENGTH, current_image->fd);
+        last_tap = len;
         if (next_tap > last_tap) {
             return 0;
         }
@@ -1037,6 +1047,8 @@ inline static void bit_write(void)
         return;
     }
 
+    tap_discard_buffer(current_image);
+
     if (write_time < (CLOCK)(255 * 8 + 7)) {
         write_gap = (uint8_t)(write_time / (CLOCK)8);
         if (fwrite(&write_gap, 1, 1, current_image->fd) < 1) {
@@ -38,6 +38,7 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "cmdline.h"
 #include "diskconstants.h"
 #include "diskimage.h"
 #include "fsimage-check.h"
@@ -50,6 +51,8 @@
 #include "log.h"
 #include "rawimage.h"
 #include "realimage.h"
+#include "resources.h"
+#include "translate.h"
 #include "types.h"
 #include "p64.h"
 
@@ -702,8 +705,62 @@ void disk_image_init(void)
 #endif
 }
 
+/* Write back changed sectors of images kept in memory.  */
+int disk_image_sync(disk_image_t *image)
+{
+    if (image == NULL || image->device != DISK_IMAGE_DEVICE_FS) {
+        return 0;
+    }
+
+    return fsimage_sync(image);
+}
+
+void disk_image_write_back_set(int seconds)
+{
+    fsimage_write_back_set(seconds);
+}
+
+/* Called periodically to write back images changed a while ago.  */
+void disk_image_write_back_check(void)
+{
+    fsimage_write_back_check();
+}
+
+/*-----------------------------------------------------------------------*/
+
+static int write_back;
+
+static int set_write_back(int val, void *param)
+{
+    if (val < 0) {
+        return -1;
+    }
+
+    write_back = val;
+    fsimage_write_back_set(val);
+    return 0;
+}
+
+static const resource_int_t resources_int[] = {
+    { "DiskImageWriteBack", 0, RES_EVENT_NO, NULL,
+      &write_back, set_write_back, NULL },
+    RESOURCE_INT_LIST_END
+};
+
+static const cmdline_option_t cmdline_options[] = {
+    { "-diskwriteback", SET_RESOURCE, 1,
+      NULL, NULL, "DiskImageWriteBack", NULL,
+      USE_PARAM_STRING, USE_DESCRIPTION_STRING,
+      IDCLS_UNUSED, IDCLS_UNUSED,
+      "<seconds>", "Keep disk images in memory and write back changed sectors after <seconds> (0: write every sector right away)" },
+    CMDLINE_LIST_END
+};
+
 int disk_image_resources_init(void)
 {
+    if (resources_register_int(resources_int) < 0) {
+        return -1;
+    }
 #ifdef HAVE_RAWDRIVE
     if (rawimage_resources_init() < 0) {
         return -1;
@@ -721,6 +778,9 @@ void disk_image_resources_shutdown(void)
 
 int disk_image_cmdline_options_init(void)
 {
+    if (cmdline_register_options(cmdline_options) < 0) {
+        return -1;
+    }
 #ifdef HAVE_RAWDRIVE
     if (rawimage_cmdline_options_init() < 0) {
         return -1;
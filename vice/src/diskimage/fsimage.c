@@ -28,6 +28,8 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 
 #include "archdep.h"
 #include "diskconstants.h"
@@ -47,6 +49,13 @@
 
 static log_t fsimage_log = LOG_DEFAULT;
 
+/* Seconds after which changed blocks of images kept in memory are written
+   back, 0 to write every sector to the file right away.  */
+static int fsimage_write_back = 0;
+
+/* Images kept in memory.  */
+static fsimage_t *fsimage_cached = NULL;
+
 
 /** \brief  Set image name
  *
@@ -122,6 +131,208 @@ void fsimage_media_destroy(disk_image_t *image)
 
 /*-----------------------------------------------------------------------*/
 
+/* With write-back enabled, D64/D71/D81/D80/D82/X64 style images are read
+   into memory when they are opened.  Sectors are then read and written in
+   memory, and the changed blocks are written to the file in runs when the
+   image is closed, when fsimage_sync() is called or when they have been
+   pending for `fsimage_write_back' seconds.  */
+
+static void fsimage_cache_load(disk_image_t *image)
+{
+    fsimage_t *fsimage = image->media.fsimage;
+    long size;
+
+    switch (image->type) {
+        case DISK_IMAGE_TYPE_D64:
+        case DISK_IMAGE_TYPE_D67:
+        case DISK_IMAGE_TYPE_D71:
+        case DISK_IMAGE_TYPE_D81:
+        case DISK_IMAGE_TYPE_D80:
+        case DISK_IMAGE_TYPE_D82:
+        case DISK_IMAGE_TYPE_X64:
+            break;
+        default:
+            return;
+    }
+
+    if (fseek(fsimage->fd, 0, SEEK_END) < 0
+        || (size = ftell(fsimage->fd)) <= 0) {
+        return;
+    }
+
+    fsimage->cache.data = lib_malloc((size_t)size);
+    if (util_fpread(fsimage->fd, fsimage->cache.data, (size_t)size, 0) < 0) {
+        lib_free(fsimage->cache.data);
+        fsimage->cache.data = NULL;
+        return;
+    }
+    fsimage->cache.size = (size_t)size;
+    fsimage->cache.dirty = lib_calloc(1, (size_t)size / FSIMAGE_CACHE_BLOCK + 1);
+    fsimage->cache.pending = 0;
+
+    fsimage->cache.next = fsimage_cached;
+    fsimage_cached = fsimage;
+}
+
+static int fsimage_cache_flush(fsimage_t *fsimage)
+{
+    size_t block, end, blocks, offset, num;
+    int rc = 0;
+
+    if (fsimage->cache.pending == 0) {
+        return 0;
+    }
+
+    blocks = (fsimage->cache.size + FSIMAGE_CACHE_BLOCK - 1) / FSIMAGE_CACHE_BLOCK;
+
+    for (block = 0; block < blocks; block = end) {
+        if (!fsimage->cache.dirty[block]) {
+            end = block + 1;
+            continue;
+        }
+        for (end = block; end < blocks && fsimage->cache.dirty[end]; end++) {
+        }
+
+        offset = block * FSIMAGE_CACHE_BLOCK;
+        num = end * FSIMAGE_CACHE_BLOCK;
+        if (num > fsimage->cache.size) {
+            num = fsimage->cache.size;
+        }
+        num -= offset;
+
+        if (util_fpwrite(fsimage->fd, fsimage->cache.data + offset, num,
+                         (long)offset) < 0) {
+            log_error(fsimage_log, "Error writing back `%s'.", fsimage->name);
+            rc = -1;
+            continue;
+        }
+        memset(fsimage->cache.dirty + block, 0, end - block);
+        fsimage->cache.pending -= (unsigned int)(end - block);
+    }
+
+    /* Make sure the stream is visible to other readers.  */
+    fflush(fsimage->fd);
+    return rc;
+}
+
+static void fsimage_cache_free(fsimage_t *fsimage)
+{
+    fsimage_t **p;
+
+    for (p = &fsimage_cached; *p != NULL; p = &(*p)->cache.next) {
+        if (*p == fsimage) {
+            *p = fsimage->cache.next;
+            break;
+        }
+    }
+
+    lib_free(fsimage->cache.data);
+    lib_free(fsimage->cache.dirty);
+    memset(&fsimage->cache, 0, sizeof(fsimage->cache));
+}
+
+/* Read `num' bytes at `offset' of the image, like util_fpread().  */
+int fsimage_pread(fsimage_t *fsimage, void *buf, size_t num, long offset)
+{
+    if (fsimage->cache.data == NULL) {
+        return util_fpread(fsimage->fd, buf, num, offset);
+    }
+
+    if (offset < 0 || (size_t)offset + num > fsimage->cache.size) {
+        return -1;
+    }
+    memcpy(buf, fsimage->cache.data + offset, num);
+    return 0;
+}
+
+/* Write `num' bytes at `offset' of the image, like util_fpwrite().  */
+int fsimage_pwrite(fsimage_t *fsimage, const void *buf, size_t num, long offset)
+{
+    size_t end, block, last;
+
+    if (fsimage->cache.data == NULL) {
+        return util_fpwrite(fsimage->fd, buf, num, offset);
+    }
+
+    if (offset < 0) {
+        return -1;
+    }
+
+    end = (size_t)offset + num;
+    block = (size_t)offset / FSIMAGE_CACHE_BLOCK;
+
+    /* Grow the image like a file would, the gap is written as zeroes.  */
+    if (end > fsimage->cache.size) {
+        size_t blocks = fsimage->cache.size / FSIMAGE_CACHE_BLOCK + 1;
+        size_t new_blocks = end / FSIMAGE_CACHE_BLOCK + 1;
+
+        fsimage->cache.data = lib_realloc(fsimage->cache.data, end);
+        memset(fsimage->cache.data + fsimage->cache.size, 0,
+               end - fsimage->cache.size);
+        fsimage->cache.dirty = lib_realloc(fsimage->cache.dirty, new_blocks);
+        memset(fsimage->cache.dirty + blocks, 0, new_blocks - blocks);
+        if (fsimage->cache.size / FSIMAGE_CACHE_BLOCK < block) {
+            block = fsimage->cache.size / FSIMAGE_CACHE_BLOCK;
+        }
+        fsimage->cache.size = end;
+    }
+
+    memcpy(fsimage->cache.data + offset, buf, num);
+
+    if (fsimage->cache.pending == 0) {
+        fsimage->cache.since = time(NULL);
+    }
+    for (last = (end - 1) / FSIMAGE_CACHE_BLOCK; block <= last; block++) {
+        if (!fsimage->cache.dirty[block]) {
+            fsimage->cache.dirty[block] = 1;
+            fsimage->cache.pending++;
+        }
+    }
+
+    return 0;
+}
+
+/* Write back the changed blocks of `image' if it is kept in memory.  */
+int fsimage_sync(disk_image_t *image)
+{
+    fsimage_t *fsimage = image->media.fsimage;
+
+    if (fsimage->fd == NULL || fsimage->cache.data == NULL) {
+        return 0;
+    }
+
+    return fsimage_cache_flush(fsimage);
+}
+
+/* Keep images opened from now on in memory and write them back after
+   `seconds', or write through if 0.  */
+void fsimage_write_back_set(int seconds)
+{
+    fsimage_write_back = seconds < 0 ? 0 : seconds;
+}
+
+/* Write back the images with blocks pending for long enough.  */
+void fsimage_write_back_check(void)
+{
+    fsimage_t *fsimage;
+    time_t now;
+
+    if (fsimage_cached == NULL) {
+        return;
+    }
+
+    now = time(NULL);
+
+    for (fsimage = fsimage_cached; fsimage != NULL; fsimage = fsimage->cache.next) {
+        if (fsimage->cache.pending > 0
+            && now - fsimage->cache.since >= fsimage_write_back) {
+            fsimage_cache_flush(fsimage);
+        }
+    }
+}
+
+/*-----------------------------------------------------------------------*/
+
 int fsimage_open(disk_image_t *image)
 {
     fsimage_t *fsimage;
@@ -147,6 +358,9 @@ int fsimage_open(disk_image_t *image)
     }
 
     if (fsimage_probe(image) == 0) {
+        if (fsimage_write_back > 0) {
+            fsimage_cache_load(image);
+        }
         return 0;
     }
 
@@ -170,6 +384,11 @@ int fsimage_close(disk_image_t *image)
         fsimage_write_p64_image(image);
     }*/
 
+    if (fsimage->cache.data != NULL) {
+        fsimage_cache_flush(fsimage);
+        fsimage_cache_free(fsimage);
+    }
+
     if (fsimage->error_info.map) {
         lib_free(fsimage->error_info.map);
         fsimage->error_info.map = NULL;
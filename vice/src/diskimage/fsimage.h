@@ -28,6 +28,7 @@
 #define VICE_FSIMAGE_H
 
 #include <stdio.h>
+#include <time.h>
 
 #include "types.h"
 
@@ -42,8 +43,22 @@ typedef struct fsimage_s {
         int dirty;
         int len;
     } error_info;
+    struct {
+        /* Contents of the image when it is kept in memory, else NULL.  */
+        uint8_t *data;
+        size_t size;
+        /* One flag per FSIMAGE_CACHE_BLOCK bytes changed since the last
+           write-back, and the number of flags set.  */
+        uint8_t *dirty;
+        unsigned int pending;
+        /* Time the first pending block was changed.  */
+        time_t since;
+        struct fsimage_s *next;
+    } cache;
 } fsimage_t;
 
+#define FSIMAGE_CACHE_BLOCK 256
+
 
 extern void fsimage_init(void);
 
@@ -60,4 +75,12 @@ extern int fsimage_read_sector(const struct disk_image_s *image, uint8_t *buf,
 extern int fsimage_write_sector(struct disk_image_s *image, const uint8_t *buf,
                                 const struct disk_addr_s *dadr);
 
+extern int fsimage_pread(fsimage_t *fsimage, void *buf, size_t num,
+                         long offset);
+extern int fsimage_pwrite(fsimage_t *fsimage, const void *buf, size_t num,
+                          long offset);
+extern int fsimage_sync(struct disk_image_s *image);
+extern void fsimage_write_back_set(int seconds);
+extern void fsimage_write_back_check(void);
+
 #endif
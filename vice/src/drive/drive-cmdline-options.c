@@ -63,6 +63,26 @@ static const cmdline_option_t cmdline_options[] = {
       USE_PARAM_ID, USE_DESCRIPTION_ID,
       IDCLS_P_VOLUME, IDCLS_SET_DRIVE_SOUND_VOLUME,
       NULL, NULL },
+    { "-driveworkerthreads", SET_RESOURCE, 0,
+      NULL, NULL, "DriveWorkerThreads", (void *)1,
+      USE_PARAM_STRING, USE_DESCRIPTION_STRING,
+      IDCLS_UNUSED, IDCLS_UNUSED,
+      NULL, "Run the true drive emulation of multiple drives on worker threads" },
+    { "+driveworkerthreads", SET_RESOURCE, 0,
+      NULL, NULL, "DriveWorkerThreads", (void *)0,
+      USE_PARAM_STRING, USE_DESCRIPTION_STRING,
+      IDCLS_UNUSED, IDCLS_UNUSED,
+      NULL, "Run the true drive emulation of all drives on the main thread" },
+    { "-driveidleloops", SET_RESOURCE, 0,
+      NULL, NULL, "DriveIdleLoops", (void *)1,
+      USE_PARAM_STRING, USE_DESCRIPTION_STRING,
+      IDCLS_UNUSED, IDCLS_UNUSED,
+      NULL, "Skip drive CPU loops that only wait for a change on the bus" },
+    { "+driveidleloops", SET_RESOURCE, 0,
+      NULL, NULL, "DriveIdleLoops", (void *)0,
+      USE_PARAM_STRING, USE_DESCRIPTION_STRING,
+      IDCLS_UNUSED, IDCLS_UNUSED,
+      NULL, "Execute drive CPU loops that only wait for a change on the bus" },
     CMDLINE_LIST_END
 };
 
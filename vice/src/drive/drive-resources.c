@@ -34,6 +34,7 @@
 #include "drivecpu.h"
 #include "drivecpu65c02.h"
 #include "driverom.h"
+#include "drivethread.h"
 #include "drivetypes.h"
 #include "ds1216e.h"
 #include "iecbus.h"
@@ -107,6 +108,20 @@ static int set_drive_sound_emulation_volume(int val, void *param)
     return 0;
 }
 
+static int set_drive_worker_threads(int val, void *param)
+{
+    drivethread_enabled = val ? 1 : 0;
+
+    return 0;
+}
+
+static int set_drive_idle_loops(int val, void *param)
+{
+    drivecpu_idle_loops = val ? 1 : 0;
+
+    return 0;
+}
+
 static int set_drive_extend_image_policy(int val, void *param)
 {
     switch (val) {
@@ -338,6 +353,10 @@ static const resource_int_t resources_int[] = {
       &drive_sound_emulation, set_drive_sound_emulation, NULL },
     { "DriveSoundEmulationVolume", 1000, RES_EVENT_NO, (resource_value_t)1000,
       &drive_sound_emulation_volume, set_drive_sound_emulation_volume, NULL },
+    { "DriveWorkerThreads", 0, RES_EVENT_STRICT, (resource_value_t)0,
+      &drivethread_enabled, set_drive_worker_threads, NULL },
+    { "DriveIdleLoops", 1, RES_EVENT_NO, NULL,
+      &drivecpu_idle_loops, set_drive_idle_loops, NULL },
     RESOURCE_INT_LIST_END
 };
 
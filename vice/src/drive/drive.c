@@ -45,6 +45,7 @@
 #include <assert.h>
 
 #include "attach.h"
+#include "benchmark.h"
 #include "diskconstants.h"
 #include "diskimage.h"
 #include "drive-check.h"
@@ -54,6 +55,7 @@
 #include "drivecpu65c02.h"
 #include "driveimage.h"
 #include "drivesync.h"
+#include "drivethread.h"
 #include "driverom.h"
 #include "drivetypes.h"
 #include "gcr.h"
@@ -268,6 +270,8 @@ void drive_shutdown(void)
         return;
     }
 
+    drivethread_shutdown();
+
     for (dnr = 0; dnr < DRIVE_NUM; dnr++) {
         if (drive_context[dnr]->drive->type == DRIVE_TYPE_2000 || drive_context[dnr]->drive->type == DRIVE_TYPE_4000) {
             drivecpu65c02_shutdown(drive_context[dnr]);
@@ -595,6 +599,7 @@ void drive_set_half_track(int num, int side, drive_t *dptr)
    for `step' are `+1', '+2' and `-1'.  */
 void drive_move_head(int step, drive_t *drive)
 {
+    DRIVETHREAD_SYNC(drive_context[drive->mynumber]);
     drive_gcr_data_writeback(drive);
     drive_sound_head(drive->current_half_track, step, drive->mynumber);
     drive_set_half_track(drive->current_half_track + step, drive->side, drive);
@@ -798,24 +803,40 @@ void drive_cpu_execute_one(drive_context_t *drv, CLOCK clk_value)
 {
     drive_t *drive = drv->drive;
 
+    BENCHMARK_ENTER(BENCHMARK_DRIVES);
+
     if (drive->type == DRIVE_TYPE_2000 || drive->type == DRIVE_TYPE_4000) {
         drivecpu65c02_execute(drv, clk_value);
     } else {
         drivecpu_execute(drv, clk_value);
     }
+
+    BENCHMARK_LEAVE();
 }
 
 void drive_cpu_execute_all(CLOCK clk_value)
 {
-    unsigned int dnr;
+    unsigned int dnr, mask = 0;
     drive_t *drive;
 
     for (dnr = 0; dnr < DRIVE_NUM; dnr++) {
-        drive = drive_context[dnr]->drive;
-        if (drive->enable) {
-            drive_cpu_execute_one(drive_context[dnr], clk_value);
+        if (drive_context[dnr]->drive->enable) {
+            mask |= 1 << dnr;
+        }
+    }
+
+    BENCHMARK_ENTER(BENCHMARK_DRIVES);
+
+    if (drivethread_execute(mask, clk_value) != 0) {
+        for (dnr = 0; dnr < DRIVE_NUM; dnr++) {
+            drive = drive_context[dnr]->drive;
+            if (drive->enable) {
+                drive_cpu_execute_one(drive_context[dnr], clk_value);
+            }
         }
     }
+
+    BENCHMARK_LEAVE();
 }
 
 void drive_cpu_set_overflow(drive_context_t *drv)
@@ -832,14 +853,27 @@ void drive_cpu_set_overflow(drive_context_t *drv)
 /* This is called at every vsync. */
 void drive_vsync_hook(void)
 {
-    unsigned int dnr;
+    unsigned int dnr, mask = 0;
+    int threaded;
 
     drive_update_ui_status();
 
+    disk_image_write_back_check();
+
+    BENCHMARK_ENTER(BENCHMARK_DRIVES);
+
+    for (dnr = 0; dnr < DRIVE_NUM; dnr++) {
+        drive_t *drive = drive_context[dnr]->drive;
+        if (drive->enable && drive->idling_method != DRIVE_IDLE_SKIP_CYCLES) {
+            mask |= 1 << dnr;
+        }
+    }
+    threaded = (drivethread_execute(mask, maincpu_clk) == 0);
+
     for (dnr = 0; dnr < DRIVE_NUM; dnr++) {
         drive_t *drive = drive_context[dnr]->drive;
         if (drive->enable) {
-            if (drive->idling_method != DRIVE_IDLE_SKIP_CYCLES) {
+            if (drive->idling_method != DRIVE_IDLE_SKIP_CYCLES && !threaded) {
                 drive_cpu_execute_one(drive_context[dnr], maincpu_clk);
             }
             if (drive->idling_method == DRIVE_IDLE_NO_IDLE) {
@@ -852,6 +886,8 @@ void drive_vsync_hook(void)
             /* printf("drive_vsync_hook drv %d @clk:%d\n", dnr, maincpu_clk); */
         }
     }
+
+    BENCHMARK_LEAVE();
 }
 
 /* ------------------------------------------------------------------------- */
@@ -41,6 +41,7 @@
 #include "drivecpu.h"
 #include "drive-check.h"
 #include "drivemem.h"
+#include "drivethread.h"
 #include "drivetypes.h"
 #include "interrupt.h"
 #include "lib.h"
@@ -176,6 +177,8 @@ void drivecpu_reset_clk(drive_context_t *drv)
     drv->cpu->last_clk = maincpu_clk;
     drv->cpu->last_exc_cycles = 0;
     drv->cpu->stop_clk = 0;
+    drv->cpu->idle_loop_span = 0;
+    drv->cpu->jam_pending = 0;
 }
 
 void drivecpu_reset(drive_context_t *drv)
@@ -275,7 +278,12 @@ CLOCK drivecpu_prevent_clk_overflow(drive_context_t *drv, CLOCK sub)
     }
 
     /* Then, check our own clock counters.  */
-    return clk_guard_prevent_overflow(drv->cpu->clk_guard);
+    sub = clk_guard_prevent_overflow(drv->cpu->clk_guard);
+    if (sub != 0) {
+        drv->cpu->idle_loop_span = 0;
+    }
+
+    return sub;
 }
 
 /* Handle a ROM trap. */
@@ -305,6 +313,236 @@ static void drive_generic_dma(void)
        Not very likey for disk drives. */
 }
 
+/* ------------------------------------------------------------------------- */
+/* Polling loops.
+
+   When the drive CPU jumps back to the start of a short loop that only
+   reads plain memory and registers marked as stable (like port B and the
+   interrupt flags of the serial bus VIA) and changes nothing but the
+   registers, the loop is watched.  If a round of it ends with the same
+   registers it started with, and no alarm, interrupt or end of the time
+   slice came in between, every further round does exactly the same until
+   the next drive alarm or the end of the time slice, as the bus only
+   changes between time slices.
+   The drive clock is then advanced by as many whole rounds as fit in,
+   which leaves the drive in the state executing them would have.  This
+   catches the wait loops of fast loaders, which never reach the idle trap
+   of the DOS.  `make check' compares this with stepping through the loops
+   (idleloopstest.c).  */
+
+/* Value of the `DriveIdleLoops' resource.  */
+int drivecpu_idle_loops = 1;
+
+/* Longest loop watched, in bytes.  */
+#define IDLE_LOOP_MAX  32
+
+/* Return the byte at `addr' if it is plain memory, -1 otherwise.  */
+static int idle_loop_fetch(drive_context_t *drv, unsigned int addr)
+{
+    uint8_t *base;
+
+    addr &= 0xffff;
+    base = drv->cpud->read_base_tab_ptr[addr >> 8];
+
+    return base != NULL ? base[addr] : -1;
+}
+
+/* Check the `span' bytes long loop at `pc'.  Return a mask with bit n set
+   for each opcode at `pc' + n, or 0 if the loop may do more than reading
+   stable addresses and changing registers.  With `now' unset, only what
+   cannot change while the code stays the same is checked.  */
+static uint32_t idle_loop_decode(drive_context_t *drv, unsigned int pc,
+                                 unsigned int span, int now)
+{
+    drive_stable_func_t *stable;
+    uint32_t insns = 0;
+    unsigned int offset = 0, addr;
+    int op, lo, hi, len, read;
+
+    while (offset < span) {
+        op = idle_loop_fetch(drv, pc + offset);
+        read = 0;
+
+        switch (op) {
+            case 0x0a: case 0x18: case 0x2a: case 0x38: /* ASL CLC ROL SEC */
+            case 0x4a: case 0x6a: case 0x88: case 0x8a: /* LSR ROR DEY TXA */
+            case 0x98: case 0xa8: case 0xaa: case 0xc8: /* TYA TAY TAX INY */
+            case 0xca: case 0xe8: case 0xea:            /* DEX INX NOP */
+                len = 1;
+                break;
+            case 0x09: case 0x29: case 0x49: case 0xa0: /* ORA AND EOR LDY # */
+            case 0xa2: case 0xa9: case 0xc0: case 0xc9: /* LDX LDA CPY CMP # */
+            case 0xe0:                                  /* CPX # */
+            case 0x10: case 0x30: case 0x90: case 0xb0: /* BPL BMI BCC BCS */
+            case 0xd0: case 0xf0:                       /* BNE BEQ */
+                len = 2;
+                break;
+            case 0x4c:                                  /* JMP abs */
+                len = 3;
+                break;
+            case 0x24: case 0x2c:                       /* BIT zp, abs */
+                /* BIT rotates the disk when it clears V.  */
+                if (now && (drv->drive->byte_ready_active & 4)) {
+                    return 0;
+                }
+                /* fall through */
+            case 0x05: case 0x25: case 0x45: case 0xa4: /* ORA AND EOR LDY zp */
+            case 0xa5: case 0xa6: case 0xc4: case 0xc5: /* LDA LDX CPY CMP zp */
+            case 0xe4:                                  /* CPX zp */
+            case 0x0d: case 0x2d: case 0x4d: case 0xac: /* ORA AND EOR LDY abs */
+            case 0xad: case 0xae: case 0xcc: case 0xcd: /* LDA LDX CPY CMP abs */
+            case 0xec:                                  /* CPX abs */
+                len = (op & 0x08) ? 3 : 2;
+                read = 1;
+                break;
+            default:
+                return 0;
+        }
+
+        lo = len > 1 ? idle_loop_fetch(drv, pc + offset + 1) : 0;
+        hi = len > 2 ? idle_loop_fetch(drv, pc + offset + 2) : 0;
+        if (lo < 0 || hi < 0) {
+            return 0;
+        }
+
+        if (read) {
+            addr = (unsigned int)(lo | (hi << 8));
+            stable = drv->cpud->stable_tab[addr >> 8];
+            if (stable == NULL || (now && !stable(drv, (uint16_t)addr))) {
+                return 0;
+            }
+        }
+
+        insns |= (uint32_t)1 << offset;
+        offset += len;
+    }
+
+    return offset == span ? insns : 0;
+}
+
+/* Return nonzero if the drive CPU cannot take an interrupt right now.  An
+   IRQ that is held off by the I flag stays pending until it is acked.  */
+inline static int idle_loop_quiet(drivecpu_context_t *cpu)
+{
+    unsigned int pending = cpu->int_status->global_pending_int;
+
+    return pending == IK_NONE
+           || ((pending & ~IK_IRQPEND) == IK_IRQ
+               && (cpu->cpu_regs.p & P_INTERRUPT));
+}
+
+/* Remember the state at the start of a round.  */
+static void idle_loop_mark(drive_context_t *drv)
+{
+    drivecpu_context_t *cpu = drv->cpu;
+
+    cpu->idle_loop_regs = cpu->cpu_regs;
+    cpu->idle_loop_opinfo = cpu->last_opcode_info;
+    cpu->idle_loop_clk = *(drv->clk_ptr);
+
+    /* No round starting now counts if an interrupt may come first.  */
+    if (idle_loop_quiet(cpu)) {
+        cpu->idle_loop_alarm_clk = alarm_context_next_pending_clk(cpu->alarm_context);
+    } else {
+        cpu->idle_loop_alarm_clk = cpu->idle_loop_clk;
+    }
+}
+
+/* Watch the loop the drive CPU has just jumped back to the start of.  */
+static void idle_loop_start(drive_context_t *drv, unsigned int span)
+{
+    drivecpu_context_t *cpu = drv->cpu;
+    unsigned int pc = cpu->cpu_regs.pc;
+    uint32_t insns;
+
+    if (span > IDLE_LOOP_MAX || pc == cpu->idle_loop_reject) {
+        return;
+    }
+
+    insns = idle_loop_decode(drv, pc, span, 0);
+    if (insns == 0) {
+        cpu->idle_loop_reject = pc;
+        return;
+    }
+
+    cpu->idle_loop_pc = pc;
+    cpu->idle_loop_span = span;
+    cpu->idle_loop_insns = insns;
+    idle_loop_mark(drv);
+}
+
+/* The drive CPU is back at the start of the loop.  If the round it has
+   just finished changed nothing, skip the ones that would follow.  */
+static void idle_loop_round(drive_context_t *drv)
+{
+    drivecpu_context_t *cpu = drv->cpu;
+    mos6510_regs_t *regs = &(cpu->cpu_regs);
+    mos6510_regs_t *last = &(cpu->idle_loop_regs);
+    CLOCK clk = *(drv->clk_ptr);
+    CLOCK len = clk - cpu->idle_loop_clk;
+    CLOCK limit, skipped;
+
+    if (cpu->idle_loop_alarm_clk > clk
+        && idle_loop_quiet(cpu)
+        && cpu->last_opcode_info == cpu->idle_loop_opinfo
+        && regs->a == last->a && regs->x == last->x && regs->y == last->y
+        && regs->sp == last->sp && regs->p == last->p
+        && regs->n == last->n && regs->z == last->z
+        && !drivethread_active
+        && drv->cpud->read_func_ptr == drv->cpud->read_tab[0]
+#ifdef DEBUG
+        && !debug.drivecpu_traceflg[drv->mynumber]
+#endif
+        ) {
+        /* The opcode at the start of the loop is executed right after
+           this, so stop short of the end of the time slice.  */
+        limit = alarm_context_next_pending_clk(cpu->alarm_context);
+        if (limit > cpu->stop_clk - 1) {
+            limit = cpu->stop_clk - 1;
+        }
+        if (limit > clk && limit - clk >= len
+            && idle_loop_decode(drv, cpu->idle_loop_pc, cpu->idle_loop_span, 1) != 0) {
+            skipped = (limit - clk) / len * len;
+            clk += skipped;
+            *(drv->clk_ptr) = clk;
+            if (drv->cpud->skipped_func != NULL) {
+                drv->cpud->skipped_func(drv, cpu->idle_loop_clk, skipped);
+            }
+        }
+    }
+
+    idle_loop_mark(drv);
+}
+
+/* Called before each opcode.  */
+inline static void idle_loop_check(drive_context_t *drv)
+{
+    drivecpu_context_t *cpu = drv->cpu;
+    unsigned int offset, op;
+
+    if (cpu->idle_loop_span != 0) {
+        offset = (cpu->cpu_regs.pc - cpu->idle_loop_pc) & 0xffff;
+        if (offset == 0) {
+            idle_loop_round(drv);
+            return;
+        }
+        if (offset < cpu->idle_loop_span
+            && (cpu->idle_loop_insns >> offset) & 1) {
+            return;
+        }
+        cpu->idle_loop_span = 0;
+    }
+
+    /* Taken branch or JMP back to an earlier address?  */
+    op = OPINFO_NUMBER(cpu->last_opcode_info);
+    if ((op & 0x1f) == 0x10 || op == 0x4c) {
+        offset = (cpu->last_opcode_addr - cpu->cpu_regs.pc) & 0xffff;
+        if (offset < IDLE_LOOP_MAX) {
+            idle_loop_start(drv, offset + (op == 0x4c ? 3 : 2));
+        }
+    }
+}
+
 /* -------------------------------------------------------------------------- */
 
 /* Return nonzero if a pending NMI should be dispatched now.  This takes
@@ -402,11 +640,24 @@ void drivecpu_execute(drive_context_t *drv, CLOCK clk_value)
         cpu->cycle_accum &= 0xffff;
     }
 
+    /* The bus may have changed since the last time slice, so a round of a
+       polling loop in progress does not count.  */
+    cpu->idle_loop_alarm_clk = cpu->idle_loop_clk;
+
     /* Run drive CPU emulation until the stop_clk clock has been reached.
      * There appears to be a nasty 32-bit overflow problem here, so we
      * paper over it by only considering subtractions of 2nd complement
      * integers. */
     while ((int) (*(drv->clk_ptr) - cpu->stop_clk) < 0) {
+        /* The rest of the time slice is run after the JAM is handled.  */
+        if (cpu->jam_pending) {
+            break;
+        }
+
+        if (drivecpu_idle_loops) {
+            idle_loop_check(drv);
+        }
+
 /* Include the 6502/6510 CPU emulation core.  */
 
 #define CLK (*(drv->clk_ptr))
@@ -482,6 +733,13 @@ static void drive_jam(drive_context_t *drv)
 
     cpu = drv->cpu;
 
+    /* The dialog, the reset and the monitor must not be entered from a
+       worker thread.  */
+    if (drivethread_active) {
+        cpu->jam_pending = 1;
+        return;
+    }
+
     switch (drv->drive->type) {
         case DRIVE_TYPE_1540:
             dname = "  1540";
@@ -550,6 +808,16 @@ static void drive_jam(drive_context_t *drv)
     }
 }
 
+/* Handle a JAM the CPU ran into on a worker thread.  Called on the main
+   thread after the time slice.  */
+void drivecpu_handle_jam(drive_context_t *drv)
+{
+    if (drv->cpu->jam_pending) {
+        drv->cpu->jam_pending = 0;
+        drive_jam(drv);
+    }
+}
+
 /* ------------------------------------------------------------------------- */
 
 #define SNAP_MAJOR 1
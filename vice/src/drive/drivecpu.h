@@ -42,6 +42,9 @@ struct interrupt_cpu_status_s;
 struct monitor_interface_s;
 struct snapshot_s;
 
+/* Value of the `DriveIdleLoops' resource.  */
+extern int drivecpu_idle_loops;
+
 extern void drivecpu_setup_context(struct drive_context_s *drv, int i);
 
 extern void drivecpu_init(struct drive_context_s *drv, int type);
@@ -55,6 +58,7 @@ extern void drivecpu_trigger_reset(unsigned int dnr);
 extern void drivecpu_set_overflow(struct drive_context_s *drv);
 
 extern void drivecpu_execute(struct drive_context_s *drv, CLOCK clk_value);
+extern void drivecpu_handle_jam(struct drive_context_s *drv);
 extern int drivecpu_snapshot_write_module(struct drive_context_s *drv,
                                           struct snapshot_s *s);
 extern int drivecpu_snapshot_read_module(struct drive_context_s *drv,
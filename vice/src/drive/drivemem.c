@@ -143,9 +143,30 @@ void drivemem_set_func(drivecpud_context_t *cpud,
     for (i = start; i < stop; i++) {
         cpud->read_base_tab[0][i] = base ? (base - (start << 8)) : NULL;
         cpud->read_limit_tab[0][i] = limit;
+        cpud->stable_tab[i] = NULL;
     }
 }
 
+/* Mark reads from the pages `start' to `stop' as free of side effects
+   (as far as `stable_func' says so), which lets the drive CPU skip loops
+   that only poll them.  Must be called after drivemem_set_func().  */
+void drivemem_set_stable_func(drivecpud_context_t *cpud,
+                              unsigned int start, unsigned int stop,
+                              drive_stable_func_t *stable_func)
+{
+    unsigned int i;
+
+    for (i = start; i < stop; i++) {
+        cpud->stable_tab[i] = stable_func;
+    }
+}
+
+/* Stable read function for plain RAM and ROM.  */
+int drivemem_stable_memory(drive_context_t *drv, uint16_t addr)
+{
+    return 1;
+}
+
 /* ------------------------------------------------------------------------- */
 /* This is the external interface for banked memory access.  */
 
@@ -187,6 +208,7 @@ void drivemem_init(drive_context_t *drv, unsigned int type)
     }
 
     drivemem_set_func(drv->cpud, 0x00, 0x101, drive_read_free, drive_store_free, drive_peek_free, NULL, 0);
+    drv->cpud->skipped_func = NULL;
 
     machine_drive_mem_init(drv, type);
 
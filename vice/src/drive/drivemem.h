@@ -45,6 +45,10 @@ extern void drivemem_set_func(struct drivecpud_context_s *cpud,
                               drive_store_func_t *store_func,
                               drive_peek_func_t *peek_func,
                               uint8_t *base, uint32_t limit);
+extern void drivemem_set_stable_func(struct drivecpud_context_s *cpud,
+                                     unsigned int start, unsigned int stop,
+                                     drive_stable_func_t *stable_func);
+extern int drivemem_stable_memory(struct drive_context_s *drv, uint16_t addr);
 
 extern struct mem_ioreg_list_s *drivemem_ioreg_list_get(void *context);
 
@@ -0,0 +1,347 @@
+/*
+ * drivethread.c - Run true drive emulation on worker threads.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/* When enabled, every drive CPU that has to catch up with the main CPU is
+   run on its own worker thread while the main thread waits.  Drives only
+   influence each other (and the machine) through the bus callbacks, so
+   each of those is wrapped in DRIVETHREAD_SYNC().  A drive that reaches
+   such an access blocks until all other drives have either finished the
+   window or are blocked at a later point in time; accesses are therefore
+   performed one at a time in (time, drive number) order, which keeps the
+   result deterministic.  Drives that do not touch the bus during a window
+   run fully in parallel.  */
+
+#include "vice.h"
+
+#include <stdio.h>
+
+#include "drive-check.h"
+#include "drive.h"
+#include "drivecpu.h"
+#include "drivethread.h"
+#include "drivetypes.h"
+#include "log.h"
+#include "monitor.h"
+#include "types.h"
+
+#ifdef USE_WORKER_THREADS
+#include <pthread.h>
+#endif
+
+int drivethread_enabled = 0;
+int drivethread_active = 0;
+
+#ifdef USE_WORKER_THREADS
+
+/* Windows shorter than this many main CPU cycles are not worth the thread
+   handoff and are executed inline.  */
+#define DRIVETHREAD_MIN_CYCLES  2000
+
+#define DRIVETHREAD_IDLE     0
+#define DRIVETHREAD_RUNNING  1
+#define DRIVETHREAD_WAITING  2
+
+typedef struct drivethread_s {
+    pthread_t thread;
+    int created;
+
+    /* One of DRIVETHREAD_IDLE, _RUNNING or _WAITING.  */
+    int state;
+
+    /* Window number this thread has last picked up.  */
+    unsigned int window;
+
+    /* Drive clock at the start of the window.  */
+    CLOCK start_clk;
+
+    /* Position within the window (in main CPU cycles) of the bus access
+       this thread is waiting for.  */
+    CLOCK pos;
+} drivethread_t;
+
+static drivethread_t threads[DRIVE_NUM];
+
+static pthread_mutex_t drivethread_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t drivethread_cond = PTHREAD_COND_INITIALIZER;
+
+static unsigned int window_count = 0;
+static unsigned int window_mask = 0;
+static CLOCK window_clk = 0;
+static int quit = 0;
+
+static log_t drivethread_log = LOG_ERR;
+
+static void *drivethread_main(void *arg)
+{
+    unsigned int dnr = vice_ptr_to_uint(arg);
+    drivethread_t *t = &threads[dnr];
+
+    pthread_mutex_lock(&drivethread_lock);
+
+    for (;;) {
+        while (!quit && t->window == window_count) {
+            pthread_cond_wait(&drivethread_cond, &drivethread_lock);
+        }
+        if (quit) {
+            break;
+        }
+        t->window = window_count;
+
+        if (!(window_mask & (1 << dnr))) {
+            continue;
+        }
+
+        pthread_mutex_unlock(&drivethread_lock);
+        drive_cpu_execute_one(drive_context[dnr], window_clk);
+        pthread_mutex_lock(&drivethread_lock);
+
+        t->state = DRIVETHREAD_IDLE;
+        pthread_cond_broadcast(&drivethread_cond);
+    }
+
+    pthread_mutex_unlock(&drivethread_lock);
+
+    return NULL;
+}
+
+/* Check whether drive `dnr' can be run on a worker thread.  */
+static int drivethread_drive_ok(unsigned int dnr)
+{
+    drive_context_t *drv = drive_context[dnr];
+
+    if (!drive_check_iec(drv->drive->type)) {
+        return 0;
+    }
+
+    /* The monitor and the image extension dialog must only be entered from
+       the main thread.  */
+    if (monitor_mask[drv->cpu->monspace] != MI_NONE) {
+        return 0;
+    }
+    if (drv->drive->extend_image_policy == DRIVE_EXTEND_ASK) {
+        return 0;
+    }
+
+    return 1;
+}
+
+static int drivethread_create(unsigned int dnr)
+{
+    drivethread_t *t = &threads[dnr];
+
+    if (t->created) {
+        return 0;
+    }
+
+    if (drivethread_log == LOG_ERR) {
+        drivethread_log = log_open("DriveThread");
+    }
+
+    t->window = window_count;
+    t->state = DRIVETHREAD_IDLE;
+
+    if (pthread_create(&t->thread, NULL, drivethread_main,
+                       uint_to_void_ptr(dnr)) != 0) {
+        log_error(drivethread_log, "Cannot create worker thread for drive %u.",
+                  dnr + 8);
+        return -1;
+    }
+    t->created = 1;
+
+    return 0;
+}
+
+/* Execute the drives in `mask' up to `clk_value' on the worker threads.
+   Return -1 if the caller has to execute them itself.  */
+int drivethread_execute(unsigned int mask, CLOCK clk_value)
+{
+    unsigned int dnr, count = 0;
+    CLOCK cycles = 0;
+    int busy;
+
+    if (!drivethread_enabled) {
+        return -1;
+    }
+
+    for (dnr = 0; dnr < DRIVE_NUM; dnr++) {
+        if (mask & (1 << dnr)) {
+            drive_context_t *drv = drive_context[dnr];
+
+            if (!drivethread_drive_ok(dnr)) {
+                return -1;
+            }
+            if (clk_value > drv->cpu->last_clk
+                && clk_value - drv->cpu->last_clk > cycles) {
+                cycles = clk_value - drv->cpu->last_clk;
+            }
+            count++;
+        }
+    }
+
+    if (count < 2 || cycles < DRIVETHREAD_MIN_CYCLES) {
+        return -1;
+    }
+
+    for (dnr = 0; dnr < DRIVE_NUM; dnr++) {
+        if ((mask & (1 << dnr)) && drivethread_create(dnr) < 0) {
+            return -1;
+        }
+    }
+
+    pthread_mutex_lock(&drivethread_lock);
+
+    for (dnr = 0; dnr < DRIVE_NUM; dnr++) {
+        if (mask & (1 << dnr)) {
+            threads[dnr].state = DRIVETHREAD_RUNNING;
+            threads[dnr].start_clk = *(drive_context[dnr]->clk_ptr);
+        }
+    }
+
+    window_mask = mask;
+    window_clk = clk_value;
+    window_count++;
+    drivethread_active = 1;
+
+    pthread_cond_broadcast(&drivethread_cond);
+
+    do {
+        busy = 0;
+        for (dnr = 0; dnr < DRIVE_NUM; dnr++) {
+            if ((mask & (1 << dnr))
+                && threads[dnr].state != DRIVETHREAD_IDLE) {
+                busy = 1;
+            }
+        }
+        if (busy) {
+            pthread_cond_wait(&drivethread_cond, &drivethread_lock);
+        }
+    } while (busy);
+
+    drivethread_active = 0;
+    window_mask = 0;
+
+    pthread_mutex_unlock(&drivethread_lock);
+
+    /* Drives that jammed stopped early, handle the JAM and run the rest of
+       the window here.  */
+    for (dnr = 0; dnr < DRIVE_NUM; dnr++) {
+        if ((mask & (1 << dnr)) && drive_context[dnr]->cpu->jam_pending) {
+            drivecpu_handle_jam(drive_context[dnr]);
+            drive_cpu_execute_one(drive_context[dnr], clk_value);
+        }
+    }
+
+    return 0;
+}
+
+/* Return nonzero if the access of drive `dnr' is the next one due.  */
+static int drivethread_may_proceed(unsigned int dnr)
+{
+    unsigned int i;
+    drivethread_t *t = &threads[dnr];
+
+    for (i = 0; i < DRIVE_NUM; i++) {
+        drivethread_t *o = &threads[i];
+
+        if (i == dnr || !(window_mask & (1 << i))) {
+            continue;
+        }
+        if (o->state == DRIVETHREAD_RUNNING) {
+            return 0;
+        }
+        if (o->state == DRIVETHREAD_WAITING
+            && (o->pos < t->pos || (o->pos == t->pos && i < dnr))) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+void drivethread_sync(drive_context_t *drv)
+{
+    unsigned int dnr = drv->mynumber;
+    drivethread_t *t = &threads[dnr];
+    int sync_factor = drv->cpud->sync_factor;
+    unsigned long elapsed;
+
+    if (!(window_mask & (1 << dnr))) {
+        return;
+    }
+
+    /* Convert the drive cycles run so far into main CPU cycles.  */
+    elapsed = (unsigned long)(*(drv->clk_ptr) - t->start_clk);
+    if (sync_factor != 0) {
+        elapsed = (unsigned long)(((double)elapsed * 65536.0) / sync_factor);
+    }
+
+    pthread_mutex_lock(&drivethread_lock);
+
+    t->pos = (CLOCK)elapsed;
+    t->state = DRIVETHREAD_WAITING;
+    pthread_cond_broadcast(&drivethread_cond);
+
+    while (!drivethread_may_proceed(dnr)) {
+        pthread_cond_wait(&drivethread_cond, &drivethread_lock);
+    }
+
+    t->state = DRIVETHREAD_RUNNING;
+
+    pthread_mutex_unlock(&drivethread_lock);
+}
+
+void drivethread_shutdown(void)
+{
+    unsigned int dnr;
+
+    pthread_mutex_lock(&drivethread_lock);
+    quit = 1;
+    pthread_cond_broadcast(&drivethread_cond);
+    pthread_mutex_unlock(&drivethread_lock);
+
+    for (dnr = 0; dnr < DRIVE_NUM; dnr++) {
+        if (threads[dnr].created) {
+            pthread_join(threads[dnr].thread, NULL);
+            threads[dnr].created = 0;
+        }
+    }
+
+    quit = 0;
+}
+
+#else
+
+int drivethread_execute(unsigned int mask, CLOCK clk_value)
+{
+    return -1;
+}
+
+void drivethread_sync(drive_context_t *drv)
+{
+}
+
+void drivethread_shutdown(void)
+{
+}
+
+#endif
@@ -0,0 +1,52 @@
+/*
+ * drivethread.h - Run true drive emulation on worker threads.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#ifndef VICE_DRIVETHREAD_H
+#define VICE_DRIVETHREAD_H
+
+#include "types.h"
+
+struct drive_context_s;
+
+/* Value of the `DriveWorkerThreads' resource.  */
+extern int drivethread_enabled;
+
+/* Nonzero while drive CPUs are being executed on the worker threads.  */
+extern int drivethread_active;
+
+extern int drivethread_execute(unsigned int mask, CLOCK clk_value);
+extern void drivethread_sync(struct drive_context_s *drv);
+extern void drivethread_shutdown(void);
+
+/* Every piece of drive code that touches state shared with the machine or
+   with other drives (serial/parallel bus lines, fast serial, drive sound)
+   must be wrapped in this, so the access is ordered against the other
+   drives when they run on worker threads.  */
+#define DRIVETHREAD_SYNC(drv)          \
+    do {                               \
+        if (drivethread_active) {      \
+            drivethread_sync(drv);     \
+        }                              \
+    } while (0)
+
+#endif
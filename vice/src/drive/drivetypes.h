@@ -51,6 +51,8 @@ typedef void drive_store_func_t (struct drive_context_s *, uint16_t, uint8_t);
 typedef drive_store_func_t *drive_store_func_ptr_t;
 typedef uint8_t drive_peek_func_t (struct drive_context_s *, uint16_t);
 typedef drive_peek_func_t *drive_peek_func_ptr_t;
+typedef int drive_stable_func_t (struct drive_context_s *, uint16_t);
+typedef void drive_skipped_func_t (struct drive_context_s *, CLOCK, CLOCK);
 
 /*
  *  The private CPU data.
@@ -92,6 +94,24 @@ typedef struct drivecpu_context_s {
     /* Address of the last executed opcode. This is used by watchpoints. */
     unsigned int last_opcode_addr;
 
+    /* Polling loop being watched, see drivecpu.c.  `idle_loop_span' is 0
+       if there is none, bit n of `idle_loop_insns' is set for each opcode
+       at `idle_loop_pc' + n.  */
+    unsigned int idle_loop_pc;
+    unsigned int idle_loop_span;
+    uint32_t idle_loop_insns;
+    unsigned int idle_loop_reject;
+
+    /* State at the start of the last round of the loop.  */
+    mos6510_regs_t idle_loop_regs;
+    unsigned int idle_loop_opinfo;
+    CLOCK idle_loop_clk;
+    CLOCK idle_loop_alarm_clk;
+
+    /* Set if the CPU jammed on a worker thread, the JAM is then handled
+       on the main thread once the time slice is over.  */
+    int jam_pending;
+
     /* Public copy of the registers.  */
     mos6510_regs_t cpu_regs;
     R65C02_regs_t cpu_R65C02_regs;
@@ -127,6 +147,16 @@ typedef struct drivecpud_context_s {
     uint8_t *read_base_tab[1][0x101];
     uint32_t read_limit_tab[1][0x101];
 
+    /* Per page, a function telling whether reading an address has no side
+       effects and yields the same value until the next drive alarm or the
+       next change on the bus, or NULL if that is never the case.  */
+    drive_stable_func_t *stable_tab[0x101];
+
+    /* Called with the start of the last round and the number of cycles
+       when the CPU has skipped a loop reading stable addresses, so the
+       chips can move the time of the last read on.  */
+    drive_skipped_func_t *skipped_func;
+
     int sync_factor;
 } drivecpud_context_t;
 
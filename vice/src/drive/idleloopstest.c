@@ -0,0 +1,787 @@
+/*
+ * idleloopstest.c - Compare stepping with skipping drive polling loops.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/* Run by `make check'.  Two drives with a drive CPU and a serial bus VIA
+   run the same fast loader like program side by side, one stepping
+   through every polling loop and one with `DriveIdleLoops' skipping them.
+   The program waits on the bus, on the VIA interrupt flags and on VIA
+   interrupts, and writes to the bus.  Both drives get the same time
+   slices, of random length, and the same bus input, which changes between
+   slices.  After every slice, the whole state of the CPUs, their
+   interrupt status, RAM, VIAs and VIA alarms, and the rotation and port
+   writes seen so far, must be the same, to the cycle.  The test runs with
+   several timer setups, with and without the disk rotating, and fails at
+   the first difference, or if no cycles were skipped at all.
+
+   The CPU, VIA, alarm and interrupt code is included here, the rest of
+   the drive is replaced by the stubs below.  */
+
+#include "alarm.c"
+#include "clkguard.c"
+#include "interrupt.c"
+#include "core/viacore.c"
+#include "drivecpu.c"
+
+/* Time slices per setup.  */
+#define IDLELOOPSTEST_SLICES  20000
+
+/* ------------------------------------------------------------------------- */
+/* Stubs.  */
+
+CLOCK maincpu_clk = 0;
+interrupt_cpu_status_t *maincpu_int_status = NULL;
+int drivethread_active = 0;
+int benchmark_enabled = 0;
+unsigned monitor_mask[NUM_MEMSPACES];
+
+void benchmark_enter(int subsystem)
+{
+}
+
+void benchmark_leave(void)
+{
+}
+
+void *lib_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+void *lib_calloc(size_t nmemb, size_t size)
+{
+    return calloc(nmemb, size);
+}
+
+void *lib_realloc(void *p, size_t size)
+{
+    return realloc(p, size);
+}
+
+void lib_free(const void *ptr)
+{
+    free((void *)ptr);
+}
+
+char *lib_stralloc(const char *str)
+{
+    return strcpy(malloc(strlen(str) + 1), str);
+}
+
+char *lib_msprintf(const char *fmt, ...)
+{
+    return lib_stralloc(fmt);
+}
+
+log_t log_open(const char *id)
+{
+    return LOG_DEFAULT;
+}
+
+int log_message(log_t log, const char *format, ...)
+{
+    return 0;
+}
+
+int log_error(log_t log, const char *format, ...)
+{
+    printf("%s\n", format);
+    return 0;
+}
+
+unsigned int machine_jam(const char *format, ...)
+{
+    printf("The drive CPU jammed.\n");
+    exit(EXIT_FAILURE);
+}
+
+void machine_trigger_reset(const unsigned int mode)
+{
+}
+
+void machine_drive_shutdown(struct drive_context_s *drv)
+{
+}
+
+void drive_cpu_execute_all(CLOCK clk_value)
+{
+}
+
+unsigned int drive_check_old(unsigned int type)
+{
+    return 0;
+}
+
+void rotation_reset(drive_t *drive)
+{
+}
+
+uint8_t drivemem_bank_read(int bank, uint16_t addr, void *context)
+{
+    return 0;
+}
+
+uint8_t drivemem_bank_peek(int bank, uint16_t addr, void *context)
+{
+    return 0;
+}
+
+void drivemem_bank_store(int bank, uint16_t addr, uint8_t value, void *context)
+{
+}
+
+mem_ioreg_list_t *drivemem_ioreg_list_get(void *context)
+{
+    return NULL;
+}
+
+void drivemem_toggle_watchpoints(int flag, void *context)
+{
+}
+
+void drivemem_init(struct drive_context_s *drv, unsigned int type)
+{
+}
+
+monitor_interface_t *monitor_interface_new(void)
+{
+    return calloc(1, sizeof(monitor_interface_t));
+}
+
+void monitor_interface_destroy(monitor_interface_t *monitor_interface)
+{
+}
+
+int monitor_diskspace_mem(int dnr)
+{
+    return 0;
+}
+
+void monitor_startup(MEMSPACE mem)
+{
+}
+
+int monitor_force_import(MEMSPACE mem)
+{
+    return 0;
+}
+
+int monitor_check_breakpoints(MEMSPACE mem, uint16_t addr)
+{
+    return 0;
+}
+
+void monitor_check_icount(uint16_t a)
+{
+}
+
+void monitor_check_icount_interrupt(void)
+{
+}
+
+void monitor_check_watchpoints(unsigned int lastpc, unsigned int pc)
+{
+}
+
+int mon_out(const char *format, ...)
+{
+    return 0;
+}
+
+snapshot_module_t *snapshot_module_create(snapshot_t *s, const char *name,
+                                          uint8_t major_version,
+                                          uint8_t minor_version)
+{
+    return NULL;
+}
+
+snapshot_module_t *snapshot_module_open(snapshot_t *s, const char *name,
+                                        uint8_t *major_version_return,
+                                        uint8_t *minor_version_return)
+{
+    return NULL;
+}
+
+int snapshot_module_close(snapshot_module_t *m)
+{
+    return -1;
+}
+
+int snapshot_module_write_byte(snapshot_module_t *m, uint8_t data)
+{
+    return -1;
+}
+
+int snapshot_module_write_word(snapshot_module_t *m, uint16_t data)
+{
+    return -1;
+}
+
+int snapshot_module_write_dword(snapshot_module_t *m, uint32_t data)
+{
+    return -1;
+}
+
+int snapshot_module_write_byte_array(snapshot_module_t *m, const uint8_t *data,
+                                     unsigned int num)
+{
+    return -1;
+}
+
+int snapshot_module_read_byte(snapshot_module_t *m, uint8_t *b_return)
+{
+    return -1;
+}
+
+int snapshot_module_read_word(snapshot_module_t *m, uint16_t *w_return)
+{
+    return -1;
+}
+
+int snapshot_module_read_dword(snapshot_module_t *m, uint32_t *dw_return)
+{
+    return -1;
+}
+
+int snapshot_module_read_byte_array(snapshot_module_t *m, uint8_t *b_return,
+                                    unsigned int num)
+{
+    return -1;
+}
+
+int snapshot_module_read_dword_into_int(snapshot_module_t *m, int *value_return)
+{
+    return -1;
+}
+
+int snapshot_module_read_dword_into_uint(snapshot_module_t *m,
+                                         unsigned int *value_return)
+{
+    return -1;
+}
+
+/* ------------------------------------------------------------------------- */
+/* The drives.  */
+
+typedef struct test_drive_s {
+    drive_context_t context;
+    drive_t drive;
+    uint8_t ram[0x800];
+    uint8_t rom[0x4000];
+
+    /* Rotations of the disk and port writes so far, and a hash of their
+       clocks and values.  */
+    unsigned long rotations;
+    unsigned long writes;
+    unsigned long hash;
+
+    /* Drive cycles skipped.  */
+    CLOCK skipped;
+} test_drive_t;
+
+static test_drive_t drives[2];
+
+/* Input of VIA port B, the same for both drives.  */
+static uint8_t bus;
+
+static void test_hash(test_drive_t *t, unsigned int value)
+{
+    t->hash = t->hash * 33 + value + (unsigned long)(*t->drive.clk) * 7;
+}
+
+void rotation_rotate_disk(drive_t *dptr)
+{
+    test_drive_t *t = &drives[dptr->mynumber];
+
+    if ((dptr->byte_ready_active & 4) == 0) {
+        dptr->req_ref_cycles = 0;
+        return;
+    }
+
+    t->rotations++;
+    test_hash(t, 0x10000);
+}
+
+void machine_drive_reset(struct drive_context_s *drv)
+{
+    viacore_reset(drv->via1d1541);
+}
+
+static uint8_t test_read_ram(drive_context_t *drv, uint16_t addr)
+{
+    return drives[drv->mynumber].ram[addr & 0x7ff];
+}
+
+static void test_store_ram(drive_context_t *drv, uint16_t addr, uint8_t value)
+{
+    drives[drv->mynumber].ram[addr & 0x7ff] = value;
+}
+
+static uint8_t test_read_rom(drive_context_t *drv, uint16_t addr)
+{
+    return drives[drv->mynumber].rom[addr & 0x3fff];
+}
+
+static uint8_t test_read_free(drive_context_t *drv, uint16_t addr)
+{
+    return (uint8_t)(addr >> 8);
+}
+
+static void test_store_free(drive_context_t *drv, uint16_t addr, uint8_t value)
+{
+}
+
+static uint8_t test_read_via(drive_context_t *drv, uint16_t addr)
+{
+    return viacore_read(drv->via1d1541, addr);
+}
+
+static void test_store_via(drive_context_t *drv, uint16_t addr, uint8_t value)
+{
+    viacore_store(drv->via1d1541, addr, value);
+}
+
+static int test_stable_memory(drive_context_t *drv, uint16_t addr)
+{
+    return 1;
+}
+
+static int test_stable_via(drive_context_t *drv, uint16_t addr)
+{
+    return viacore_read_stable(drv->via1d1541, addr);
+}
+
+static void test_skipped_via(drive_context_t *drv, CLOCK since, CLOCK cycles)
+{
+    drives[drv->mynumber].skipped += cycles;
+    viacore_read_skipped(drv->via1d1541, since, cycles);
+}
+
+static void test_via_store_port(via_context_t *via_context, uint8_t byte,
+                           uint8_t oldpb, uint16_t addr)
+{
+    drive_context_t *drv = (drive_context_t *)(via_context->context);
+    test_drive_t *t = &drives[drv->mynumber];
+
+    t->writes++;
+    test_hash(t, (unsigned int)(addr << 8) | byte);
+}
+
+static uint8_t test_via_store_pcr(via_context_t *via_context, uint8_t byte,
+                             uint16_t addr)
+{
+    return byte;
+}
+
+static void test_via_store_nothing(via_context_t *via_context, uint8_t byte)
+{
+}
+
+static uint8_t test_via_read_pra(via_context_t *via_context, uint16_t addr)
+{
+    return 0xff;
+}
+
+static uint8_t test_via_read_prb(via_context_t *via_context)
+{
+    return bus;
+}
+
+static void test_via_set_int(via_context_t *via_context, unsigned int int_num,
+                        int value, CLOCK rclk)
+{
+    drive_context_t *drv = (drive_context_t *)(via_context->context);
+
+    interrupt_set_irq(drv->cpu->int_status, int_num, value, rclk);
+}
+
+static void test_via_restore_int(via_context_t *via_context, unsigned int int_num,
+                            int value)
+{
+    drive_context_t *drv = (drive_context_t *)(via_context->context);
+
+    interrupt_restore_irq(drv->cpu->int_status, int_num, value);
+}
+
+static void test_via_set_line(via_context_t *via_context, int state)
+{
+}
+
+static void test_via_reset(via_context_t *via_context)
+{
+}
+
+static void test_map(drive_context_t *drv, unsigned int start,
+                     unsigned int stop, drive_read_func_t *read_func,
+                     drive_store_func_t *store_func, uint8_t *base,
+                     drive_stable_func_t *stable_func)
+{
+    unsigned int i;
+
+    for (i = start; i < stop; i++) {
+        drv->cpud->read_tab[0][i] = read_func;
+        drv->cpud->store_tab[0][i] = store_func;
+        drv->cpud->peek_tab[0][i] = read_func;
+        drv->cpud->read_base_tab[0][i] = base ? base - (start << 8) : NULL;
+        drv->cpud->read_limit_tab[0][i] =
+            base ? (start << 24) | ((stop << 8) - 3) : 0;
+        drv->cpud->stable_tab[i] = stable_func;
+    }
+}
+
+/* The program, at $c000 and $c0f8.  The first VIA setup is read from
+   $fff0: ACR, timer 1 latch low and high, IER.  */
+static const uint8_t test_code[] = {
+    /* reset: */
+    0x78,                /* c000  SEI        */
+    0xa2, 0xff,          /* c001  LDX #$FF   */
+    0x9a,                /* c003  TXS        */
+    0xa9, 0x00,          /* c004  LDA #$00   */
+    0x85, 0x10,          /* c006  STA $10    */
+    0x85, 0x11,          /* c008  STA $11    */
+    0xa9, 0x70,          /* c00a  LDA #$70   */
+    0x8d, 0x02, 0x18,    /* c00c  STA $1802  */
+    0xad, 0xf0, 0xff,    /* c00f  LDA $FFF0  */
+    0x8d, 0x0b, 0x18,    /* c012  STA $180B  */
+    0xad, 0xf1, 0xff,    /* c015  LDA $FFF1  */
+    0x8d, 0x04, 0x18,    /* c018  STA $1804  */
+    0xad, 0xf2, 0xff,    /* c01b  LDA $FFF2  */
+    0x8d, 0x05, 0x18,    /* c01e  STA $1805  */
+    0xad, 0xf3, 0xff,    /* c021  LDA $FFF3  */
+    0x8d, 0x0e, 0x18,    /* c024  STA $180E  */
+    /* main: wait for bus bit 2, write the counter at $10 to the bus */
+    0xad, 0x00, 0x18,    /* c027  LDA $1800  */
+    0x29, 0x04,          /* c02a  AND #$04   */
+    0xf0, 0xf9,          /* c02c  BEQ $C027  */
+    0xe6, 0x10,          /* c02e  INC $10    */
+    0xa5, 0x10,          /* c030  LDA $10    */
+    0x8d, 0x00, 0x18,    /* c032  STA $1800  */
+    /* wait for bus bit 7 to clear */
+    0x2c, 0x00, 0x18,    /* c035  BIT $1800  */
+    0x30, 0xfb,          /* c038  BMI $C035  */
+    0xa4, 0x10,          /* c03a  LDY $10    */
+    /* wait for the timer 1 flag, clear it */
+    0xad, 0x0d, 0x18,    /* c03c  LDA $180D  */
+    0x29, 0x40,          /* c03f  AND #$40   */
+    0xf0, 0xf9,          /* c041  BEQ $C03C  */
+    0xad, 0x04, 0x18,    /* c043  LDA $1804  */
+    /* wait for bus bit 7 or 1 with interrupts enabled */
+    0x58,                /* c046  CLI        */
+    0xad, 0x00, 0x18,    /* c047  LDA $1800  */
+    0x30, 0x07,          /* c04a  BMI $C053  */
+    0x29, 0x02,          /* c04c  AND #$02   */
+    0xd0, 0x03,          /* c04e  BNE $C053  */
+    0x4c, 0x47, 0xc0,    /* c050  JMP $C047  */
+    0x78,                /* c053  SEI        */
+    0x4c, 0xf8, 0xc0     /* c054  JMP $C0F8  */
+};
+
+static const uint8_t test_code_c0f8[] = {
+    0xea,                /* c0f8  NOP        */
+    0xea,                /* c0f9  NOP        */
+    0xea,                /* c0fa  NOP        */
+    0xea,                /* c0fb  NOP        */
+    /* wait for bus bit 0 across a page boundary */
+    0xad, 0x00, 0x18,    /* c0fc  LDA $1800  */
+    0x29, 0x01,          /* c0ff  AND #$01   */
+    0xf0, 0xf9,          /* c101  BEQ $C0FC  */
+    0x8d, 0x01, 0x18,    /* c103  STA $1801  */
+    /* wait for bus bit 3, reading the bus twice */
+    0xae, 0x00, 0x18,    /* c106  LDX $1800  */
+    0xad, 0x00, 0x18,    /* c109  LDA $1800  */
+    0x29, 0x08,          /* c10c  AND #$08   */
+    0xf0, 0xf6,          /* c10e  BEQ $C106  */
+    0x8e, 0x01, 0x18,    /* c110  STX $1801  */
+    /* a delay loop that changes X */
+    0xa2, 0x05,          /* c113  LDX #$05   */
+    0xca,                /* c115  DEX        */
+    0xd0, 0xfd,          /* c116  BNE $C115  */
+    0x4c, 0x27, 0xc0,    /* c118  JMP $C027  */
+    /* irq: clear the timer 1 flag, write the counter at $11 to the bus */
+    0x48,                /* c11b  PHA        */
+    0xad, 0x04, 0x18,    /* c11c  LDA $1804  */
+    0xe6, 0x11,          /* c11f  INC $11    */
+    0xa5, 0x11,          /* c121  LDA $11    */
+    0x8d, 0x00, 0x18,    /* c123  STA $1800  */
+    0x68,                /* c126  PLA        */
+    0x40                 /* c127  RTI        */
+};
+
+static void test_drive_init(int number, const uint8_t *setup,
+                            int byte_ready_active)
+{
+    test_drive_t *t = &drives[number];
+    drive_context_t *drv = &t->context;
+    via_context_t *via;
+
+    memset(t, 0, sizeof(test_drive_t));
+
+    drv->mynumber = number;
+    drv->clk_ptr = &drive_clk[number];
+    drv->drive = &t->drive;
+    t->drive.mynumber = number;
+    t->drive.clk = &drive_clk[number];
+    t->drive.byte_ready_active = byte_ready_active;
+    drive_clk[number] = 0;
+
+    drivecpu_setup_context(drv, 1);
+    drv->cpud->sync_factor = 0x10000;
+    drv->cpu->pageone = t->ram + 0x100;
+
+    memset(t->rom, 0xea, sizeof(t->rom));
+    memcpy(t->rom, test_code, sizeof(test_code));
+    memcpy(t->rom + 0xf8, test_code_c0f8, sizeof(test_code_c0f8));
+    memcpy(t->rom + 0x3ff0, setup, 4);
+    t->rom[0x3ffc] = 0x00;
+    t->rom[0x3ffd] = 0xc0;
+    t->rom[0x3ffe] = 0x1b;
+    t->rom[0x3fff] = 0xc1;
+
+    test_map(drv, 0x00, 0x08, test_read_ram, test_store_ram, t->ram,
+             test_stable_memory);
+    test_map(drv, 0x08, 0x18, test_read_free, test_store_free, NULL, NULL);
+    test_map(drv, 0x18, 0x1c, test_read_via, test_store_via, NULL,
+             test_stable_via);
+    test_map(drv, 0x1c, 0xc0, test_read_free, test_store_free, NULL, NULL);
+    test_map(drv, 0xc0, 0x100, test_read_rom, test_store_free, t->rom,
+             test_stable_memory);
+    test_map(drv, 0x100, 0x101, test_read_ram, test_store_ram, NULL, NULL);
+    drv->cpud->read_func_ptr = drv->cpud->read_tab[0];
+    drv->cpud->store_func_ptr = drv->cpud->store_tab[0];
+    drv->cpud->peek_func_ptr = drv->cpud->peek_tab[0];
+    drv->cpud->read_base_tab_ptr = drv->cpud->read_base_tab[0];
+    drv->cpud->read_limit_tab_ptr = drv->cpud->read_limit_tab[0];
+    drv->cpud->skipped_func = test_skipped_via;
+
+    drv->via1d1541 = lib_calloc(1, sizeof(via_context_t));
+    via = drv->via1d1541;
+    via->context = drv;
+    via->rmw_flag = &(drv->cpu->rmw_flag);
+    via->clk_ptr = drv->clk_ptr;
+    via->myname = lib_stralloc("TestVia");
+    via->my_module_name = lib_stralloc("TESTVIA");
+    viacore_setup_context(via);
+    via->irq_line = IK_IRQ;
+    via->undump_pra = test_via_store_nothing;
+    via->undump_prb = test_via_store_nothing;
+    via->undump_pcr = test_via_store_nothing;
+    via->undump_acr = test_via_store_nothing;
+    via->store_pra = test_via_store_port;
+    via->store_prb = test_via_store_port;
+    via->store_pcr = test_via_store_pcr;
+    via->store_acr = test_via_store_nothing;
+    via->store_sr = test_via_store_nothing;
+    via->store_t2l = test_via_store_nothing;
+    via->read_pra = test_via_read_pra;
+    via->read_prb = test_via_read_prb;
+    via->set_int = test_via_set_int;
+    via->restore_int = test_via_restore_int;
+    via->set_ca2 = test_via_set_line;
+    via->set_cb2 = test_via_set_line;
+    via->reset = test_via_reset;
+    viacore_init(via, drv->cpu->alarm_context, drv->cpu->int_status,
+                 drv->cpu->clk_guard);
+
+    drivecpu_reset(drv);
+}
+
+/* ------------------------------------------------------------------------- */
+/* Comparing the drives.  */
+
+#define TEST_COMPARE(what, a, b)                                         \
+    do {                                                                 \
+        if ((a) != (b)) {                                                \
+            printf("%s: stepping %lu, skipping %lu\n", what,             \
+                   (unsigned long)(a), (unsigned long)(b));              \
+            return 1;                                                    \
+        }                                                                \
+    } while (0)
+
+static CLOCK test_alarm_clk(alarm_t *alarm)
+{
+    if (alarm->pending_idx < 0) {
+        return CLOCK_MAX;
+    }
+    return alarm->context->pending_alarms[alarm->pending_idx].clk;
+}
+
+static int test_compare(void)
+{
+    test_drive_t *s = &drives[0], *k = &drives[1];
+    drivecpu_context_t *sc = s->context.cpu, *kc = k->context.cpu;
+    via_context_t *sv = s->context.via1d1541, *kv = k->context.via1d1541;
+    int i;
+
+    TEST_COMPARE("clock", drive_clk[0], drive_clk[1]);
+    TEST_COMPARE("PC", sc->cpu_regs.pc, kc->cpu_regs.pc);
+    TEST_COMPARE("A", sc->cpu_regs.a, kc->cpu_regs.a);
+    TEST_COMPARE("X", sc->cpu_regs.x, kc->cpu_regs.x);
+    TEST_COMPARE("Y", sc->cpu_regs.y, kc->cpu_regs.y);
+    TEST_COMPARE("SP", sc->cpu_regs.sp, kc->cpu_regs.sp);
+    TEST_COMPARE("P", sc->cpu_regs.p, kc->cpu_regs.p);
+    TEST_COMPARE("N", sc->cpu_regs.n, kc->cpu_regs.n);
+    TEST_COMPARE("Z", sc->cpu_regs.z, kc->cpu_regs.z);
+    TEST_COMPARE("last opcode", sc->last_opcode_info, kc->last_opcode_info);
+    TEST_COMPARE("last opcode address", sc->last_opcode_addr, kc->last_opcode_addr);
+    TEST_COMPARE("stop clock", sc->stop_clk, kc->stop_clk);
+    TEST_COMPARE("pending interrupts", sc->int_status->global_pending_int,
+                 kc->int_status->global_pending_int);
+    TEST_COMPARE("IRQ lines", sc->int_status->nirq, kc->int_status->nirq);
+    TEST_COMPARE("IRQ clock", sc->int_status->irq_clk, kc->int_status->irq_clk);
+    TEST_COMPARE("IRQ pending clock", sc->int_status->irq_pending_clk,
+                 kc->int_status->irq_pending_clk);
+    TEST_COMPARE("next alarm", alarm_context_next_pending_clk(sc->alarm_context),
+                 alarm_context_next_pending_clk(kc->alarm_context));
+
+    for (i = 0; i < (int)sizeof(s->ram); i++) {
+        TEST_COMPARE("RAM", s->ram[i], k->ram[i]);
+    }
+
+    for (i = 0; i < 16; i++) {
+        TEST_COMPARE("VIA register", sv->via[i], kv->via[i]);
+    }
+    TEST_COMPARE("VIA IFR", sv->ifr, kv->ifr);
+    TEST_COMPARE("VIA IER", sv->ier, kv->ier);
+    TEST_COMPARE("VIA T1 latch", sv->tal, kv->tal);
+    TEST_COMPARE("VIA T2 low", sv->t2cl, kv->t2cl);
+    TEST_COMPARE("VIA T2 high", sv->t2ch, kv->t2ch);
+    TEST_COMPARE("VIA T1 update", sv->tau, kv->tau);
+    TEST_COMPARE("VIA T2 update", sv->tbu, kv->tbu);
+    TEST_COMPARE("VIA T1 interrupt", sv->tai, kv->tai);
+    TEST_COMPARE("VIA T2 interrupt", sv->tbi, kv->tbi);
+    TEST_COMPARE("VIA PB7", sv->pb7, kv->pb7);
+    TEST_COMPARE("VIA PB7X", sv->pb7x, kv->pb7x);
+    TEST_COMPARE("VIA PB7O", sv->pb7o, kv->pb7o);
+    TEST_COMPARE("VIA PB7XX", sv->pb7xx, kv->pb7xx);
+    TEST_COMPARE("VIA PB7SX", sv->pb7sx, kv->pb7sx);
+    TEST_COMPARE("VIA old PA", sv->oldpa, kv->oldpa);
+    TEST_COMPARE("VIA old PB", sv->oldpb, kv->oldpb);
+    TEST_COMPARE("VIA PA latch", sv->ila, kv->ila);
+    TEST_COMPARE("VIA PB latch", sv->ilb, kv->ilb);
+    TEST_COMPARE("VIA CA2", sv->ca2_state, kv->ca2_state);
+    TEST_COMPARE("VIA CB2", sv->cb2_state, kv->cb2_state);
+    TEST_COMPARE("VIA shift state", sv->shift_state, kv->shift_state);
+    TEST_COMPARE("VIA read clock", sv->read_clk, kv->read_clk);
+    TEST_COMPARE("VIA read offset", sv->read_offset, kv->read_offset);
+    TEST_COMPARE("VIA last read", sv->last_read, kv->last_read);
+    TEST_COMPARE("VIA T1 alarm", test_alarm_clk(sv->t1_alarm),
+                 test_alarm_clk(kv->t1_alarm));
+    TEST_COMPARE("VIA T2 alarm", test_alarm_clk(sv->t2_alarm),
+                 test_alarm_clk(kv->t2_alarm));
+    TEST_COMPARE("VIA SR alarm", test_alarm_clk(sv->sr_alarm),
+                 test_alarm_clk(kv->sr_alarm));
+
+    TEST_COMPARE("rotations", s->rotations, k->rotations);
+    TEST_COMPARE("port writes", s->writes, k->writes);
+    TEST_COMPARE("rotation and port write clocks", s->hash, k->hash);
+
+    return 0;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static uint32_t seed;
+
+/* Fixed sequence, so a failure can be reproduced.  */
+static uint32_t test_random(void)
+{
+    seed = seed * 1103515245 + 12345;
+    return seed >> 8;
+}
+
+/* Run both drives with the VIA setup `setup', return nonzero if they
+   end up in different states.  */
+static int test_run(const char *name, const uint8_t *setup,
+                    int byte_ready_active)
+{
+    unsigned int slice;
+
+    seed = 1;
+    bus = 0;
+    maincpu_clk = 0;
+    test_drive_init(0, setup, byte_ready_active);
+    test_drive_init(1, setup, byte_ready_active);
+
+    for (slice = 0; slice < IDLELOOPSTEST_SLICES; slice++) {
+        /* mostly short time slices, now and then a long one */
+        if (test_random() % 4 != 0) {
+            maincpu_clk += 1 + test_random() % 50;
+        } else {
+            maincpu_clk += 1 + test_random() % 40000;
+        }
+
+        drivecpu_idle_loops = 0;
+        drivecpu_execute(&drives[0].context, maincpu_clk);
+        drivecpu_idle_loops = 1;
+        drivecpu_execute(&drives[1].context, maincpu_clk);
+
+        if (test_compare()) {
+            printf("%s%s: the drives differ after time slice %u.\n", name,
+                   byte_ready_active ? ", rotating" : "", slice);
+            return 1;
+        }
+
+        /* one of the bits the program waits for changes */
+        if (test_random() % 3 == 0) {
+            static const uint8_t bits[] = { 0x01, 0x02, 0x04, 0x08, 0x80 };
+
+            bus ^= bits[test_random() % sizeof(bits)];
+        }
+    }
+
+    printf("%s%s: same state after %u time slices, %lu of %lu cycles skipped.\n",
+           name, byte_ready_active ? ", rotating" : "", slice,
+           (unsigned long)drives[1].skipped, (unsigned long)drive_clk[1]);
+
+    return 0;
+}
+
+int main(void)
+{
+    static const struct {
+        const char *name;
+        uint8_t setup[4];       /* ACR, T1 latch low and high, IER */
+    } setups[] = {
+        { "free running timer 1, IRQ every $0400", { 0x40, 0x00, 0x04, 0xc0 } },
+        { "free running timer 1, IRQ every $0040", { 0x40, 0x40, 0x00, 0xc0 } },
+        { "free running timer 1, no IRQ", { 0x40, 0x00, 0x30, 0x40 } },
+        { "timer 1 on PB7", { 0xc0, 0x00, 0x02, 0xc0 } },
+        { "one-shot timer 1", { 0x00, 0x00, 0x10, 0xc0 } }
+    };
+    unsigned int i;
+    int failed = 0;
+    CLOCK skipped = 0;
+
+    for (i = 0; i < sizeof(setups) / sizeof(setups[0]); i++) {
+        failed |= test_run(setups[i].name, setups[i].setup, 0);
+        skipped += drives[1].skipped;
+        failed |= test_run(setups[i].name, setups[i].setup, 4);
+        skipped += drives[1].skipped;
+    }
+
+    if (skipped == 0) {
+        printf("No cycles were skipped.\n");
+        failed = 1;
+    }
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
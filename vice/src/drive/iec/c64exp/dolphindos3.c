@@ -41,6 +41,7 @@
 #include "dolphindos3.h"
 #include "drive.h"
 #include "drivemem.h"
+#include "drivethread.h"
 #include "drivetypes.h"
 #include "iecdrive.h"
 #include "log.h"
@@ -54,6 +55,7 @@ static mc6821_state my6821[DRIVE_NUM];
 static void dd3_set_pa(mc6821_state *ctx)
 {
     unsigned int dnr = (unsigned int)(((drive_context_t *)(ctx->p))->mynumber);
+    DRIVETHREAD_SYNC((drive_context_t *)(ctx->p));
     parallel_cable_drive_write(DRIVE_PC_DD3, ctx->dataA, PARALLEL_WRITE, dnr);
     /* DBG(("DD3 (%d) 6821 PA WR %02x\n", dnr, ctx->dataA)); */
 }
@@ -64,6 +66,8 @@ static uint8_t dd3_get_pa(mc6821_state *ctx)
     uint8_t data;
     int hs = 0;
 
+    DRIVETHREAD_SYNC((drive_context_t *)(ctx->p));
+
     /* output all pins that are in input mode as 1 first */
     parallel_cable_drive_write(DRIVE_PC_DD3, (uint8_t)((~ctx->ddrA) | ctx->dataA), PARALLEL_WRITE, dnr);
 
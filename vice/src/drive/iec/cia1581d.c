@@ -33,6 +33,7 @@
 #include "ciad.h"
 #include "debug.h"
 #include "drive.h"
+#include "drivethread.h"
 #include "drivetypes.h"
 #include "iecbus.h"
 #include "iecdrive.h"
@@ -150,6 +151,8 @@ static void store_ciapb(cia_context_t *cia_context, CLOCK rclk, uint8_t byte)
     cia1581p = (drivecia1581_context_t *)(cia_context->prv);
 
     if (byte != cia_context->old_pb) {
+        DRIVETHREAD_SYNC((drive_context_t *)(cia_context->context));
+
         if (cia1581p->iecbus != NULL) {
             uint8_t *drive_bus, *drive_data;
             unsigned int unit;
@@ -206,6 +209,8 @@ static uint8_t read_ciapb(cia_context_t *cia_context)
 
     cia1581p = (drivecia1581_context_t *)(cia_context->prv);
 
+    DRIVETHREAD_SYNC((drive_context_t *)(cia_context->context));
+
     if (cia1581p->iecbus != NULL) {
         uint8_t *drive_port;
 
@@ -235,6 +240,7 @@ static void store_sdr(cia_context_t *cia_context, uint8_t byte)
 
     cia1581p = (drivecia1581_context_t *)(cia_context->prv);
 
+    DRIVETHREAD_SYNC((drive_context_t *)(cia_context->context));
     iec_fast_drive_write(byte, cia1581p->number);
 }
 
@@ -81,6 +81,21 @@ static void drive_store_zero(drive_context_t *drv, uint16_t address, uint8_t val
     drv->drive->drive_ram[address & 0xff] = value;
 }
 
+/* Let the drive CPU skip loops that only poll the serial bus through VIA1
+   and read the plain RAM and ROM set up above.  */
+static void memiec_set_stable(drivecpud_context_t *cpud)
+{
+    unsigned int i;
+
+    for (i = 0; i < 0x100; i++) {
+        if (cpud->read_base_tab[0][i] != NULL) {
+            drivemem_set_stable_func(cpud, i, i + 1, drivemem_stable_memory);
+        }
+    }
+    drivemem_set_stable_func(cpud, 0x18, 0x1c, via1d1541_stable);
+    cpud->skipped_func = via1d1541_skipped;
+}
+
 /* ------------------------------------------------------------------------- */
 
 void memiec_init(struct drive_context_s *drv, unsigned int type)
@@ -128,6 +143,7 @@ void memiec_init(struct drive_context_s *drv, unsigned int type)
             drivemem_set_func(cpud, 0xa0, 0xc0, drive_read_rom, NULL, NULL, &drv->drive->trap_rom[0x2000], 0xa000bffd);
         }
         drivemem_set_func(cpud, 0xc0, 0x100, drive_read_rom, NULL, NULL, &drv->drive->trap_rom[0x4000], 0xc000fffd);
+        memiec_set_stable(cpud);
         break;
     case DRIVE_TYPE_1570:
     case DRIVE_TYPE_1571:
@@ -151,6 +167,7 @@ void memiec_init(struct drive_context_s *drv, unsigned int type)
             drivemem_set_func(cpud, 0x60, 0x80, cia1571_read, cia1571_store, cia1571_peek, NULL, 0);
         }
         drivemem_set_func(cpud, 0x80, 0x100, drive_read_rom, NULL, NULL, drv->drive->trap_rom, 0x8000fffd);
+        memiec_set_stable(cpud);
         break;
     case DRIVE_TYPE_1581:
         drv->cpu->pageone = drv->drive->drive_ram + 0x100;
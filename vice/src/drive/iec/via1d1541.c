@@ -34,6 +34,7 @@
 #include "debug.h"
 #include "drive.h"
 #include "drivesync.h"
+#include "drivethread.h"
 #include "drivetypes.h"
 #include "glue1571.h"
 #include "iecbus.h"
@@ -73,6 +74,16 @@ uint8_t via1d1541_peek(drive_context_t *ctxptr, uint16_t addr)
     return viacore_peek(ctxptr->via1d1541, addr);
 }
 
+int via1d1541_stable(drive_context_t *ctxptr, uint16_t addr)
+{
+    return viacore_read_stable(ctxptr->via1d1541, addr);
+}
+
+void via1d1541_skipped(drive_context_t *ctxptr, CLOCK since, CLOCK cycles)
+{
+    viacore_read_skipped(ctxptr->via1d1541, since, cycles);
+}
+
 int via1d1541_dump(drive_context_t *ctxptr, uint16_t addr)
 {
     viacore_dump(((drive_context_t*)ctxptr)->via1d1541);
@@ -154,6 +165,7 @@ static void store_pra(via_context_t *via_context, uint8_t byte, uint8_t oldpa_va
             glue1571_side_set((byte >> 2) & 1, via1p->drive);
         }
         if ((oldpa_value ^ byte) & 0x02) {
+            DRIVETHREAD_SYNC(drive_context);
             iec_fast_drive_direction(byte & 2, via1p->number);
         }
     } else {
@@ -163,6 +175,7 @@ static void store_pra(via_context_t *via_context, uint8_t byte, uint8_t oldpa_va
                 if (via1p->drive->type == DRIVE_TYPE_1540
                     || via1p->drive->type == DRIVE_TYPE_1541
                     || via1p->drive->type == DRIVE_TYPE_1541II) {
+                    DRIVETHREAD_SYNC(drive_context);
                     parallel_cable_drive_write(via1p->drive->parallel_cable, byte,
                                                (((addr == VIA_PRA) && ((via_context->via[VIA_PCR]
                                                                         & 0xe) == 0xa)) ? PARALLEL_WRITE_HS : PARALLEL_WRITE),
@@ -212,6 +225,8 @@ static void store_prb(via_context_t *via_context, uint8_t byte, uint8_t p_oldpb,
     via1p = (drivevia1_context_t *)(via_context->prv);
 
     if (byte != p_oldpb) {
+        DRIVETHREAD_SYNC((drive_context_t *)(via_context->context));
+
         DEBUG_IEC_DRV_WRITE(byte);
 
         if (iecbus != NULL) {
@@ -303,6 +318,7 @@ static uint8_t read_pra(via_context_t *via_context, uint16_t addr)
     switch (via1p->drive->parallel_cable) {
         case DRIVE_PC_STANDARD:
         case DRIVE_PC_FORMEL64:
+            DRIVETHREAD_SYNC((drive_context_t *)(via_context->context));
             byte = parallel_cable_drive_read(via1p->drive->parallel_cable,
                                              (((addr == VIA_PRA) && (via_context->via[VIA_PCR] & 0xe) == 0xa)) ? 1 : 0);
             break;
@@ -326,6 +342,8 @@ static uint8_t read_prb(via_context_t *via_context)
     /* 0 for drive0, 0x20 for drive 1 */
     orval = (via1p->number << 5);
 
+    DRIVETHREAD_SYNC((drive_context_t *)(via_context->context));
+
     if (iecbus != NULL) {
         byte = (((via_context->via[VIA_PRB] & 0x1a)
                  | iecbus->drv_port) ^ 0x85) | orval;
@@ -39,6 +39,9 @@ extern void via1d1541_init(struct drive_context_s *ctxptr);
 extern void via1d1541_store(struct drive_context_s *ctxptr, uint16_t addr, uint8_t byte);
 extern uint8_t via1d1541_read(struct drive_context_s *ctxptr, uint16_t addr);
 extern uint8_t via1d1541_peek(struct drive_context_s *ctxptr, uint16_t addr);
+extern int via1d1541_stable(struct drive_context_s *ctxptr, uint16_t addr);
+extern void via1d1541_skipped(struct drive_context_s *ctxptr, CLOCK since,
+                              CLOCK cycles);
 extern int via1d1541_dump(drive_context_t *ctxptr, uint16_t addr);
 
 #endif
@@ -37,6 +37,7 @@
 #include "debug.h"
 #include "drive.h"
 #include "drivesync.h"
+#include "drivethread.h"
 #include "drivetypes.h"
 #include "iecbus.h"
 #include "iecdrive.h"
@@ -141,6 +142,8 @@ static void store_pra(via_context_t *via_context, uint8_t byte, uint8_t oldpa,
     viap = (drivevia_context_t *)(via_context->prv);
 
     if (byte != oldpa) {
+        DRIVETHREAD_SYNC((drive_context_t *)(via_context->context));
+
         DEBUG_IEC_DRV_WRITE(byte);
 
         if (iecbus != NULL) {
@@ -218,6 +221,7 @@ static void store_sr(via_context_t *via_context, uint8_t byte)
 
     viap = (drivevia_context_t *)(via_context->prv);
 
+    DRIVETHREAD_SYNC((drive_context_t *)(via_context->context));
     iec_fast_drive_write((uint8_t)(~byte), viap->number);
 }
 
@@ -236,6 +240,8 @@ static uint8_t read_pra(via_context_t *via_context, uint16_t addr)
 
     viap = (drivevia_context_t *)(via_context->prv);
 
+    DRIVETHREAD_SYNC((drive_context_t *)(via_context->context));
+
     if (iecbus != NULL) {
         byte = (((via_context->via[VIA_PRA] & 0x1a)
                  | iecbus->drv_port) ^ 0x85);
@@ -32,8 +32,8 @@
 #include "cbmdos.h"
 #include "cbmfile.h"
 #include "charset.h"
+#include "dirindex.h"
 #include "fileio.h"
-#include "ioutil.h"
 #include "lib.h"
 #include "rawfile.h"
 #include "types.h"
@@ -41,48 +41,7 @@
 
 static char *cbmfile_find_file(const char *fsname, const char *path)
 {
-    struct ioutil_dir_s *ioutil_dir;
-    uint8_t *name1, *name2;
-    char *name, *retname = NULL;
-    const char *open_path;
-
-    open_path = path;
-    if (path == NULL) {
-        open_path = "";
-    }
-
-    ioutil_dir = ioutil_opendir(open_path);
-
-    if (ioutil_dir == NULL) {
-        return NULL;
-    }
-
-    name1 = cbmdos_dir_slot_create(fsname, (unsigned int)strlen(fsname));
-
-    while (1) {
-        unsigned int equal;
-
-        name = ioutil_readdir(ioutil_dir);
-
-        if (name == NULL) {
-            break;
-        }
-
-        name2 = cbmdos_dir_slot_create(name, (unsigned int)strlen(name));
-        equal = cbmdos_parse_wildcard_compare(name1, name2);
-
-        lib_free(name2);
-
-        if (equal > 0) {
-            retname = lib_stralloc(name);
-            break;
-        }
-    }
-
-    lib_free(name1);
-    ioutil_closedir(ioutil_dir);
-
-    return retname;
+    return dirindex_find(fsname, path, FILEIO_FORMAT_RAW);
 }
 
 fileio_info_t *cbmfile_open(const char *file_name, const char *path,
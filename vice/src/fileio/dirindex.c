@@ -0,0 +1,307 @@
+/*
+ * dirindex.c - Cached index of the files in a directory.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/* Looking up a CBM file name means reading, sorting and comparing the
+   whole directory, and for P00 files also opening all of them to get the
+   name out of the header.  The index keeps the names of the last few
+   directories used, in the order ioutil_readdir() returns them, together
+   with their CBM names, so a lookup only has to compare those.  The names
+   from the P00 headers are read the first time a P00 file is looked up.
+
+   An index is used until the modification time of its directory changes.
+   As that time only has a resolution of a second, an index read in the
+   same second as the directory was last changed is read again the next
+   time.  Changing the header of a P00 file in place does not change the
+   directory: a match that is no longer right is noticed and the index
+   read again, but a file that only now matches is not found until the
+   directory changes.  */
+
+#include "vice.h"
+
+#include <string.h>
+#include <time.h>
+
+#include "cbmdos.h"
+#include "dirindex.h"
+#include "fileio.h"
+#include "ioutil.h"
+#include "lib.h"
+#include "p00.h"
+#include "types.h"
+
+/* Number of directories kept.  */
+#define DIRINDEX_CACHE_SIZE 4
+
+typedef struct dirindex_entry_s {
+    char *name;
+
+    /* The name as a CBM file name, and the name in the P00 header.  */
+    uint8_t slot[CBMDOS_SLOT_NAME_LENGTH];
+    uint8_t p00_slot[CBMDOS_SLOT_NAME_LENGTH];
+    int p00;
+} dirindex_entry_t;
+
+struct dirindex_s {
+    char *path;
+    unsigned long mtime;
+    unsigned long read_time;
+
+    dirindex_entry_t *entries;
+    int amount;
+    int p00_read;
+
+    /* Users of the index, including the cache.  */
+    int refs;
+};
+
+/* Most recently used first.  */
+static dirindex_t *cache[DIRINDEX_CACHE_SIZE];
+
+static void dirindex_unref(dirindex_t *index)
+{
+    int i;
+
+    if (--index->refs > 0) {
+        return;
+    }
+
+    for (i = 0; i < index->amount; i++) {
+        lib_free(index->entries[i].name);
+    }
+    lib_free(index->entries);
+    lib_free(index->path);
+    lib_free(index);
+}
+
+static void dirindex_drop(int n)
+{
+    dirindex_unref(cache[n]);
+
+    memmove(&cache[n], &cache[n + 1],
+            (DIRINDEX_CACHE_SIZE - 1 - n) * sizeof(dirindex_t *));
+    cache[DIRINDEX_CACHE_SIZE - 1] = NULL;
+}
+
+static dirindex_t *dirindex_create(const char *path)
+{
+    ioutil_dir_t *ioutil_dir;
+    dirindex_t *index;
+    dirindex_entry_t *entry;
+    unsigned long mtime;
+    size_t len;
+    int i;
+
+    /* Get the time first, so changes made while reading are noticed.  */
+    if (ioutil_mtime(path, &mtime) < 0) {
+        return NULL;
+    }
+
+    ioutil_dir = ioutil_opendir(path);
+
+    if (ioutil_dir == NULL) {
+        return NULL;
+    }
+
+    index = lib_malloc(sizeof(dirindex_t));
+    index->path = lib_stralloc(path);
+    index->mtime = mtime;
+    index->read_time = (unsigned long)time(NULL);
+    index->amount = ioutil_dir->dir_amount + ioutil_dir->file_amount;
+    index->entries = lib_malloc(sizeof(dirindex_entry_t) * index->amount);
+    index->p00_read = 0;
+    index->refs = 0;
+
+    for (i = 0; i < index->amount; i++) {
+        entry = &index->entries[i];
+        entry->name = lib_stralloc(ioutil_readdir(ioutil_dir));
+
+        len = strlen(entry->name);
+        if (len > CBMDOS_SLOT_NAME_LENGTH) {
+            len = CBMDOS_SLOT_NAME_LENGTH;
+        }
+        memset(entry->slot, 0xa0, CBMDOS_SLOT_NAME_LENGTH);
+        memcpy(entry->slot, entry->name, len);
+        entry->p00 = 0;
+    }
+
+    ioutil_closedir(ioutil_dir);
+
+    return index;
+}
+
+/* Return the index of `path', reading it if needed.  The index stays
+   valid until the next call unless a reference is taken.  */
+static dirindex_t *dirindex_get(const char *path)
+{
+    dirindex_t *index;
+    unsigned long mtime;
+    int i;
+
+    if (path == NULL) {
+        path = "";
+    }
+
+    for (i = 0; i < DIRINDEX_CACHE_SIZE && cache[i] != NULL; i++) {
+        if (strcmp(cache[i]->path, path) == 0) {
+            break;
+        }
+    }
+
+    if (i < DIRINDEX_CACHE_SIZE && cache[i] != NULL) {
+        index = cache[i];
+        if (ioutil_mtime(path, &mtime) == 0 && mtime == index->mtime
+            && mtime < index->read_time) {
+            memmove(&cache[1], &cache[0], i * sizeof(dirindex_t *));
+            cache[0] = index;
+            return index;
+        }
+        dirindex_drop(i);
+    }
+
+    index = dirindex_create(path);
+
+    if (index == NULL) {
+        return NULL;
+    }
+
+    if (cache[DIRINDEX_CACHE_SIZE - 1] != NULL) {
+        dirindex_drop(DIRINDEX_CACHE_SIZE - 1);
+    }
+    memmove(&cache[1], &cache[0],
+            (DIRINDEX_CACHE_SIZE - 1) * sizeof(dirindex_t *));
+    cache[0] = index;
+    index->refs = 1;
+
+    return index;
+}
+
+static void dirindex_read_p00(dirindex_t *index)
+{
+    int i;
+
+    for (i = 0; i < index->amount; i++) {
+        if (p00_read_cbmname(index->entries[i].name, index->path,
+                             index->entries[i].p00_slot) == 0) {
+            index->entries[i].p00 = 1;
+        }
+    }
+
+    index->p00_read = 1;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Open the index of `path' to list it with dirindex_read().  */
+dirindex_t *dirindex_open(const char *path)
+{
+    dirindex_t *index;
+
+    index = dirindex_get(path);
+
+    if (index != NULL) {
+        index->refs++;
+    }
+
+    return index;
+}
+
+/* Return the name at `*pos' and advance it, or NULL at the end.  */
+const char *dirindex_read(dirindex_t *index, int *pos)
+{
+    if (*pos >= index->amount) {
+        return NULL;
+    }
+
+    return index->entries[(*pos)++].name;
+}
+
+void dirindex_close(dirindex_t *index)
+{
+    dirindex_unref(index);
+}
+
+/* Find the first file in `path' whose CBM name matches `file_name', which
+   may contain wildcards.  With `format' FILEIO_FORMAT_P00 the names in
+   the headers of the P00 files are compared instead of the file names.
+   Return the name of the file, or NULL if there is none.  */
+char *dirindex_find(const char *file_name, const char *path,
+                    unsigned int format)
+{
+    dirindex_t *index;
+    dirindex_entry_t *entry = NULL;
+    uint8_t *slot, check[CBMDOS_SLOT_NAME_LENGTH];
+    int i, tries;
+
+    slot = cbmdos_dir_slot_create(file_name, (unsigned int)strlen(file_name));
+
+    for (tries = 0; tries < 2; tries++) {
+        index = dirindex_get(path);
+
+        if (index == NULL) {
+            break;
+        }
+
+        if (format == FILEIO_FORMAT_P00 && !index->p00_read) {
+            dirindex_read_p00(index);
+        }
+
+        for (i = 0; i < index->amount; i++) {
+            entry = &index->entries[i];
+            if (format == FILEIO_FORMAT_P00) {
+                if (entry->p00
+                    && cbmdos_parse_wildcard_compare(slot, entry->p00_slot) > 0) {
+                    break;
+                }
+            } else {
+                if (cbmdos_parse_wildcard_compare(slot, entry->slot) > 0) {
+                    break;
+                }
+            }
+        }
+
+        if (i == index->amount) {
+            break;
+        }
+
+        if (format != FILEIO_FORMAT_P00
+            || (p00_read_cbmname(entry->name, index->path, check) == 0
+                && memcmp(check, entry->p00_slot, CBMDOS_SLOT_NAME_LENGTH) == 0)) {
+            lib_free(slot);
+            return lib_stralloc(entry->name);
+        }
+
+        /* The header has been changed in place, read the index again.  */
+        dirindex_drop(0);
+    }
+
+    lib_free(slot);
+
+    return NULL;
+}
+
+void dirindex_shutdown(void)
+{
+    while (cache[0] != NULL) {
+        dirindex_drop(0);
+    }
+}
@@ -0,0 +1,39 @@
+/*
+ * dirindex.h - Cached index of the files in a directory.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#ifndef VICE_DIRINDEX_H
+#define VICE_DIRINDEX_H
+
+struct dirindex_s;
+typedef struct dirindex_s dirindex_t;
+
+extern dirindex_t *dirindex_open(const char *path);
+extern const char *dirindex_read(dirindex_t *index, int *pos);
+extern void dirindex_close(dirindex_t *index);
+
+extern char *dirindex_find(const char *file_name, const char *path,
+                           unsigned int format);
+
+extern void dirindex_shutdown(void);
+
+#endif
@@ -38,8 +38,8 @@
 
 #include "archdep.h"
 #include "cbmdos.h"
+#include "dirindex.h"
 #include "fileio.h"
-#include "ioutil.h"
 #include "lib.h"
 #include "log.h"
 #include "p00.h"
@@ -159,64 +159,40 @@ static void p00_pad_a0(uint8_t *slot)
     }
 }
 
-static char *p00_file_find(const char *file_name, const char *path)
+/* Read the CBM name from the header of the P00 file `file_name' into
+   `slot', padded like a directory slot.  */
+int p00_read_cbmname(const char *file_name, const char *path, uint8_t *slot)
 {
-    struct ioutil_dir_s *ioutil_dir;
     struct rawfile_info_s *rawfile;
     uint8_t p00_header_file_name[P00_HDR_CBMNAME_LEN];
-    char *name, *alloc_name = NULL;
     int rc;
 
-    ioutil_dir = ioutil_opendir(path);
-
-    if (ioutil_dir == NULL) {
-        return NULL;
+    if (p00_check_name(file_name) < 0) {
+        return -1;
     }
 
-    while (1) {
-        name = ioutil_readdir(ioutil_dir);
-
-        if (name == NULL) {
-            break;
-        }
-
-        if (p00_check_name(name) < 0) {
-            continue;
-        }
-
-        rawfile = rawfile_open(name, path, FILEIO_COMMAND_READ);
-        if (rawfile == NULL) {
-            continue;
-        }
-
-        rc = p00_read_header(rawfile, (uint8_t *)p00_header_file_name, NULL);
-
-        if (rc >= 0) {
-            uint8_t *cname;
-            unsigned int equal;
-
-            p00_pad_a0(p00_header_file_name);
-            cname = cbmdos_dir_slot_create(file_name, (unsigned int)strlen(file_name));
-            equal = cbmdos_parse_wildcard_compare(cname, p00_header_file_name);
-            lib_free(cname);
+    rawfile = rawfile_open(file_name, path, FILEIO_COMMAND_READ);
+    if (rawfile == NULL) {
+        return -1;
+    }
 
-            if (equal > 0) {
-                alloc_name = lib_stralloc(name);
-            } else {
-                rc = -1;
-            }
-        }
+    rc = p00_read_header(rawfile, p00_header_file_name, NULL);
 
-        rawfile_destroy(rawfile);
+    rawfile_destroy(rawfile);
 
-        if (rc >= 0) {
-            break;
-        }
+    if (rc < 0) {
+        return -1;
     }
 
-    ioutil_closedir(ioutil_dir);
+    p00_pad_a0(p00_header_file_name);
+    memcpy(slot, p00_header_file_name, CBMDOS_SLOT_NAME_LENGTH);
 
-    return alloc_name;
+    return 0;
+}
+
+static char *p00_file_find(const char *file_name, const char *path)
+{
+    return dirindex_find(file_name, path, FILEIO_FORMAT_P00);
 }
 
 static size_t p00_eliminate_char_p00(char *filename, int pos)
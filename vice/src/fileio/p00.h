@@ -50,5 +50,7 @@ extern unsigned int p00_rename(const char *src_name, const char *dest_name,
                                const char *path);
 extern unsigned int p00_scratch(const char *file_name, const char *path);
 extern unsigned int p00_get_bytes_left(struct fileio_info_s *info);
+extern int p00_read_cbmname(const char *file_name, const char *path,
+                            uint8_t *slot);
 
 #endif
@@ -0,0 +1,444 @@
+/*
+ * forkserver.c - Fork copies of the running machine for each job.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/* With `-forkserver <cycle>' the emulator runs in warp mode with the dummy
+   sound device until the main CPU reaches <cycle>, or with `autostart'
+   until the autostart has finished.  It then reads jobs from the standard
+   input, one per line, and forks a copy of the machine for each, which
+   shares all memory with the server copy-on-write.  A job line holds
+   command-line options that the child applies before it runs on, e.g.
+   `-keybuf' to type something and `-limitcycles' (counted from the fork
+   point) or `-debugcart' to end it.  Whenever a child exits,
+   "<job> <status>" is written to the standard output, with the jobs
+   numbered from 1 and the status being the exit code, or 128 plus the
+   number of the signal that ended it.  At most
+   `-forkserverprocs' children run at the same time.  The server does not
+   emulate anything after the fork point; it exits at the end of the input
+   once all children are done.
+
+   Only the thread that calls fork() exists in a child, so the worker
+   threads are stopped before forking; the children start their own when
+   needed.  */
+
+#include "vice.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef HAVE_FORK
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include "alarm.h"
+#include "cmdline.h"
+#include "drivethread.h"
+#include "forkserver.h"
+#include "kbdbuf.h"
+#include "lib.h"
+#include "log.h"
+#include "machine.h"
+#include "maincpu.h"
+#include "resources.h"
+#include "sid/sidthread.h"
+#include "translate.h"
+#include "types.h"
+#include "video.h"
+
+/* Longest job line.  */
+#define FORKSERVER_LINE_MAX  4096
+
+/* Most options and parameters on a job line.  */
+#define FORKSERVER_ARGS_MAX  64
+
+static int forkserver_enabled = 0;
+
+/* Cycle to fork at, 0 to fork when the autostart has finished.  */
+static CLOCK fork_clk = 0;
+
+/* Children to run at the same time, 0 for one per processor.  */
+static int max_procs = 0;
+
+static alarm_t *fork_alarm = NULL;
+
+static log_t forkserver_log = LOG_ERR;
+
+#ifdef HAVE_FORK
+
+typedef struct forkserver_child_s {
+    pid_t pid;
+    unsigned long job;
+} forkserver_child_t;
+
+static forkserver_child_t *children;
+static int running = 0;
+
+/* Job input not yet split into lines.  */
+static char input[FORKSERVER_LINE_MAX];
+static int input_len = 0;
+
+static char line[FORKSERVER_LINE_MAX];
+
+/* Read the next line of the standard input into `line'.  Return 0 at the
+   end of the input.  The descriptor is read directly, as input buffered by
+   stdio would be copied into the children, and their exit() might move the
+   shared file offset back.  Lines that are too long are skipped.  */
+static int read_line(void)
+{
+    char *nl;
+    int len, n, skip = 0;
+
+    for (;;) {
+        nl = memchr(input, '\n', (size_t)input_len);
+        if (nl != NULL && skip) {
+            len = (int)(nl - input) + 1;
+            input_len -= len;
+            memmove(input, input + len, (size_t)input_len);
+            skip = 0;
+            continue;
+        }
+        if (nl != NULL) {
+            len = (int)(nl - input);
+            break;
+        }
+        if (input_len == FORKSERVER_LINE_MAX - 1) {
+            if (!skip) {
+                log_error(forkserver_log, "Skipping a job line longer than %d characters.",
+                          FORKSERVER_LINE_MAX - 2);
+            }
+            input_len = 0;
+            skip = 1;
+        }
+        n = (int)read(0, input + input_len,
+                      (size_t)(FORKSERVER_LINE_MAX - 1 - input_len));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            if (input_len == 0 || skip) {
+                return 0;
+            }
+            len = input_len;
+            break;
+        }
+        input_len += n;
+    }
+
+    memcpy(line, input, (size_t)len);
+    line[len] = '\0';
+
+    if (len < input_len) {
+        len++;
+    }
+    input_len -= len;
+    memmove(input, input + len, (size_t)input_len);
+
+    return 1;
+}
+
+/* Split `line' into `argv' like a shell would, without escapes.  Return
+   the number of entries including argv[0], or -1 if there are too many.  */
+static int split_line(char **argv)
+{
+    static char name[] = "forkserver";
+    char *p = line;
+    int argc = 1;
+
+    argv[0] = name;
+
+    for (;;) {
+        while (isspace((unsigned char)*p)) {
+            p++;
+        }
+        if (*p == '\0') {
+            break;
+        }
+        if (argc == FORKSERVER_ARGS_MAX + 1) {
+            return -1;
+        }
+        if (*p == '"') {
+            argv[argc++] = ++p;
+            while (*p != '\0' && *p != '"') {
+                p++;
+            }
+        } else {
+            argv[argc++] = p;
+            while (*p != '\0' && !isspace((unsigned char)*p)) {
+                p++;
+            }
+        }
+        if (*p != '\0') {
+            *p++ = '\0';
+        }
+    }
+    argv[argc] = NULL;
+
+    return argc;
+}
+
+/* Apply the options of job `job' in a freshly forked child.  */
+static void forkserver_child(unsigned long job)
+{
+    char *argv[FORKSERVER_ARGS_MAX + 2];
+    int argc, i, keybuf = 0;
+    int fd;
+    CLOCK clk_limit = maincpu_clk_limit;
+
+    forkserver_enabled = 0;
+    lib_free(children);
+    children = NULL;
+
+    /* Keep the child away from the job input.  */
+    fd = open("/dev/null", O_RDONLY);
+    if (fd >= 0) {
+        dup2(fd, 0);
+        close(fd);
+    }
+
+    argc = split_line(argv);
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-keybuf") == 0) {
+            keybuf = 1;
+        }
+    }
+
+    maincpu_clk_limit = 0;
+    if (argc < 0 || cmdline_parse(&argc, argv) < 0 || argc > 1) {
+        log_error(forkserver_log, "Job %lu: invalid options `%s'.", job, line);
+        exit(EXIT_FAILURE);
+    }
+
+    /* -limitcycles of a job counts from the fork point.  */
+    if (maincpu_clk_limit != 0) {
+        maincpu_clk_limit += maincpu_clk;
+    } else {
+        maincpu_clk_limit = clk_limit;
+    }
+
+    /* -keybuf is normally only typed in after an autostart.  */
+    if (keybuf) {
+        kbdbuf_feed_cmdline();
+    }
+}
+
+/* Wait for a child to exit and report its status.  */
+static void forkserver_wait(void)
+{
+    pid_t pid;
+    int status, code, i;
+
+    do {
+        pid = waitpid(-1, &status, 0);
+    } while (pid < 0 && errno == EINTR);
+
+    if (pid < 0) {
+        running = 0;
+        return;
+    }
+
+    for (i = 0; i < running; i++) {
+        if (children[i].pid == pid) {
+            break;
+        }
+    }
+    if (i == running) {
+        return;
+    }
+
+    if (WIFEXITED(status)) {
+        code = WEXITSTATUS(status);
+    } else if (WIFSIGNALED(status)) {
+        code = 128 + WTERMSIG(status);
+    } else {
+        code = -1;
+    }
+    fprintf(stdout, "%lu %d\n", children[i].job, code);
+    fflush(stdout);
+
+    children[i] = children[--running];
+}
+
+/* Fork a child for each job.  Returns in the children only.  */
+static void forkserver_run(void)
+{
+    unsigned long job = 0;
+    pid_t pid;
+
+    /* Stop the worker threads, they do not exist in the children.  */
+    drivethread_shutdown();
+    sidthread_shutdown();
+    videothread_shutdown();
+    renderthread_shutdown();
+
+    if (max_procs <= 0) {
+#ifdef _SC_NPROCESSORS_ONLN
+        max_procs = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+        if (max_procs <= 0) {
+            max_procs = 1;
+        }
+    }
+    children = lib_malloc(max_procs * sizeof(forkserver_child_t));
+
+    log_message(forkserver_log, "Forking jobs at cycle %lu, %d at a time.",
+                (unsigned long)maincpu_clk, max_procs);
+
+    for (;;) {
+        if (running == max_procs) {
+            forkserver_wait();
+        }
+        if (!read_line()) {
+            break;
+        }
+        if (line[0] == '#') {
+            continue;
+        }
+        job++;
+
+        /* Do not let the children write out what is still buffered.  */
+        fflush(NULL);
+
+        pid = fork();
+        if (pid == 0) {
+            forkserver_child(job);
+            return;
+        }
+        if (pid < 0) {
+            log_error(forkserver_log, "Job %lu: cannot fork: %s.", job,
+                      strerror(errno));
+            fprintf(stdout, "%lu -1\n", job);
+            fflush(stdout);
+            continue;
+        }
+        children[running].pid = pid;
+        children[running].job = job;
+        running++;
+    }
+
+    while (running > 0) {
+        forkserver_wait();
+    }
+
+    log_message(forkserver_log, "%lu jobs done.", job);
+    exit(EXIT_SUCCESS);
+}
+
+#else
+
+static void forkserver_run(void)
+{
+    log_error(forkserver_log, "Not supported on this platform.");
+    exit(EXIT_FAILURE);
+}
+
+#endif
+
+static void fork_alarm_triggered(CLOCK offset, void *data)
+{
+    alarm_unset(fork_alarm);
+
+    if (forkserver_enabled) {
+        forkserver_run();
+    }
+}
+
+/* Called right before the main CPU starts.  */
+void forkserver_start(void)
+{
+    if (!forkserver_enabled) {
+        return;
+    }
+
+    forkserver_log = log_open("ForkServer");
+
+    if (!console_mode) {
+        log_error(forkserver_log, "Needs -console, disabled.");
+        forkserver_enabled = 0;
+        return;
+    }
+
+    fork_alarm = alarm_new(maincpu_alarm_context, "ForkServer",
+                           fork_alarm_triggered, NULL);
+    if (fork_clk != 0) {
+        alarm_set(fork_alarm, fork_clk);
+    }
+}
+
+/* Called when an autostart has finished.  */
+void forkserver_autostart_done(void)
+{
+    if (forkserver_enabled && fork_clk == 0 && fork_alarm != NULL) {
+        alarm_set(fork_alarm, maincpu_clk);
+    }
+}
+
+static int cmdline_forkserver(const char *param, void *extra_param)
+{
+    char *end;
+
+    if (strcmp(param, "autostart") == 0) {
+        fork_clk = 0;
+    } else {
+        fork_clk = (CLOCK)strtoul(param, &end, 0);
+        if (*end != '\0' || fork_clk == 0) {
+            return -1;
+        }
+    }
+    forkserver_enabled = 1;
+
+    resources_set_int("WarpMode", 1);
+    resources_set_string("SoundDeviceName", "dummy");
+
+    return 0;
+}
+
+static int cmdline_forkserverprocs(const char *param, void *extra_param)
+{
+    max_procs = atoi(param);
+
+    return max_procs < 0 ? -1 : 0;
+}
+
+static const cmdline_option_t cmdline_options[] = {
+    { "-forkserver", CALL_FUNCTION, 1,
+      cmdline_forkserver, NULL, NULL, NULL,
+      USE_PARAM_STRING, USE_DESCRIPTION_STRING,
+      IDCLS_UNUSED, IDCLS_UNUSED,
+      "<cycle>", "Run at full speed until <cycle> (or until the autostart has finished with `autostart'), then fork a copy of the machine for each line of options read from stdin" },
+    { "-forkserverprocs", CALL_FUNCTION, 1,
+      cmdline_forkserverprocs, NULL, NULL, NULL,
+      USE_PARAM_STRING, USE_DESCRIPTION_STRING,
+      IDCLS_UNUSED, IDCLS_UNUSED,
+      "<value>", "Number of forked copies to run at the same time (0: one per processor)" },
+    CMDLINE_LIST_END
+};
+
+int forkserver_cmdline_options_init(void)
+{
+    return cmdline_register_options(cmdline_options);
+}
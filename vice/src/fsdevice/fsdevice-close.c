@@ -37,10 +37,10 @@
 #include <stdio.h>
 
 #include "cbmdos.h"
+#include "dirindex.h"
 #include "fileio.h"
 #include "fsdevice-close.h"
 #include "fsdevicetypes.h"
-#include "ioutil.h"
 #include "tape.h"
 #include "vdrive.h"
 
@@ -72,12 +72,12 @@ int fsdevice_close(vdrive_t *vdrive, unsigned int secondary)
             }
             break;
         case Directory:
-            if (bufinfo[secondary].ioutil_dir == NULL) {
+            if (bufinfo[secondary].dirindex == NULL) {
                 return FLOPPY_ERROR;
             }
 
-            ioutil_closedir(bufinfo[secondary].ioutil_dir);
-            bufinfo[secondary].ioutil_dir = NULL;
+            dirindex_close(bufinfo[secondary].dirindex);
+            bufinfo[secondary].dirindex = NULL;
             break;
     }
 
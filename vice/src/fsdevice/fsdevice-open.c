@@ -45,6 +45,7 @@
 #include "archdep.h"
 #include "cbmdos.h"
 #include "charset.h"
+#include "dirindex.h"
 #include "fileio.h"
 #include "fsdevice-open.h"
 #include "fsdevice-resources.h"
@@ -63,7 +64,7 @@ static int fsdevice_open_directory(vdrive_t *vdrive, unsigned int secondary,
                                    bufinfo_t *bufinfo,
                                    cbmdos_cmd_parse_t *cmd_parse, char *rname)
 {
-    struct ioutil_dir_s *ioutil_dir;
+    struct dirindex_s *dirindex;
     char *mask;
     uint8_t *p;
     int i;
@@ -96,15 +97,15 @@ static int fsdevice_open_directory(vdrive_t *vdrive, unsigned int secondary,
     }
 
     /* trying to open */
-    ioutil_dir = ioutil_opendir((char *)(cmd_parse->parsecmd));
-    if (ioutil_dir == NULL) {
+    dirindex = dirindex_open((char *)(cmd_parse->parsecmd));
+    if (dirindex == NULL) {
         for (p = (uint8_t *)(cmd_parse->parsecmd); *p; p++) {
             if (isupper((int)*p)) {
                 *p = tolower((int)*p);
             }
         }
-        ioutil_dir = ioutil_opendir((char *)(cmd_parse->parsecmd));
-        if (ioutil_dir == NULL) {
+        dirindex = dirindex_open((char *)(cmd_parse->parsecmd));
+        if (dirindex == NULL) {
             fsdevice_error(vdrive, CBMDOS_IPE_NOT_FOUND);
             return FLOPPY_ERROR;
         }
@@ -151,7 +152,8 @@ static int fsdevice_open_directory(vdrive_t *vdrive, unsigned int secondary,
     bufinfo[secondary].buflen = (int)(p - bufinfo[secondary].name);
     bufinfo[secondary].bufp = bufinfo[secondary].name;
     bufinfo[secondary].mode = Directory;
-    bufinfo[secondary].ioutil_dir = ioutil_dir;
+    bufinfo[secondary].dirindex = dirindex;
+    bufinfo[secondary].dirindex_pos = 0;
     bufinfo[secondary].eof = 0;
 
     return FLOPPY_COMMAND_OK;
@@ -40,6 +40,7 @@
 
 #include "archdep.h"
 #include "cbmdos.h"
+#include "dirindex.h"
 #include "fileio.h"
 #include "fsdevice-read.h"
 #include "fsdevice-resources.h"
@@ -160,7 +161,7 @@ static void command_directory_get(vdrive_t *vdrive, bufinfo_t *bufinfo,
 {
     int i, l, f, statrc;
     unsigned int blocks;
-    char *direntry;
+    const char *direntry;
     unsigned int filelen, isdir;
     fileio_info_t *finfo = NULL;
     unsigned int format = 0;
@@ -189,7 +190,7 @@ static void command_directory_get(vdrive_t *vdrive, bufinfo_t *bufinfo,
         uint8_t *p;
         finfo = NULL;
 
-        direntry = ioutil_readdir(bufinfo->ioutil_dir);
+        direntry = dirindex_read(bufinfo->dirindex, &bufinfo->dirindex_pos);
 
         if (direntry == NULL) {
             break;
@@ -375,7 +376,7 @@ static void command_directory_get(vdrive_t *vdrive, bufinfo_t *bufinfo,
 static int command_directory(vdrive_t *vdrive, bufinfo_t *bufinfo,
                              uint8_t *data, unsigned int secondary)
 {
-    if (bufinfo->ioutil_dir == NULL) {
+    if (bufinfo->dirindex == NULL) {
         return FLOPPY_ERROR;
     }
 
@@ -41,6 +41,7 @@
 
 #include "attach.h"
 #include "cbmdos.h"
+#include "dirindex.h"
 #include "fileio.h"
 #include "fsdevice-close.h"
 #include "fsdevice-flush.h"
@@ -232,4 +233,6 @@ void fsdevice_shutdown(void)
         lib_free(fsdevice_dev[i].errorl);
         lib_free(fsdevice_dev[i].cmdbuf);
     }
+
+    dirindex_shutdown();
 }
@@ -39,13 +39,14 @@ enum fsmode {
     Write, Read, Append, Directory
 };
 
+struct dirindex_s;
 struct fileio_info_s;
-struct ioutil_dir_s;
 struct tape_image_s;
 
 struct bufinfo_s {
     struct fileio_info_s *fileio_info;
-    struct ioutil_dir_s *ioutil_dir;
+    struct dirindex_s *dirindex;
+    int dirindex_pos;
     struct tape_image_s *tape;
     enum fsmode mode;
     char *dir;
@@ -48,6 +48,10 @@
 #include "cbmdos.h"
 #include "diskimage.h"
 
+#ifdef USE_WORKER_THREADS
+#include <pthread.h>
+#endif
+
 static const uint8_t GCR_conv_data[16] =
 {
     0x0a, 0x0b, 0x12, 0x13,
@@ -84,31 +88,6 @@ static void gcr_convert_4bytes_to_GCR(const uint8_t *source, uint8_t *dest)
     *dest = (uint8_t)tdest;
 }
 
-static void gcr_convert_GCR_to_4bytes(const uint8_t *source, uint8_t *dest)
-{
-    int i;
-    /* at least 24 bits for shifting into bits 16...20 */
-    register uint32_t tdest = *source;
-
-    tdest <<= 13;
-
-    for (i = 5; i < 13; i += 2, dest++)
-    {
-        source++;
-        tdest |= ((uint32_t)(*source)) << i;
-
-        /*  "tdest >> 16" could be optimized to a word
-         *  aligned access, hopefully the compiler does
-         *  this for us (in a portable way)
-         */
-        *dest = From_GCR_conv_data[(tdest >> 16) & 0x1f] << 4;
-        tdest <<= 5;
-
-        *dest |= From_GCR_conv_data[(tdest >> 16) & 0x1f];
-        tdest <<= 5;
-    }
-}
-
 void gcr_convert_sector_to_GCR(const uint8_t *buffer, uint8_t *data, const gcr_header_t *header,
                                int gap, int sync, fdc_err_t error_code)
 {
@@ -167,96 +146,194 @@ void gcr_convert_sector_to_GCR(const uint8_t *buffer, uint8_t *data, const gcr_h
     gcr_convert_4bytes_to_GCR(buf, data);
 }
 
+/* Find the end of the next sync, i.e. a 0 bit after at least 10 1 bits,
+   looking at the `s' bits from bit `p' on, and return the position of the
+   0 bit.  Bits before `p' are not part of the sync.  The track is read 32
+   bits at a time where possible; `h' keeps the bits read so far, so that a
+   sync may span several words.  */
 static int gcr_find_sync(const disk_track_t *raw, int p, int s)
 {
-    int w, b;
+    uint64_t h, a, b, m, v;
+    unsigned int pos, size;
+    int left, bits, n;
 
     if (!raw->data || !raw->size) {
         return -CBMDOS_FDC_ERR_SYNC;
     }
 
-    w = 0;
-    b = raw->data[p >> 3] << (p & 7);
-    while (s--) {
-        if (b & 0x80) {
-            w = (w << 1) | 1;
+    size = (unsigned int)raw->size;
+    pos = (unsigned int)p >> 3;
+    left = s + (p & 7);
+    h = 0;
+
+    while (left > 0) {
+        if (pos + 4 <= size && left >= 32) {
+            v = ((uint64_t)raw->data[pos] << 24) | (raw->data[pos + 1] << 16)
+                | (raw->data[pos + 2] << 8) | raw->data[pos + 3];
+            bits = 32;
         } else {
-            if (~w & 0x3ff) {
-                w <<= 1;
-            } else {
-                return p;
-            }
+            v = raw->data[pos];
+            bits = 8;
         }
-        if (~p & 7) {
-            p++;
-            b <<= 1;
-        } else {
-            p++;
-            if (p >= raw->size * 8) {
-                p = 0;
+        if (left > s) {
+            /* first word, drop the bits before `p' */
+            v &= (bits == 8 ? 0xffu : 0xffffffffu) >> (p & 7);
+        }
+        h = (h << bits) | v;
+
+        /* bit n of `b' is set if bits n...n + 9 of `h' are set */
+        a = h & (h >> 1);
+        b = a & (a >> 2);
+        b = b & (b >> 4) & (a >> 8);
+
+        m = (b >> 1) & ~h & ((((uint64_t)1) << bits) - 1);
+        if (left < bits) {
+            m &= ((((uint64_t)1) << left) - 1) << (bits - left);
+        }
+        if (m) {
+            for (n = 0; !(m & (((uint64_t)1) << (bits - 1 - n))); n++) {
             }
-            b = raw->data[p >> 3];
+            return (int)(pos * 8) + n;
+        }
+
+        pos += bits >> 3;
+        if (pos >= size) {
+            pos = 0;
         }
+        left -= bits;
     }
     return -CBMDOS_FDC_ERR_SYNC;
 }
 
 static void gcr_decode_block(const disk_track_t *raw, int p, uint8_t *buf, int num)
 {
+    const uint8_t *data = raw->data;
+    unsigned int pos, size = (unsigned int)raw->size;
     int shift, i, j;
-    uint8_t gcr[5], b;
-    uint8_t *offset, *end = raw->data + raw->size;
+    uint64_t g;
 
     shift = p & 7;
-    offset = raw->data + (p >> 3);
+    pos = (unsigned int)p >> 3;
 
-    b = offset[0] << shift;
     for (i = 0; i < num; i++, buf += 4) {
-        /* get 5 bytes of gcr data */
-        for (j = 0; j < 5; j++) {
-            offset++;
-            if (offset >= end) {
-                offset = raw->data;
-            }
-            if (shift) {
-                gcr[j] = b | ((offset[0] << shift) >> 8);
-                b = offset[0] << shift;
-            } else {
-                gcr[j] = b;
-                b = offset[0];
+        /* get 6 bytes holding the 5 bytes of gcr data */
+        if (pos + 6 <= size) {
+            g = ((uint64_t)data[pos] << 40) | ((uint64_t)data[pos + 1] << 32)
+                | ((uint64_t)data[pos + 2] << 24) | (data[pos + 3] << 16)
+                | (data[pos + 4] << 8) | data[pos + 5];
+        } else {
+            for (g = 0, j = 0; j < 6; j++) {
+                g = (g << 8) | data[(pos + j) % size];
             }
         }
-        gcr_convert_GCR_to_4bytes(gcr, buf);
+        g >>= 8 - shift;
+
+        buf[0] = (From_GCR_conv_data[(g >> 35) & 0x1f] << 4)
+                 | From_GCR_conv_data[(g >> 30) & 0x1f];
+        buf[1] = (From_GCR_conv_data[(g >> 25) & 0x1f] << 4)
+                 | From_GCR_conv_data[(g >> 20) & 0x1f];
+        buf[2] = (From_GCR_conv_data[(g >> 15) & 0x1f] << 4)
+                 | From_GCR_conv_data[(g >> 10) & 0x1f];
+        buf[3] = (From_GCR_conv_data[(g >> 5) & 0x1f] << 4)
+                 | From_GCR_conv_data[g & 0x1f];
+
+        pos += 5;
+        if (pos >= size) {
+            pos -= size;
+        }
     }
 }
 
-static int gcr_find_sector_header(const disk_track_t *raw, uint8_t sector)
+/* Position of the first header of every sector on the last track searched,
+   so that reading all sectors of a track takes one pass over it instead of
+   one per sector.  The index is kept with a copy of the track, and only used
+   if the track still has the same contents: the drive emulation writes the
+   tracks directly, and for images without a GCR copy in memory every sector
+   access reads the track from the file again.  */
+typedef struct gcr_index_s {
+    uint8_t *data;
+    int size;
+    int alloc;
+
+    /* Result if there is no header for a sector.  */
+    int error;
+
+    /* Position of the header of each sector, -1 if there is none.  */
+    int sector[256];
+} gcr_index_t;
+
+static gcr_index_t gcr_index = { NULL, 0, 0, 0, { 0 } };
+
+#ifdef USE_WORKER_THREADS
+/* Drives running on their own threads write back tracks concurrently.  */
+static pthread_mutex_t gcr_index_lock = PTHREAD_MUTEX_INITIALIZER;
+#define GCR_INDEX_LOCK()    pthread_mutex_lock(&gcr_index_lock)
+#define GCR_INDEX_UNLOCK()  pthread_mutex_unlock(&gcr_index_lock)
+#else
+#define GCR_INDEX_LOCK()
+#define GCR_INDEX_UNLOCK()
+#endif
+
+static void gcr_index_build(const disk_track_t *raw)
 {
     uint8_t header[4];
-    int p, p2;
+    int i, p, first;
 
-    p = 0;
-    p2 = -CBMDOS_FDC_ERR_SYNC;
-    for (;; ) {
-        p = gcr_find_sync(raw, p, raw->size * 8);
-        if (p2 == p) {
-            break;
-        }
-        if (p2 < 0) {
-            p2 = p;
-        }
+    if (gcr_index.alloc < raw->size) {
+        gcr_index.data = lib_realloc(gcr_index.data, raw->size);
+        gcr_index.alloc = raw->size;
+    }
+    memcpy(gcr_index.data, raw->data, raw->size);
+    gcr_index.size = raw->size;
+
+    for (i = 0; i < 256; i++) {
+        gcr_index.sector[i] = -1;
+    }
+
+    /* Visit the syncs in the same order as searching the track from the
+       start once per sector did, so the same header wins.  */
+    first = gcr_find_sync(raw, 0, raw->size * 8);
+    gcr_index.error = (first < 0) ? first : -CBMDOS_FDC_ERR_HEADER;
+
+    for (p = first; p >= 0; ) {
         gcr_decode_block(raw, p, header, 1);
 
-        if (header[0] == 0x08 && header[2] == sector) {
+        if (header[0] == 0x08 && gcr_index.sector[header[2]] < 0) {
             /* Track, checksum or ID's are not checked here */
-            DBG(("GCR: shift: %d hdr: %02x %02x sec:%02d trk:%02d", shift, header[0], header[1], header[2], header[3]));
-            return p;
+            DBG(("GCR: hdr: %02x %02x sec:%02d trk:%02d", header[0], header[1], header[2], header[3]));
+            gcr_index.sector[header[2]] = p;
+        }
+
+        p = gcr_find_sync(raw, p, raw->size * 8);
+        if (p == first) {
+            break;
         }
     }
-    if (p2 < 0) {
-        return p2;
+}
+
+static int gcr_find_sector_header(const disk_track_t *raw, uint8_t sector)
+{
+    int p;
+
+    if (!raw->data || !raw->size) {
+        return -CBMDOS_FDC_ERR_SYNC;
+    }
+
+    GCR_INDEX_LOCK();
+
+    if (gcr_index.size != raw->size
+        || memcmp(gcr_index.data, raw->data, raw->size) != 0) {
+        gcr_index_build(raw);
+    }
+
+    p = gcr_index.sector[sector];
+    if (p < 0) {
+        p = gcr_index.error;
     }
-    return -CBMDOS_FDC_ERR_HEADER;
+
+    GCR_INDEX_UNLOCK();
+
+    return p;
 }
 
 fdc_err_t gcr_read_sector(const disk_track_t *raw, uint8_t *data, uint8_t sector)
@@ -341,6 +418,10 @@ fdc_err_t gcr_write_sector(disk_track_t *raw, const uint8_t *data, uint8_t secto
     }
     offset[0] = b | (offset[0] & (0xff >> shift));
 
+    GCR_INDEX_LOCK();
+    gcr_index.size = 0;
+    GCR_INDEX_UNLOCK();
+
     return CBMDOS_FDC_ERR_OK;
 }
 
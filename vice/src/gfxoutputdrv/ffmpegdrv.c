@@ -45,8 +45,13 @@
 #include "translate.h"
 #include "uiapi.h"
 #include "util.h"
+#include "vsyncapi.h"
 #include "../sounddrv/soundmovie.h"
 
+#ifdef USE_WORKER_THREADS
+#include <pthread.h>
+#endif
+
 static gfxoutputdrv_codec_t avi_audio_codeclist[] = {
     { AV_CODEC_ID_MP2, "MP2" },
     { AV_CODEC_ID_MP3, "MP3" },
@@ -154,6 +159,7 @@ static int video_bitrate;
 static int audio_codec;
 static int video_codec;
 static int video_halve_framerate;
+static int encode_queue;
 
 static int ffmpegdrv_init_file(void);
 
@@ -233,6 +239,27 @@ static int set_video_halve_framerate(int value, void *param)
     return 0;
 }
 
+#ifdef USE_WORKER_THREADS
+/* Highest value of `FFMPEGEncodeQueue'.  */
+#define FFMPEGDRV_QUEUE_MAX 64
+
+static int set_encode_queue(int val, void *param)
+{
+    if (val < 0 || val > FFMPEGDRV_QUEUE_MAX) {
+        return -1;
+    }
+
+    if (encode_queue != val && screenshot_is_recording()) {
+        ui_error("Can't change the encoder queue while recording. Try again later.");
+        return 0;
+    }
+
+    encode_queue = val;
+
+    return 0;
+}
+#endif
+
 /*---------- Resources ------------------------------------------------*/
 
 static const resource_string_t resources_string[] = {
@@ -254,6 +281,10 @@ static const resource_int_t resources_int[] = {
       &video_codec, set_video_codec, NULL },
     { "FFMPEGVideoHalveFramerate", 0, RES_EVENT_NO, NULL,
       &video_halve_framerate, set_video_halve_framerate, NULL },
+#ifdef USE_WORKER_THREADS
+    { "FFMPEGEncodeQueue", 0, RES_EVENT_NO, NULL,
+      &encode_queue, set_encode_queue, NULL },
+#endif
     RESOURCE_INT_LIST_END
 };
 
@@ -281,6 +312,13 @@ static const cmdline_option_t cmdline_options[] = {
       USE_PARAM_ID, USE_DESCRIPTION_ID,
       IDCLS_P_VALUE, IDCLS_SET_VIDEO_STREAM_BITRATE,
       NULL, NULL },
+#ifdef USE_WORKER_THREADS
+    { "-ffmpegencodequeue", SET_RESOURCE, 1,
+      NULL, NULL, "FFMPEGEncodeQueue", NULL,
+      USE_PARAM_STRING, USE_DESCRIPTION_STRING,
+      IDCLS_UNUSED, IDCLS_UNUSED,
+      "<number>", "Number of frames queued for the encoder thread (0: encode on the emulation thread)" },
+#endif
     CMDLINE_LIST_END
 };
 
@@ -308,6 +346,297 @@ static void close_stream(OutputStream *ost)
     VICE_P_AV_FRAME_FREE(&ost->tmp_frame);
 }
 
+/* Store the RGB values of `palette' in `rgb'.  */
+static void ffmpegdrv_palette_rgb(const palette_t *palette, uint8_t *rgb)
+{
+    unsigned int i;
+
+    memset(rgb, 0, 256 * 3);
+    for (i = 0; i < palette->num_entries && i < 256; i++) {
+        rgb[i * 3] = palette->entries[i].red;
+        rgb[i * 3 + 1] = palette->entries[i].green;
+        rgb[i * 3 + 2] = palette->entries[i].blue;
+    }
+}
+
+static int ffmpegdrv_encode_audio_frame(const int16_t *samples, int64_t pts);
+static int ffmpegdrv_encode_video_frame(const uint8_t *src, unsigned int pitch,
+                                        const uint8_t *rgb, int64_t pts);
+
+/*----------------*/
+/* encoder thread */
+/*----------------*/
+
+/* With `FFMPEGEncodeQueue' > 0, the frames are encoded and written on a
+   worker thread.  The emulation only copies the visible part of the
+   screen with the RGB values of its palette, or the audio samples, into
+   the next free slot of a queue and continues.  The timestamps are still
+   taken on the emulation thread, so the frames that are dropped are the
+   same.  When the queue is full, the emulation waits for a free slot
+   instead of dropping the frame, so the recording is not changed; how
+   long it waited is logged with the queue depth and encode times when
+   the recording is stopped.  */
+
+#ifdef USE_WORKER_THREADS
+
+#define FFMPEGDRV_JOB_VIDEO 0
+#define FFMPEGDRV_JOB_AUDIO 1
+
+typedef struct ffmpegdrv_job_s {
+    int type;
+    int64_t pts;
+
+    /* Indexed pixels, or audio samples.  */
+    uint8_t *data;
+    size_t data_size;
+
+    /* RGB values of the palette, for video frames.  */
+    uint8_t rgb[256 * 3];
+} ffmpegdrv_job_t;
+
+static ffmpegdrv_job_t queue_jobs[FFMPEGDRV_QUEUE_MAX];
+static int queue_size = 0;
+static int queue_head = 0;
+static int queue_count = 0;
+
+static pthread_t queue_thread;
+static int queue_running = 0;
+static int queue_stop = 0;
+
+static pthread_mutex_t queue_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t queue_cond = PTHREAD_COND_INITIALIZER;
+
+/* Samples are collected here by the sound code while the worker thread
+   uses the audio frames.  */
+static int16_t *queue_audio_buffer = NULL;
+
+/* Statistics, for the log when the recording is stopped.  */
+static unsigned long queue_video_frames;
+static unsigned long queue_audio_frames;
+static unsigned long queue_depth_total;
+static int queue_depth_max;
+static unsigned long queue_wait_time;
+static unsigned long queue_encode_time;
+static unsigned long queue_encode_max;
+
+static void *ffmpegdrv_queue_main(void *arg)
+{
+    ffmpegdrv_job_t *job;
+    unsigned long start, time;
+
+    pthread_mutex_lock(&queue_lock);
+
+    for (;;) {
+        while (queue_count == 0 && !queue_stop) {
+            pthread_cond_wait(&queue_cond, &queue_lock);
+        }
+        if (queue_count == 0) {
+            break;
+        }
+        job = &queue_jobs[queue_head];
+        pthread_mutex_unlock(&queue_lock);
+
+        start = vsyncarch_gettime();
+        if (job->type == FFMPEGDRV_JOB_VIDEO) {
+            ffmpegdrv_encode_video_frame(job->data, (unsigned int)video_width,
+                                         job->rgb, job->pts);
+        } else {
+            ffmpegdrv_encode_audio_frame((int16_t *)job->data, job->pts);
+        }
+        time = vsyncarch_gettime() - start;
+
+        pthread_mutex_lock(&queue_lock);
+
+        if (job->type == FFMPEGDRV_JOB_VIDEO) {
+            queue_video_frames++;
+            queue_encode_time += time;
+            if (time > queue_encode_max) {
+                queue_encode_max = time;
+            }
+        } else {
+            queue_audio_frames++;
+        }
+        queue_head = (queue_head + 1) % queue_size;
+        queue_count--;
+        pthread_cond_broadcast(&queue_cond);
+    }
+
+    pthread_mutex_unlock(&queue_lock);
+
+    return NULL;
+}
+
+/* Start the encoder thread for a new recording, if it is enabled.  */
+static void ffmpegdrv_queue_start(void)
+{
+    if (encode_queue == 0 || queue_running) {
+        return;
+    }
+
+    queue_size = encode_queue;
+    queue_head = 0;
+    queue_count = 0;
+    queue_stop = 0;
+
+    queue_video_frames = 0;
+    queue_audio_frames = 0;
+    queue_depth_total = 0;
+    queue_depth_max = 0;
+    queue_wait_time = 0;
+    queue_encode_time = 0;
+    queue_encode_max = 0;
+
+    if (pthread_create(&queue_thread, NULL, ffmpegdrv_queue_main, NULL) != 0) {
+        log_error(LOG_DEFAULT, "ffmpegdrv: Cannot create encoder thread, encoding on the emulation thread.");
+        return;
+    }
+    queue_running = 1;
+}
+
+/* Encode what is left in the queue, and stop the encoder thread.  */
+static void ffmpegdrv_queue_finish(void)
+{
+    double freq = (double)vsyncarch_frequency() / 1000.0;
+    int i;
+
+    if (!queue_running) {
+        return;
+    }
+
+    pthread_mutex_lock(&queue_lock);
+    queue_stop = 1;
+    pthread_cond_broadcast(&queue_cond);
+    pthread_mutex_unlock(&queue_lock);
+
+    pthread_join(queue_thread, NULL);
+    queue_running = 0;
+
+    log_message(LOG_DEFAULT,
+                "ffmpegdrv: %lu video and %lu audio frames encoded on the encoder thread, queue depth %.1f average, %d max.",
+                queue_video_frames, queue_audio_frames,
+                (queue_video_frames + queue_audio_frames) > 0
+                ? (double)queue_depth_total / (double)(queue_video_frames + queue_audio_frames) : 0.0,
+                queue_depth_max);
+    log_message(LOG_DEFAULT,
+                "ffmpegdrv: video encode time %.2f ms average, %.2f ms max, emulation waited %.2f ms for the queue.",
+                queue_video_frames > 0 ? (double)queue_encode_time / freq / (double)queue_video_frames : 0.0,
+                (double)queue_encode_max / freq, (double)queue_wait_time / freq);
+
+    for (i = 0; i < FFMPEGDRV_QUEUE_MAX; i++) {
+        lib_free(queue_jobs[i].data);
+        queue_jobs[i].data = NULL;
+        queue_jobs[i].data_size = 0;
+    }
+}
+
+/* Return the next free slot of the queue with room for `size' bytes of
+   data, waiting for one if the queue is full.  */
+static ffmpegdrv_job_t *ffmpegdrv_queue_get(int type, size_t size)
+{
+    ffmpegdrv_job_t *job;
+    unsigned long start;
+
+    pthread_mutex_lock(&queue_lock);
+    if (queue_count == queue_size) {
+        start = vsyncarch_gettime();
+        while (queue_count == queue_size) {
+            pthread_cond_wait(&queue_cond, &queue_lock);
+        }
+        queue_wait_time += vsyncarch_gettime() - start;
+    }
+    job = &queue_jobs[(queue_head + queue_count) % queue_size];
+    pthread_mutex_unlock(&queue_lock);
+
+    if (job->data_size < size) {
+        job->data = lib_realloc(job->data, size);
+        job->data_size = size;
+    }
+    job->type = type;
+
+    return job;
+}
+
+/* Hand the slot returned by ffmpegdrv_queue_get() to the encoder thread.  */
+static void ffmpegdrv_queue_put(void)
+{
+    pthread_mutex_lock(&queue_lock);
+    queue_count++;
+    queue_depth_total += queue_count;
+    if (queue_count > queue_depth_max) {
+        queue_depth_max = queue_count;
+    }
+    pthread_cond_broadcast(&queue_cond);
+    pthread_mutex_unlock(&queue_lock);
+}
+
+/* Queue `count' audio samples.  Return -1 if the caller has to encode
+   them itself.  */
+static int ffmpegdrv_queue_audio(const int16_t *samples, int count,
+                                 int64_t pts)
+{
+    ffmpegdrv_job_t *job;
+
+    if (!queue_running) {
+        return -1;
+    }
+
+    job = ffmpegdrv_queue_get(FFMPEGDRV_JOB_AUDIO, count * sizeof(int16_t));
+    memcpy(job->data, samples, count * sizeof(int16_t));
+    job->pts = pts;
+    ffmpegdrv_queue_put();
+
+    return 0;
+}
+
+/* Queue the video frame at `src'.  Return -1 if the caller has to encode
+   it itself.  */
+static int ffmpegdrv_queue_video(const uint8_t *src, unsigned int pitch,
+                                 const palette_t *palette, int64_t pts)
+{
+    ffmpegdrv_job_t *job;
+    int y;
+
+    if (!queue_running) {
+        return -1;
+    }
+
+    job = ffmpegdrv_queue_get(FFMPEGDRV_JOB_VIDEO,
+                              (size_t)video_width * video_height);
+    for (y = 0; y < video_height; y++) {
+        memcpy(job->data + y * video_width, src, video_width);
+        src += pitch;
+    }
+    ffmpegdrv_palette_rgb(palette, job->rgb);
+    job->pts = pts;
+    ffmpegdrv_queue_put();
+
+    return 0;
+}
+
+#else
+
+static void ffmpegdrv_queue_start(void)
+{
+}
+
+static void ffmpegdrv_queue_finish(void)
+{
+}
+
+static int ffmpegdrv_queue_audio(const int16_t *samples, int count,
+                                 int64_t pts)
+{
+    return -1;
+}
+
+static int ffmpegdrv_queue_video(const uint8_t *src, unsigned int pitch,
+                                 const palette_t *palette, int64_t pts)
+{
+    return -1;
+}
+
+#endif
+
 /*-----------------------*/
 /* audio stream encoding */
 /*-----------------------*/
@@ -375,6 +704,13 @@ static int ffmpegdrv_open_audio(AVFormatContext *oc, AVStream *st)
 
     ffmpegdrv_audio_in.size = audio_inbuf_samples * c->channels;
     ffmpegdrv_audio_in.buffer = (int16_t *)audio_st.tmp_frame->data[0];
+#ifdef USE_WORKER_THREADS
+    if (encode_queue > 0) {
+        queue_audio_buffer = lib_realloc(queue_audio_buffer,
+                                         ffmpegdrv_audio_in.size * sizeof(int16_t));
+        ffmpegdrv_audio_in.buffer = queue_audio_buffer;
+    }
+#endif
     return 0;
 }
 
@@ -391,6 +727,10 @@ static void ffmpegdrv_close_audio(void)
     audio_is_open = 0;
     ffmpegdrv_audio_in.buffer = NULL;
     ffmpegdrv_audio_in.size = 0;
+#ifdef USE_WORKER_THREADS
+    lib_free(queue_audio_buffer);
+    queue_audio_buffer = NULL;
+#endif
 #ifndef HAVE_FFMPEG_AVRESAMPLE
     VICE_P_SWR_FREE(&swr_ctx);
 #else
@@ -504,8 +844,8 @@ static int ffmpegmovie_init_audio(int speed, int channels, soundmovie_buffer_t *
     return 0;
 }
 
-/* triggered by soundffmpegaudio->write */
-static int ffmpegmovie_encode_audio(soundmovie_buffer_t *audio_in)
+/* Convert, encode and write the audio frame in `samples'.  */
+static int ffmpegdrv_encode_audio_frame(const int16_t *samples, int64_t pts)
 {
     int got_packet;
     int dst_nb_samples;
@@ -518,59 +858,79 @@ static int ffmpegmovie_encode_audio(soundmovie_buffer_t *audio_in)
     AVRational tmp;
 #endif
 
-    if (audio_st.st) {
-        audio_st.frame->pts = audio_st.next_pts;
-        audio_st.next_pts += audio_in->size;
+    audio_st.frame->pts = pts;
 
-        VICE_P_AV_INIT_PACKET(&pkt);
-        c = audio_st.st->codec;
+    VICE_P_AV_INIT_PACKET(&pkt);
+    c = audio_st.st->codec;
+
+    frame = audio_st.tmp_frame;
 
-        frame = audio_st.tmp_frame;
+    if (frame) {
+        if (samples != (int16_t *)frame->data[0]) {
+            memcpy(frame->data[0], samples,
+                   ffmpegdrv_audio_in.size * sizeof(int16_t));
+        }
 
-        if (frame) {
-            /* convert samples from native format to destination codec format, using the resampler */
-            /* compute destination number of samples */
+        /* convert samples from native format to destination codec format, using the resampler */
+        /* compute destination number of samples */
 #ifndef HAVE_FFMPEG_AVRESAMPLE
-            dst_nb_samples = (int)VICE_P_AV_RESCALE_RND(VICE_P_SWR_GET_DELAY(swr_ctx, c->sample_rate) + frame->nb_samples, c->sample_rate, c->sample_rate, AV_ROUND_UP);
+        dst_nb_samples = (int)VICE_P_AV_RESCALE_RND(VICE_P_SWR_GET_DELAY(swr_ctx, c->sample_rate) + frame->nb_samples, c->sample_rate, c->sample_rate, AV_ROUND_UP);
 #else
-            dst_nb_samples = (int)VICE_P_AV_RESCALE_RND(VICE_P_AVRESAMPLE_GET_DELAY(avr_ctx, c->sample_rate) + frame->nb_samples, c->sample_rate, c->sample_rate, AV_ROUND_UP);
+        dst_nb_samples = (int)VICE_P_AV_RESCALE_RND(VICE_P_AVRESAMPLE_GET_DELAY(avr_ctx, c->sample_rate) + frame->nb_samples, c->sample_rate, c->sample_rate, AV_ROUND_UP);
 #endif
 
-            /* when we pass a frame to the encoder, it may keep a reference to it
-            * internally;
-            * make sure we do not overwrite it here
-            */
-            ret = VICE_P_AV_FRAME_MAKE_WRITABLE(audio_st.frame);
-            if (ret < 0)
-                return -1;
+        /* when we pass a frame to the encoder, it may keep a reference to it
+        * internally;
+        * make sure we do not overwrite it here
+        */
+        ret = VICE_P_AV_FRAME_MAKE_WRITABLE(audio_st.frame);
+        if (ret < 0)
+            return -1;
 
-            /* convert to destination format */
+        /* convert to destination format */
 #ifndef HAVE_FFMPEG_AVRESAMPLE
-            ret = VICE_P_SWR_CONVERT(swr_ctx, audio_st.frame->data, dst_nb_samples, (const uint8_t **)frame->data, frame->nb_samples);
+        ret = VICE_P_SWR_CONVERT(swr_ctx, audio_st.frame->data, dst_nb_samples, (const uint8_t **)frame->data, frame->nb_samples);
 #else
-            ret = VICE_P_AVRESAMPLE_CONVERT(avr_ctx, audio_st.frame->data, 0, dst_nb_samples, (const uint8_t **)frame->data, 0, frame->nb_samples);
+        ret = VICE_P_AVRESAMPLE_CONVERT(avr_ctx, audio_st.frame->data, 0, dst_nb_samples, (const uint8_t **)frame->data, 0, frame->nb_samples);
 #endif
-            if (ret < 0) {
-                log_debug("ffmpegdrv_encode_audio: Error while converting audio frame");
-                return -1;
-            }
-            frame = audio_st.frame;
+        if (ret < 0) {
+            log_debug("ffmpegdrv_encode_audio: Error while converting audio frame");
+            return -1;
+        }
+        frame = audio_st.frame;
 #ifdef _MSC_VER
-            tmp.num = 1;
-            tmp.den = c->sample_rate;
-            frame->pts = VICE_P_AV_RESCALE_Q(audio_st.samples_count, tmp, c->time_base);
+        tmp.num = 1;
+        tmp.den = c->sample_rate;
+        frame->pts = VICE_P_AV_RESCALE_Q(audio_st.samples_count, tmp, c->time_base);
 #else
-            frame->pts = VICE_P_AV_RESCALE_Q(audio_st.samples_count, (AVRational){ 1, c->sample_rate }, c->time_base);
+        frame->pts = VICE_P_AV_RESCALE_Q(audio_st.samples_count, (AVRational){ 1, c->sample_rate }, c->time_base);
 #endif
-            audio_st.samples_count += dst_nb_samples;
+        audio_st.samples_count += dst_nb_samples;
+    }
+
+    ret = VICE_P_AVCODEC_ENCODE_AUDIO2(audio_st.st->codec, &pkt, audio_st.frame, &got_packet);
+    if (got_packet) {
+        if (write_frame(ffmpegdrv_oc, &c->time_base, audio_st.st, &pkt)<0)
+        {
+            log_debug("ffmpegdrv_encode_audio: Error while writing audio frame");
         }
+    }
 
-        ret = VICE_P_AVCODEC_ENCODE_AUDIO2(audio_st.st->codec, &pkt, audio_st.frame, &got_packet);
-        if (got_packet) {
-            if (write_frame(ffmpegdrv_oc, &c->time_base, audio_st.st, &pkt)<0)
-            {
-                log_debug("ffmpegdrv_encode_audio: Error while writing audio frame");
-            }
+    return 0;
+}
+
+/* triggered by soundffmpegaudio->write */
+static int ffmpegmovie_encode_audio(soundmovie_buffer_t *audio_in)
+{
+    int64_t pts;
+
+    if (audio_st.st) {
+        pts = audio_st.next_pts;
+        audio_st.next_pts += audio_in->size;
+
+        if (ffmpegdrv_queue_audio(audio_in->buffer, audio_in->size, pts) < 0
+            && ffmpegdrv_encode_audio_frame(audio_in->buffer, pts) < 0) {
+            return -1;
         }
     }
 
@@ -593,29 +953,36 @@ static soundmovie_funcs_t ffmpegdrv_soundmovie_funcs = {
 /*-----------------------*/
 /* video stream encoding */
 /*-----------------------*/
-static int ffmpegdrv_fill_rgb_image(screenshot_t *screenshot, AVFrame *pic)
+/* Return the top left pixel of the part of the screen that is recorded.  */
+static const uint8_t *ffmpegdrv_frame_source(screenshot_t *screenshot)
 {
-    int x, y;
     int dx, dy;
-    int colnum;
-    int bufferoffset;
     int x_dim = screenshot->width;
     int y_dim = screenshot->height;
-    int pix = 0;
+
     /* center the screenshot in the video */
     dx = (video_width - x_dim) / 2;
     dy = (video_height - y_dim) / 2;
-    bufferoffset = screenshot->x_offset + (dx < 0 ? -dx : 0)
-        + (screenshot->y_offset + (dy < 0 ? -dy : 0)) * screenshot->draw_buffer_line_size;
+
+    return screenshot->draw_buffer + screenshot->x_offset + (dx < 0 ? -dx : 0)
+           + (screenshot->y_offset + (dy < 0 ? -dy : 0)) * screenshot->draw_buffer_line_size;
+}
+
+static int ffmpegdrv_fill_rgb_image(const uint8_t *src, unsigned int pitch,
+                                    const uint8_t *rgb, AVFrame *pic)
+{
+    int x, y;
+    int colnum;
+    int pix = 0;
 
     for (y = 0; y < video_height; y++) {
         for (x = 0; x < video_width; x++) {
-            colnum = screenshot->draw_buffer[bufferoffset + x];
-            pic->data[0][pix + 3*x] = screenshot->palette->entries[colnum].red;
-            pic->data[0][pix + 3*x + 1] = screenshot->palette->entries[colnum].green;
-            pic->data[0][pix + 3*x + 2] = screenshot->palette->entries[colnum].blue;
+            colnum = src[x] * 3;
+            pic->data[0][pix + 3*x] = rgb[colnum];
+            pic->data[0][pix + 3*x + 1] = rgb[colnum + 1];
+            pic->data[0][pix + 3*x + 2] = rgb[colnum + 2];
         }
-        bufferoffset += screenshot->draw_buffer_line_size;
+        src += pitch;
         pix += pic->linesize[0];
     }
 
@@ -830,6 +1197,8 @@ static int ffmpegdrv_init_file(void)
 
     file_init_done = 1;
 
+    ffmpegdrv_queue_start();
+
     return 0;
 }
 
@@ -888,6 +1257,8 @@ static int ffmpegdrv_close(screenshot_t *screenshot)
 {
     unsigned int i;
 
+    ffmpegdrv_queue_finish();
+
     /* write the trailer, if any */
     if (file_init_done) {
         VICE_P_AV_WRITE_TRAILER(ffmpegdrv_oc);
@@ -921,35 +1292,18 @@ static int ffmpegdrv_close(screenshot_t *screenshot)
     return 0;
 }
 
-/* triggered by screenshot_record */
-static int ffmpegdrv_record(screenshot_t *screenshot)
+/* Convert, encode and write the video frame at `src', using the RGB values
+   in `rgb'.  */
+static int ffmpegdrv_encode_video_frame(const uint8_t *src, unsigned int pitch,
+                                        const uint8_t *rgb, int64_t pts)
 {
     AVCodecContext *c;
     int ret;
 
-    if (audio_init_done && video_init_done && !file_init_done) {
-        ffmpegdrv_init_file();
-    }
-
-    if (video_st.st == NULL || !file_init_done) {
-        return 0;
-    }
-
-   if (audio_st.st && video_st.next_pts > audio_st.next_pts) {
-        /* drop this frame */
-        return 0;
-    }
-
-    framecounter++;
-    if (video_halve_framerate && (framecounter & 1)) {
-        /* drop every second frame */
-        return 0;
-    }
-
     c = video_st.st->codec;
 
     if (c->pix_fmt != VICE_AV_PIX_FMT_RGB24) {
-        ffmpegdrv_fill_rgb_image(screenshot, video_st.tmp_frame);
+        ffmpegdrv_fill_rgb_image(src, pitch, rgb, video_st.tmp_frame);
 
         if (sws_ctx != NULL) {
             VICE_P_SWS_SCALE(sws_ctx,
@@ -962,10 +1316,10 @@ static int ffmpegdrv_record(screenshot_t *screenshot)
                 video_st.frame->data, video_st.frame->linesize);
         }
     } else {
-        ffmpegdrv_fill_rgb_image(screenshot, video_st.frame);
+        ffmpegdrv_fill_rgb_image(src, pitch, rgb, video_st.frame);
     }
 
-    video_st.frame->pts = video_st.next_pts++;
+    video_st.frame->pts = pts;
 
     if (ffmpegdrv_oc->oformat->flags & AVFMT_RAWPICTURE) {
         AVPacket pkt;
@@ -1007,6 +1361,46 @@ static int ffmpegdrv_record(screenshot_t *screenshot)
     return 0;
 }
 
+/* triggered by screenshot_record */
+static int ffmpegdrv_record(screenshot_t *screenshot)
+{
+    const uint8_t *src;
+    uint8_t rgb[256 * 3];
+    int64_t pts;
+
+    if (audio_init_done && video_init_done && !file_init_done) {
+        ffmpegdrv_init_file();
+    }
+
+    if (video_st.st == NULL || !file_init_done) {
+        return 0;
+    }
+
+   if (audio_st.st && video_st.next_pts > audio_st.next_pts) {
+        /* drop this frame */
+        return 0;
+    }
+
+    framecounter++;
+    if (video_halve_framerate && (framecounter & 1)) {
+        /* drop every second frame */
+        return 0;
+    }
+
+    src = ffmpegdrv_frame_source(screenshot);
+    pts = video_st.next_pts++;
+
+    if (ffmpegdrv_queue_video(src, screenshot->draw_buffer_line_size,
+                              screenshot->palette, pts) == 0) {
+        return 0;
+    }
+
+    ffmpegdrv_palette_rgb(screenshot->palette, rgb);
+
+    return ffmpegdrv_encode_video_frame(src, screenshot->draw_buffer_line_size,
+                                        rgb, pts);
+}
+
 static int ffmpegdrv_write(screenshot_t *screenshot)
 {
     return 0;
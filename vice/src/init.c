@@ -29,10 +29,12 @@
 
 #include "archdep.h"
 #include "attach.h"
+#include "benchmark.h"
 #include "cmdline.h"
 #include "console.h"
 #include "debug.h"
 #include "drive.h"
+#include "forkserver.h"
 #include "initcmdline.h"
 #include "keyboard.h"
 #include "log.h"
@@ -47,6 +49,7 @@
 #include "palette.h"
 #include "ram.h"
 #include "resources.h"
+#include "rewind.h"
 #include "romset.h"
 #include "screenshot.h"
 #include "signals.h"
@@ -103,6 +106,12 @@ int init_resources(void)
         init_resource_fail("vsync");
         return -1;
     }
+    if (machine_class != VICE_MACHINE_VSID) {
+        if (rewind_resources_init() < 0) {
+            init_resource_fail("rewind");
+            return -1;
+        }
+    }
     if (sound_resources_init() < 0) {
         init_resource_fail("sound");
         return -1;
@@ -182,6 +191,20 @@ int init_cmdline_options(void)
         init_cmdline_options_fail("vsync");
         return -1;
     }
+    if (benchmark_cmdline_options_init() < 0) {
+        init_cmdline_options_fail("benchmark");
+        return -1;
+    }
+    if (forkserver_cmdline_options_init() < 0) {
+        init_cmdline_options_fail("fork server");
+        return -1;
+    }
+    if (machine_class != VICE_MACHINE_VSID) {
+        if (rewind_cmdline_options_init() < 0) {
+            init_cmdline_options_fail("rewind");
+            return -1;
+        }
+    }
     if (sound_cmdline_options_init() < 0) {
         init_cmdline_options_fail("sound");
         return -1;
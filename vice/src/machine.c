@@ -57,8 +57,10 @@
 #include "network.h"
 #include "printer.h"
 #include "resources.h"
+#include "rewind.h"
 #include "romset.h"
 #include "screenshot.h"
+#include "sid/sid-resources.h"
 #include "sound.h"
 #include "sysfile.h"
 #include "tape.h"
@@ -280,6 +282,9 @@ void machine_shutdown(void)
         return;
     }
 
+    videothread_shutdown();
+    renderthread_shutdown();
+
     screenshot_at_exit();
     screenshot_shutdown();
 
@@ -333,10 +338,13 @@ void machine_shutdown(void)
 
     event_shutdown();
 
+    rewind_shutdown();
+
     network_shutdown();
 
     autostart_resources_shutdown();
     sound_resources_shutdown();
+    sid_resources_shutdown();
     video_resources_shutdown();
     machine_resources_shutdown();
     machine_common_resources_shutdown();
@@ -47,10 +47,12 @@
 #endif
 
 #include "archdep.h"
+#include "benchmark.h"
 #include "cmdline.h"
 #include "console.h"
 #include "debug.h"
 #include "drive.h"
+#include "forkserver.h"
 #include "fullscreen.h"
 #include "gfxoutput.h"
 #include "info.h"
@@ -108,7 +110,7 @@ int main_program(int argc, char **argv)
     char term_tmp[TERM_TMP_SIZE];
     size_t name_len;
 
-
+    benchmark_init();
     lib_init_rand();
 
     /* Check for -config and -console before initializing the user interface.
@@ -286,6 +288,8 @@ int main_program(int argc, char **argv)
 
     /* Let's go...  */
     log_message(LOG_DEFAULT, "Main CPU: starting at ($FFFC).");
+    benchmark_start();
+    forkserver_start();
     maincpu_mainloop();
 
     log_error(LOG_DEFAULT, "perkele!");
@@ -32,6 +32,7 @@
 
 #include "6510core.h"
 #include "alarm.h"
+#include "benchmark.h"
 #include "clkguard.h"
 #include "debug.h"
 #include "interrupt.h"
@@ -343,6 +344,7 @@ void maincpu_mainloop(void)
         maincpu_int_status->num_dma_per_opcode = 0;
 
         if (maincpu_clk_limit && (maincpu_clk > maincpu_clk_limit)) {
+            benchmark_finish();
             log_error(LOG_DEFAULT, "cycle limit reached.");
             exit(EXIT_FAILURE);
         }
@@ -71,6 +71,7 @@ static checkpoint_list_t *breakpoints[NUM_MEMSPACES];
 static checkpoint_list_t *watchpoints_load[NUM_MEMSPACES];
 static checkpoint_list_t *watchpoints_store[NUM_MEMSPACES];
 
+uint8_t *mon_breakpoint_map[NUM_MEMSPACES];
 
 void mon_breakpoint_init(void)
 {
@@ -140,8 +141,59 @@ static checkpoint_t *find_checkpoint(int brknum)
     return NULL;
 }
 
+static void map_checkpoint_list(uint8_t *map, checkpoint_list_t *ptr,
+                                uint8_t op)
+{
+    unsigned int first, last, i;
+
+    for (; ptr != NULL; ptr = ptr->next) {
+        first = addr_location(ptr->checkpt->start_addr);
+        if (mon_is_valid_addr(ptr->checkpt->end_addr)) {
+            last = addr_location(ptr->checkpt->end_addr);
+        } else {
+            last = first;
+        }
+        first = (first >> MON_BREAKPOINT_MAP_SHIFT) & (MON_BREAKPOINT_MAP_SIZE - 1);
+        last = (last >> MON_BREAKPOINT_MAP_SHIFT) & (MON_BREAKPOINT_MAP_SIZE - 1);
+
+        /* Ranges may wrap around.  */
+        for (i = first; ; i = (i + 1) & (MON_BREAKPOINT_MAP_SIZE - 1)) {
+            map[i] |= op;
+            if (i == last) {
+                break;
+            }
+        }
+    }
+}
+
+/* Rebuild the map of `mem' from its checkpoint lists.  */
+static void update_checkpoint_map(MEMSPACE mem)
+{
+    uint8_t *map = mon_breakpoint_map[mem];
+
+    if (breakpoints[mem] == NULL && watchpoints_load[mem] == NULL
+        && watchpoints_store[mem] == NULL) {
+        mon_breakpoint_map[mem] = NULL;
+        lib_free(map);
+        return;
+    }
+
+    if (map == NULL) {
+        map = lib_malloc(MON_BREAKPOINT_MAP_SIZE);
+    }
+    memset(map, 0, MON_BREAKPOINT_MAP_SIZE);
+
+    map_checkpoint_list(map, breakpoints[mem], e_exec);
+    map_checkpoint_list(map, watchpoints_load[mem], e_load);
+    map_checkpoint_list(map, watchpoints_store[mem], e_store);
+
+    mon_breakpoint_map[mem] = map;
+}
+
 static void update_checkpoint_state(MEMSPACE mem)
 {
+    update_checkpoint_map(mem);
+
     if (watchpoints_load[mem] != NULL || watchpoints_store[mem] != NULL) {
         monitor_mask[mem] |= MI_WATCH;
         mon_interfaces[mem]->toggle_watchpoints_func(
@@ -403,6 +455,10 @@ bool mon_breakpoint_check_checkpoint(MEMSPACE mem, unsigned int addr, unsigned i
     const char *action_str;
     int monbank = mon_interfaces[mem]->current_bank;
 
+    if (!mon_breakpoint_might_hit(mem, addr, op)) {
+        return FALSE;
+    }
+
     monitor_cpu = monitor_cpu_for_memspace[mem];
     instpc = new_addr(mem, (monitor_cpu->mon_register_get_val)(mem, e_PC));
     loadstorepc = new_addr(mem, lastpc);
@@ -623,6 +679,7 @@ void mon_breakpoint_unset(MON_ADDR address)
     if (ptr) {
         /* there's a breakpoint, so remove it */
         remove_checkpoint_from_list( &breakpoints[mem], ptr->checkpt );
+        update_checkpoint_state(mem);
     }
 }
 
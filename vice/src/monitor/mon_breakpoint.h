@@ -35,6 +35,25 @@ typedef enum mon_breakpoint_type_e {
     BP_ACTIVE
 } mon_breakpoint_type_t;
 
+/* Each entry of a map covers one address, or a page of 256 addresses with
+   24-bit memspaces, and has the e_load/e_store/e_exec bits of the
+   checkpoints covering it set.  */
+#ifndef HAVE_MEMSPACE24
+#define MON_BREAKPOINT_MAP_SHIFT 0
+#else
+#define MON_BREAKPOINT_MAP_SHIFT 8
+#endif
+#define MON_BREAKPOINT_MAP_SIZE 0x10000
+
+/* NULL for memspaces without checkpoints.  */
+extern uint8_t *mon_breakpoint_map[NUM_MEMSPACES];
+
+/* Nonzero if a checkpoint of type `op' may cover `addr'.  */
+#define mon_breakpoint_might_hit(mem, addr, op)                          \
+    (mon_breakpoint_map[(mem)] != NULL                                   \
+     && (mon_breakpoint_map[(mem)][((addr) >> MON_BREAKPOINT_MAP_SHIFT)  \
+                                   & (MON_BREAKPOINT_MAP_SIZE - 1)] & (op)))
+
 extern void mon_breakpoint_init(void);
 
 extern void mon_breakpoint_switch_checkpoint(int op, int breakpt_num);
@@ -172,6 +172,13 @@ static const mon_cmds_t mon_cmd_array[] = {
       IDGS_MON_SCREEN_DESCRIPTION,
       NULL, NULL },
 
+    { "rewind", "",
+      USE_PARAM_ID, USE_DESCRIPTION_STRING,
+      "[<%s>]", 1,
+      { IDGS_COUNT, IDGS_UNUSED, IDGS_UNUSED, IDGS_UNUSED },
+      IDGS_UNUSED,
+      NULL, "Go back to the <count>th newest rewind point (1 by default).\nSee the RewindEnabled resource." },
+
     { "step", "z",
       USE_PARAM_ID, USE_DESCRIPTION_ID,
       "[<%s>]", 1,
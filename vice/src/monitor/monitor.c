@@ -81,6 +81,7 @@
 #include "monitor_network.h"
 #include "montypes.h"
 #include "resources.h"
+#include "rewind.h"
 #include "screenshot.h"
 #include "sysfile.h"
 #include "translate.h"
@@ -1839,6 +1840,20 @@ void mon_instruction_return(void)
     interrupt_monitor_trap_on(mon_interfaces[default_memspace]->int_status);
 }
 
+void mon_rewind(int count)
+{
+    int points = rewind_points();
+
+    if (count < 1 || count > points) {
+        mon_out("There are %d rewind point(s).\n", points);
+        return;
+    }
+
+    if (rewind_restore(count) < 0) {
+        mon_out("Cannot go back to rewind point %d.\n", count);
+    }
+}
+
 void mon_stack_up(int count)
 {
     mon_out("Going up %d stack frame(s).\n", (count >= 0) ? count : 1);
@@ -1975,7 +1990,7 @@ void mon_delete_conditional(cond_node_t *cnode)
 
 void monitor_watch_push_load_addr(uint16_t addr, MEMSPACE mem)
 {
-    if (inside_monitor) {
+    if (inside_monitor || !mon_breakpoint_might_hit(mem, addr, e_load)) {
         return;
     }
 
@@ -1990,7 +2005,7 @@ void monitor_watch_push_load_addr(uint16_t addr, MEMSPACE mem)
 
 void monitor_watch_push_store_addr(uint16_t addr, MEMSPACE mem)
 {
-    if (inside_monitor) {
+    if (inside_monitor || !mon_breakpoint_might_hit(mem, addr, e_store)) {
         return;
     }
 
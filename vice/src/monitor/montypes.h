@@ -252,6 +252,7 @@ extern void mon_display_screen(void);
 extern void mon_instructions_step(int count);
 extern void mon_instructions_next(int count);
 extern void mon_instruction_return(void);
+extern void mon_rewind(int count);
 extern void mon_stack_up(int count);
 extern void mon_stack_down(int count);
 extern void mon_print_convert(int val);
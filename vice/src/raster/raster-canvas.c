@@ -97,9 +97,11 @@ inline static void refresh_canvas(raster_t *raster)
 
     if ((int)(raster->canvas->draw_buffer->canvas_height) >= yy
         && (int)(raster->canvas->draw_buffer->canvas_width) >= xx) {
-        video_canvas_refresh(raster->canvas, x, y, xx, yy,
-                             MIN(w, (int)(raster->canvas->draw_buffer->canvas_width - xx)),
-                             MIN(h, (int)(raster->canvas->draw_buffer->canvas_height - yy)));
+        w = MIN(w, (int)(raster->canvas->draw_buffer->canvas_width - xx));
+        h = MIN(h, (int)(raster->canvas->draw_buffer->canvas_height - yy));
+        if (videothread_refresh(raster->canvas, 0, x, y, xx, yy, w, h) < 0) {
+            video_canvas_refresh(raster->canvas, x, y, xx, yy, w, h);
+        }
     }
 
     update_area->is_null = 1;
@@ -120,7 +122,9 @@ void raster_canvas_handle_end_of_frame(raster_t *raster)
     }
 
     if (raster->dont_cache) {
-        video_canvas_refresh_all(raster->canvas);
+        if (videothread_refresh(raster->canvas, 1, 0, 0, 0, 0, 0, 0) < 0) {
+            video_canvas_refresh_all(raster->canvas);
+        }
     } else {
         refresh_canvas(raster);
     }
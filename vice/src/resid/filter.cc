@@ -175,8 +175,6 @@ static model_filter_init_t model_filter_init[2] = {
     }
 };
 
-unsigned short Filter::vcr_kVg[1 << 16];
-unsigned short Filter::vcr_n_Ids_term[1 << 16];
 
 #if defined(__amiga__) && defined(__mc68000__)
 #undef HAS_LOG1P
@@ -189,7 +187,14 @@ static double log1p(double x)
 }
 #endif
 
-Filter::model_filter_t Filter::model_filter[2];
+const Filter::tables_t* Filter::tables;
+const unsigned short* Filter::vcr_kVg;
+const unsigned short* Filter::vcr_n_Ids_term;
+const Filter::model_filter_t* Filter::model_filter;
+
+// "rSFT" and the version of the table layout and calculation.
+#define FILTER_TABLES_MAGIC 0x72534654
+#define FILTER_TABLES_VERSION 1
 
 
 // ----------------------------------------------------------------------------
@@ -197,16 +202,103 @@ Filter::model_filter_t Filter::model_filter[2];
 // ----------------------------------------------------------------------------
 Filter::Filter()
 {
-    static bool class_init;
+    if (!tables) {
+        build_tables();
+    }
+
+    enable_filter(true);
+    set_chip_model(MOS6581);
+    set_voice_mask(0x07);
+    input(0);
+    reset();
+}
+
+
+// ----------------------------------------------------------------------------
+// Model tables.
+// The tables take some 17MB and their calculation a noticeable part of the
+// startup time. tables_data() returns them as one block of memory, which
+// a later process can pass to use_tables() (e.g. mapped from a file) before
+// the first Filter is constructed, so that they are not calculated again.
+// The block is only accepted if it was calculated by the same version of
+// this code, for the same model parameters, with the same layout.
+// ----------------------------------------------------------------------------
+unsigned int Filter::tables_size()
+{
+    return sizeof(tables_t);
+}
+
+const void* Filter::tables_data()
+{
+    if (!tables) {
+        build_tables();
+    }
+    return tables;
+}
+
+bool Filter::use_tables(const void* data, unsigned int size)
+{
+    const tables_t* t = (const tables_t*)data;
+
+    if (tables || size != sizeof(tables_t)
+        || t->magic != FILTER_TABLES_MAGIC
+        || t->version != FILTER_TABLES_VERSION
+        || t->size != sizeof(tables_t)
+        || t->params != tables_params())
+    {
+        return false;
+    }
+
+    tables = t;
+    model_filter = t->model_filter;
+    vcr_kVg = t->vcr_kVg;
+    vcr_n_Ids_term = t->vcr_n_Ids_term;
+
+    return true;
+}
+
+// Hash of the model parameters the tables are calculated from.
+unsigned int Filter::tables_params()
+{
+    unsigned int hash = 2166136261u;
+
+    for (int m = 0; m < 2; m++) {
+        model_filter_init_t& fi = model_filter_init[m];
+        double values[] = {
+            fi.voice_voltage_range, fi.voice_DC_voltage, fi.C, fi.Vdd, fi.Vth,
+            fi.Ut, fi.k, fi.uCox, fi.WL_vcr, fi.WL_snake, fi.dac_zero,
+            fi.dac_scale, fi.dac_2R_div_R, fi.dac_term ? 1.0 : 0.0
+        };
+        const unsigned char* p = (const unsigned char*)values;
+        for (unsigned int i = 0; i < sizeof(values); i++) {
+            hash = (hash ^ p[i])*16777619u;
+        }
+        p = (const unsigned char*)fi.opamp_voltage;
+        for (unsigned int i = 0; i < fi.opamp_voltage_size*sizeof(*fi.opamp_voltage); i++) {
+            hash = (hash ^ p[i])*16777619u;
+        }
+    }
+
+    return hash;
+}
+
+void Filter::build_tables()
+{
+    tables_t* t = new tables_t;
 
-    if (!class_init) {
+    t->magic = FILTER_TABLES_MAGIC;
+    t->version = FILTER_TABLES_VERSION;
+    t->size = sizeof(tables_t);
+    t->params = tables_params();
+
+    {
         // Temporary table for op-amp transfer function.
         unsigned int* voltages = new unsigned int[1 << 16];
         opamp_t* opamp = new opamp_t[1 << 16];
 
         for (int m = 0; m < 2; m++) {
             model_filter_init_t& fi = model_filter_init[m];
-            model_filter_t& mf = model_filter[m];
+            model_filter_t& mf = t->model_filter[m];
 
             // Convert op-amp voltage transfer to 16 bit values.
             double vmin = fi.opamp_voltage[0][0];
@@ -380,7 +472,7 @@ Filter::Filter()
         // VCR - 6581 only.
         model_filter_init_t& fi = model_filter_init[0];
 
-        double N16 = model_filter[0].vo_N16;
+        double N16 = t->model_filter[0].vo_N16;
         double vmin = N16*fi.opamp_voltage[0][0];
         double k = fi.k;
         double kVddt = N16*(k*(fi.Vdd - fi.Vth));
@@ -396,7 +488,7 @@ Filter::Filter()
             //
             // I.e. k*Vg - t must be returned.
             double Vg = kVddt - sqrt((double)i*(1 << 16));
-            vcr_kVg[i] = (unsigned short)(k*Vg - vmin + 0.5);
+            t->vcr_kVg[i] = (unsigned short)(k*Vg - vmin + 0.5);
         }
 
         /*
@@ -419,17 +511,14 @@ Filter::Filter()
         for (int kVg_Vx = 0; kVg_Vx < (1 << 16); kVg_Vx++) {
             double log_term = log1p(exp((kVg_Vx/N16 - kVt)/(2*Ut)));
             // Scaled by m*2^15
-            vcr_n_Ids_term[kVg_Vx] = (unsigned short)(n_Is*log_term*log_term);
+            t->vcr_n_Ids_term[kVg_Vx] = (unsigned short)(n_Is*log_term*log_term);
         }
-
-        class_init = true;
     }
 
-    enable_filter(true);
-    set_chip_model(MOS6581);
-    set_voice_mask(0x07);
-    input(0);
-    reset();
+    tables = t;
+    model_filter = t->model_filter;
+    vcr_kVg = t->vcr_kVg;
+    vcr_n_Ids_term = t->vcr_n_Ids_term;
 }
 
 
@@ -539,7 +628,7 @@ void Filter::writeMODE_VOL(reg8 mode_vol)
 // Set filter cutoff frequency.
 void Filter::set_w0()
 {
-    model_filter_t& f = model_filter[sid_model];
+    const model_filter_t& f = model_filter[sid_model];
     int Vw = Vw_bias + f.f0_dac[fc];
     Vddt_Vw_2 = unsigned(f.kVddt - Vw)*unsigned(f.kVddt - Vw) >> 1;
 
@@ -369,6 +369,12 @@ public:
   // SID audio output (16 bits).
   short output();
 
+  // The model tables as one block of memory, which can be stored and used
+  // by later processes instead of calculating the tables again.
+  static unsigned int tables_size();
+  static const void* tables_data();
+  static bool use_tables(const void* data, unsigned int size);
+
 protected:
   void set_sum_mix();
   void set_w0();
@@ -448,14 +454,32 @@ protected:
     unsigned short f0_dac[1 << 11];
   } model_filter_t;
 
-  int solve_gain(opamp_t* opamp, int n, int vi_t, int& x, model_filter_t& mf);
-  int solve_integrate_6581(int dt, int vi_t, int& x, int& vc, model_filter_t& mf);
+  static int solve_gain(opamp_t* opamp, int n, int vi_t, int& x, const model_filter_t& mf);
+  int solve_integrate_6581(int dt, int vi_t, int& x, int& vc, const model_filter_t& mf);
+
+  typedef struct {
+    // Identifies the layout and the model parameters the tables were
+    // calculated for.
+    unsigned int magic;
+    unsigned int version;
+    unsigned int size;
+    unsigned int params;
+
+    model_filter_t model_filter[2];
+    unsigned short vcr_kVg[1 << 16];
+    unsigned short vcr_n_Ids_term[1 << 16];
+  } tables_t;
+
+  static void build_tables();
+  static unsigned int tables_params();
+
+  static const tables_t* tables;
 
   // VCR - 6581 only.
-  static unsigned short vcr_kVg[1 << 16];
-  static unsigned short vcr_n_Ids_term[1 << 16];
+  static const unsigned short* vcr_kVg;
+  static const unsigned short* vcr_n_Ids_term;
   // Common parameters.
-  static model_filter_t model_filter[2];
+  static const model_filter_t* model_filter;
 
 friend class SID;
 };
@@ -475,7 +499,7 @@ friend class SID;
 RESID_INLINE
 void Filter::clock(int voice1, int voice2, int voice3)
 {
-  model_filter_t& f = model_filter[sid_model];
+  const model_filter_t& f = model_filter[sid_model];
 
   v1 = (voice1*f.voice_scale_s14 >> 18) + f.voice_DC;
   v2 = (voice2*f.voice_scale_s14 >> 18) + f.voice_DC;
@@ -579,7 +603,7 @@ void Filter::clock(int voice1, int voice2, int voice3)
 RESID_INLINE
 void Filter::clock(cycle_count delta_t, int voice1, int voice2, int voice3)
 {
-  model_filter_t& f = model_filter[sid_model];
+  const model_filter_t& f = model_filter[sid_model];
 
   v1 = (voice1*f.voice_scale_s14 >> 18) + f.voice_DC;
   v2 = (voice2*f.voice_scale_s14 >> 18) + f.voice_DC;
@@ -724,7 +748,7 @@ void Filter::input(short sample)
   // The upside is that the MOS8580 "digi boost" works without a separate (DC)
   // input interface.
   // Note that the input is 16 bits, compared to the 20 bit voice output.
-  model_filter_t& f = model_filter[sid_model];
+  const model_filter_t& f = model_filter[sid_model];
   ve = (sample*f.voice_scale_s14*3 >> 14) + f.mixer[0];
 }
 
@@ -735,7 +759,7 @@ void Filter::input(short sample)
 RESID_INLINE
 short Filter::output()
 {
-  model_filter_t& f = model_filter[sid_model];
+  const model_filter_t& f = model_filter[sid_model];
 
   // Writing the switch below manually would be tedious and error-prone;
   // it is rather generated by the following Perl program:
@@ -1329,7 +1353,7 @@ the equations for the root function and its derivative can be written as:
   df = 2*((b - (vx + x))*(dvx + 1) - a*(b - vx)*dvx)
 */
 RESID_INLINE
-int Filter::solve_gain(opamp_t* opamp, int n, int vi, int& x, model_filter_t& mf)
+int Filter::solve_gain(opamp_t* opamp, int n, int vi, int& x, const model_filter_t& mf)
 {
   // Note that all variables are translated and scaled in order to fit
   // in 16 bits. It is not necessary to explicitly translate the variables here,
@@ -1525,7 +1549,7 @@ Vg = Vddt - sqrt(((Vddt - vi)^2 + (Vddt - Vw)^2)/2)
 
 */
 RESID_INLINE
-int Filter::solve_integrate_6581(int dt, int vi, int& vx, int& vc, model_filter_t& mf)
+int Filter::solve_integrate_6581(int dt, int vi, int& vx, int& vc, const model_filter_t& mf)
 {
   // Note that all variables are translated and scaled in order to fit
   // in 16 bits. It is not necessary to explicitly translate the variables here,
@@ -542,6 +542,25 @@ Filter::Filter()
 }
 
 
+// ----------------------------------------------------------------------------
+// Model tables.
+// ----------------------------------------------------------------------------
+unsigned int Filter::tables_size()
+{
+  return 0;
+}
+
+const void* Filter::tables_data()
+{
+  return 0;
+}
+
+bool Filter::use_tables(const void* data, unsigned int size)
+{
+  return false;
+}
+
+
 // ----------------------------------------------------------------------------
 // Enable filter.
 // ----------------------------------------------------------------------------
@@ -548,6 +548,12 @@ public:
   // SID audio output (16 bits).
   short output();
 
+  // Interface for storing the model tables (see filter.cc); not supported
+  // by this filter, the tables are always calculated.
+  static unsigned int tables_size();
+  static const void* tables_data();
+  static bool use_tables(const void* data, unsigned int size);
+
 protected:
   void set_sum_mix();
   void set_w0();
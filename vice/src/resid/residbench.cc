@@ -0,0 +1,159 @@
+//  ---------------------------------------------------------------------------
+//  This file is part of reSID, a MOS6581 SID emulator engine.
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//  ---------------------------------------------------------------------------
+
+// Run by `make check'.  Clocks one SID for a few emulated seconds with each
+// chip model and sampling method, playing three filtered voices, and
+// prints the cycles per second per SID.  Where the AVX2 convolution is
+// picked at runtime, the resampling methods are also run with the SSE2
+// one, and the test fails if the samples differ.  The convolution is
+// static, so sid.cc is included here.
+
+#include "sid.cc"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+using namespace reSID;
+
+// Emulated seconds per run.
+static const int residbench_seconds = 2;
+
+static const double residbench_clock = 985248.0;
+static const double residbench_rate = 44100.0;
+
+// Like VICE, which always sets it (`SidResidFilterBias').
+static const double residbench_filter_bias = 0.5;
+
+// Samples of the last run.
+static short residbench_buf[44100 + 1024];
+
+static void residbench_play(SID& sid, int second)
+{
+  // Three voices with different waveforms, all through the low pass
+  // filter, the cutoff changing every second.
+  static const reg8 regs[][2] = {
+    { 0x00, 0x00 }, { 0x01, 0x11 }, { 0x05, 0x09 }, { 0x06, 0xf0 },
+    { 0x07, 0x00 }, { 0x08, 0x22 }, { 0x0c, 0x09 }, { 0x0d, 0xf0 },
+    { 0x0e, 0x00 }, { 0x0f, 0x33 }, { 0x10, 0x00 }, { 0x11, 0x08 },
+    { 0x13, 0x09 }, { 0x14, 0xf0 }, { 0x17, 0xf7 }, { 0x18, 0x1f },
+    { 0x04, 0x21 }, { 0x0b, 0x41 }, { 0x12, 0x11 }
+  };
+
+  if (second == 0) {
+    for (unsigned int i = 0; i < sizeof(regs) / sizeof(regs[0]); i++) {
+      sid.write(regs[i][0], regs[i][1]);
+    }
+  }
+  sid.write(0x16, (reg8)(0x20 + second * 0x30));
+}
+
+// Run `sid' for residbench_seconds, return the host seconds it took and
+// the number of samples in residbench_buf.
+static double residbench_run(SID& sid, int& samples)
+{
+  clock_t start = clock();
+
+  for (int second = 0; second < residbench_seconds; second++) {
+    cycle_count delta_t = (cycle_count)residbench_clock;
+
+    // only the samples of the last second are kept
+    residbench_play(sid, second);
+    samples = 0;
+    while (delta_t > 0) {
+      samples += sid.clock(delta_t, residbench_buf + samples,
+                           (int)(sizeof(residbench_buf) / sizeof(short)) - samples);
+    }
+  }
+
+  return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+int main()
+{
+  static const struct {
+    sampling_method method;
+    const char* name;
+  } methods[] = {
+    { SAMPLE_FAST, "fast" },
+    { SAMPLE_INTERPOLATE, "interpolate" },
+    { SAMPLE_RESAMPLE, "resample" },
+    { SAMPLE_RESAMPLE_FASTMEM, "resample fastmem" }
+  };
+  static const struct {
+    chip_model model;
+    const char* name;
+  } models[] = {
+    { MOS6581, "6581" },
+    { MOS8580, "8580" }
+  };
+  int failed = 0;
+
+  for (unsigned int m = 0; m < sizeof(models) / sizeof(models[0]); m++) {
+    for (unsigned int i = 0; i < sizeof(methods) / sizeof(methods[0]); i++) {
+      SID sid;
+      int samples;
+
+      sid.set_chip_model(models[m].model);
+      sid.reset();
+      sid.adjust_filter_bias(residbench_filter_bias);
+      sid.set_sampling_parameters(residbench_clock, methods[i].method,
+                                  residbench_rate);
+      double seconds = residbench_run(sid, samples);
+
+      printf("%s %-16s %12.0f cycles/s per SID (%.1f times real time)\n",
+             models[m].name, methods[i].name,
+             seconds > 0 ? residbench_clock * residbench_seconds / seconds : 0,
+             seconds > 0 ? residbench_seconds / seconds : 0);
+
+#if RESID_AVX2_DISPATCH
+      if (convolve != convolve_sse2
+          && (methods[i].method == SAMPLE_RESAMPLE
+              || methods[i].method == SAMPLE_RESAMPLE_FASTMEM)) {
+        static short avx2_buf[sizeof(residbench_buf) / sizeof(short)];
+        SID sid_sse2;
+        int samples_sse2;
+
+        memcpy(avx2_buf, residbench_buf, samples * sizeof(short));
+
+        convolve = convolve_sse2;
+        sid_sse2.set_chip_model(models[m].model);
+        sid_sse2.reset();
+        sid_sse2.adjust_filter_bias(residbench_filter_bias);
+        sid_sse2.set_sampling_parameters(residbench_clock, methods[i].method,
+                                         residbench_rate);
+        seconds = residbench_run(sid_sse2, samples_sse2);
+        convolve = convolve_avx2;
+
+        printf("%s %-16s %12.0f cycles/s per SID with SSE2",
+               models[m].name, methods[i].name,
+               seconds > 0 ? residbench_clock * residbench_seconds / seconds : 0);
+        if (samples != samples_sse2
+            || memcmp(avx2_buf, residbench_buf, samples * sizeof(short)) != 0) {
+          printf(", samples differ from AVX2\n");
+          failed = 1;
+        } else {
+          printf(", same samples as AVX2\n");
+        }
+      }
+#endif
+    }
+  }
+
+  return failed;
+}
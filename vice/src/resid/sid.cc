@@ -31,14 +31,108 @@
 #define round(x) (x>=0.0?floor(x+0.5):ceil(x-0.5))
 #endif
 
+// SIMD convolution.  SSE2 is selected by the compiler's target flags; the
+// AVX2 version is either selected by them too, or picked at runtime on x86
+// CPUs that have it.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RESID_USE_SSE2 1
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#define RESID_USE_AVX2 1
+#define RESID_AVX2_TARGET
+#include <immintrin.h>
+#elif RESID_USE_SSE2 && defined(__GNUC__) \
+  && (defined(__i386__) || defined(__x86_64__)) \
+  && (__GNUC__ >= 5 || defined(__clang__))
+#define RESID_USE_AVX2 1
+#define RESID_AVX2_DISPATCH 1
+#define RESID_AVX2_TARGET __attribute__((target("avx2")))
+#include <immintrin.h>
+#endif
+
 namespace reSID
 {
 
+// ----------------------------------------------------------------------------
+// Convolution of n samples with a filter impulse response.
+// Only integer arithmetic is involved, so the SIMD versions yield exactly
+// the same sum as the plain loop.
+// ----------------------------------------------------------------------------
+static RESID_INLINE int convolve_sse2(const short* a, const short* b, int n)
+{
+  int out = 0;
+
+#if RESID_USE_SSE2
+  __m128i acc = _mm_setzero_si128();
+  for (; n >= 8; n -= 8, a += 8, b += 8) {
+    acc = _mm_add_epi32(acc,
+      _mm_madd_epi16(_mm_loadu_si128((const __m128i*)a),
+                     _mm_loadu_si128((const __m128i*)b)));
+  }
+  acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+  acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2, 3, 0, 1)));
+  out = _mm_cvtsi128_si32(acc);
+#endif
+
+  for (; n > 0; n--) {
+    out += *a++ * *b++;
+  }
+
+  return out;
+}
+
+#if RESID_USE_AVX2
+RESID_AVX2_TARGET
+static int convolve_avx2(const short* a, const short* b, int n)
+{
+  __m256i acc256 = _mm256_setzero_si256();
+  for (; n >= 16; n -= 16, a += 16, b += 16) {
+    acc256 = _mm256_add_epi32(acc256,
+      _mm256_madd_epi16(_mm256_loadu_si256((const __m256i*)a),
+                        _mm256_loadu_si256((const __m256i*)b)));
+  }
+  __m128i acc = _mm_add_epi32(_mm256_castsi256_si128(acc256),
+                              _mm256_extracti128_si256(acc256, 1));
+  acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+  acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2, 3, 0, 1)));
+
+  // The rest is done 8 and 1 at a time.
+  return _mm_cvtsi128_si32(acc) + convolve_sse2(a, b, n);
+}
+#endif
+
+#if RESID_AVX2_DISPATCH
+// Picked in the constructor of the first SID.
+static int (*convolve)(const short* a, const short* b, int n) = convolve_sse2;
+
+static void convolve_init()
+{
+  static bool done = false;
+
+  if (!done) {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+      convolve = convolve_avx2;
+    }
+    done = true;
+  }
+}
+#elif RESID_USE_AVX2
+#define convolve convolve_avx2
+static void convolve_init() {}
+#else
+#define convolve convolve_sse2
+static void convolve_init() {}
+#endif
+
 // ----------------------------------------------------------------------------
 // Constructor.
 // ----------------------------------------------------------------------------
 SID::SID()
 {
+  convolve_init();
+
   // Initialize pointers.
   sample = 0;
   fir = 0;
@@ -668,8 +762,6 @@ void SID::adjust_sampling_frequency(double sample_freq)
 // ----------------------------------------------------------------------------
 void SID::clock(cycle_count delta_t)
 {
-  int i;
-
   // Pipelined writes on the MOS8580.
   if (unlikely(write_pipeline) && likely(delta_t > 0)) {
     // Step one cycle by a recursive call to ourselves.
@@ -683,6 +775,78 @@ void SID::clock(cycle_count delta_t)
     return;
   }
 
+  clock_voices(delta_t);
+
+  // Clock filter.
+  filter.clock(delta_t, voice[0].output(), voice[1].output(), voice[2].output());
+
+  // Clock external filter.
+  extfilt.clock(delta_t, filter.output());
+}
+
+
+// ----------------------------------------------------------------------------
+// SID clocking without the filter and the external filter, for when the
+// output is not used - delta_t cycles.
+// The oscillators and envelopes, and so the OSC3 and ENV3 registers, are
+// clocked the same way as by the current sampling method, i.e. cycle by
+// cycle except for SAMPLE_FAST. The filters keep their state until they
+// are clocked again.
+// ----------------------------------------------------------------------------
+void SID::clock_silent(cycle_count delta_t)
+{
+  int i;
+
+  if (sampling == SAMPLE_FAST) {
+    // Pipelined writes on the MOS8580.
+    if (unlikely(write_pipeline) && likely(delta_t > 0)) {
+      write_pipeline = 0;
+      clock_silent(1);
+      write();
+      delta_t -= 1;
+    }
+
+    if (likely(delta_t > 0)) {
+      clock_voices(delta_t);
+    }
+    return;
+  }
+
+  for (; delta_t > 0; delta_t--) {
+    for (i = 0; i < 3; i++) {
+      voice[i].envelope.clock();
+    }
+
+    for (i = 0; i < 3; i++) {
+      voice[i].wave.clock();
+    }
+
+    for (i = 0; i < 3; i++) {
+      voice[i].wave.synchronize();
+    }
+
+    for (i = 0; i < 3; i++) {
+      voice[i].wave.set_waveform_output();
+    }
+
+    if (unlikely(write_pipeline)) {
+      write();
+    }
+
+    if (unlikely(!--bus_value_ttl)) {
+      bus_value = 0;
+    }
+  }
+}
+
+
+// ----------------------------------------------------------------------------
+// Clock the envelopes and oscillators - delta_t cycles.
+// ----------------------------------------------------------------------------
+void SID::clock_voices(cycle_count delta_t)
+{
+  int i;
+
   // Age bus value.
   bus_value_ttl -= delta_t;
   if (unlikely(bus_value_ttl <= 0)) {
@@ -747,12 +911,6 @@ void SID::clock(cycle_count delta_t)
   for (i = 0; i < 3; i++) {
     voice[i].wave.set_waveform_output(delta_t);
   }
-
-  // Clock filter.
-  filter.clock(delta_t, voice[0].output(), voice[1].output(), voice[2].output());
-
-  // Clock external filter.
-  extfilt.clock(delta_t, filter.output());
 }
 
 
@@ -860,6 +1018,61 @@ int SID::clock_interpolate(cycle_count& delta_t, short* buf, int n, int interlea
 }
 
 
+// ----------------------------------------------------------------------------
+// Clock the chip for up to n output samples, storing every cycle's output
+// in the sample ring buffer. The ring index and the fractional sample
+// offset at the end of each sample are returned in index[] and offset[],
+// so the filter convolutions for the whole block can be done afterwards
+// in one tight loop.
+//
+// The block is cut short if clocking on would overwrite ring samples still
+// needed for the convolution of its first sample, or when delta_t runs out.
+// In the latter case delta_t is 0 on return, and the partial sample is
+// accounted for in sample_offset exactly as when clocking sample by sample.
+// ----------------------------------------------------------------------------
+int SID::clock_ring(cycle_count& delta_t, int* index, cycle_count* offset, int n)
+{
+  // Each convolution reads the fir_N + 1 most recent samples.
+  cycle_count block_cycles_max = RINGSIZE - fir_N - 2;
+  cycle_count block_cycles = 0;
+  int s;
+
+  for (s = 0; s < n; s++) {
+    cycle_count next_sample_offset = sample_offset + cycles_per_sample;
+    cycle_count delta_t_sample = next_sample_offset >> FIXP_SHIFT;
+
+    if (s > 0) {
+      if (block_cycles + delta_t_sample > block_cycles_max) {
+        break;
+      }
+      block_cycles += delta_t_sample;
+    }
+
+    if (delta_t_sample > delta_t) {
+      delta_t_sample = delta_t;
+    }
+
+    for (int i = 0; i < delta_t_sample; i++) {
+      clock();
+      sample[sample_index] = sample[sample_index + RINGSIZE] = output();
+      ++sample_index &= RINGMASK;
+    }
+
+    if ((delta_t -= delta_t_sample) == 0) {
+      sample_offset -= delta_t_sample << FIXP_SHIFT;
+      break;
+    }
+
+    sample_offset = next_sample_offset & FIXP_MASK;
+
+    index[s] = sample_index;
+    offset[s] = sample_offset;
+  }
+
+  return s;
+}
+
+
 // ----------------------------------------------------------------------------
 // SID clocking with audio sampling - cycle based with audio resampling.
 //
@@ -898,71 +1111,56 @@ int SID::clock_interpolate(cycle_count& delta_t, short* buf, int n, int interlea
 // ----------------------------------------------------------------------------
 int SID::clock_resample(cycle_count& delta_t, short* buf, int n, int interleave)
 {
-  int s;
-
-  for (s = 0; s < n; s++) {
-    cycle_count next_sample_offset = sample_offset + cycles_per_sample;
-    cycle_count delta_t_sample = next_sample_offset >> FIXP_SHIFT;
-
-    if (delta_t_sample > delta_t) {
-      delta_t_sample = delta_t;
-    }
-
-    for (int i = 0; i < delta_t_sample; i++) {
-      clock();
-      sample[sample_index] = sample[sample_index + RINGSIZE] = output();
-      ++sample_index &= RINGMASK;
-    }
-
-    if ((delta_t -= delta_t_sample) == 0) {
-      sample_offset -= delta_t_sample << FIXP_SHIFT;
-      break;
-    }
+  int index[RESAMPLE_BLOCK];
+  cycle_count offset[RESAMPLE_BLOCK];
+  int s = 0;
+
+  while (s < n) {
+    int m = clock_ring(delta_t, index, offset,
+                       n - s < RESAMPLE_BLOCK ? n - s : RESAMPLE_BLOCK);
+
+    for (int b = 0; b < m; b++, s++) {
+      int fir_offset = offset[b]*fir_RES >> FIXP_SHIFT;
+      int fir_offset_rmd = offset[b]*fir_RES & FIXP_MASK;
+      short* fir_start = fir + fir_offset*fir_N;
+      short* sample_start = sample + index[b] - fir_N - 1 + RINGSIZE;
+
+      // Convolution with filter impulse response.
+      int v1 = convolve(sample_start, fir_start, fir_N);
+
+      // Use next FIR table, wrap around to first FIR table using
+      // next sample.
+      if (unlikely(++fir_offset == fir_RES)) {
+        fir_offset = 0;
+        ++sample_start;
+      }
+      fir_start = fir + fir_offset*fir_N;
 
-    sample_offset = next_sample_offset & FIXP_MASK;
+      // Convolution with filter impulse response.
+      int v2 = convolve(sample_start, fir_start, fir_N);
 
-    int fir_offset = sample_offset*fir_RES >> FIXP_SHIFT;
-    int fir_offset_rmd = sample_offset*fir_RES & FIXP_MASK;
-    short* fir_start = fir + fir_offset*fir_N;
-    short* sample_start = sample + sample_index - fir_N - 1 + RINGSIZE;
+      // Linear interpolation.
+      // fir_offset_rmd is equal for all samples, it can thus be factorized out:
+      // sum(v1 + rmd*(v2 - v1)) = sum(v1) + rmd*(sum(v2) - sum(v1))
+      int v = v1 + int((unsigned(fir_offset_rmd)*unsigned(v2 - v1)) >> FIXP_SHIFT);
 
-    // Convolution with filter impulse response.
-    int v1 = 0;
-    for (int j = 0; j < fir_N; j++) {
-      v1 += sample_start[j]*fir_start[j];
-    }
+      v >>= FIR_SHIFT;
 
-    // Use next FIR table, wrap around to first FIR table using
-    // next sample.
-    if (unlikely(++fir_offset == fir_RES)) {
-      fir_offset = 0;
-      ++sample_start;
-    }
-    fir_start = fir + fir_offset*fir_N;
+      // Saturated arithmetics to guard against 16 bit sample overflow.
+      const int half = 1 << 15;
+      if (v >= half) {
+        v = half - 1;
+      }
+      else if (v < -half) {
+        v = -half;
+      }
 
-    // Convolution with filter impulse response.
-    int v2 = 0;
-    for (int k = 0; k < fir_N; k++) {
-      v2 += sample_start[k]*fir_start[k];
+      buf[s*interleave] = v;
     }
 
-    // Linear interpolation.
-    // fir_offset_rmd is equal for all samples, it can thus be factorized out:
-    // sum(v1 + rmd*(v2 - v1)) = sum(v1) + rmd*(sum(v2) - sum(v1))
-    int v = v1 + int((unsigned(fir_offset_rmd)*unsigned(v2 - v1)) >> FIXP_SHIFT);
-
-    v >>= FIR_SHIFT;
-
-    // Saturated arithmetics to guard against 16 bit sample overflow.
-    const int half = 1 << 15;
-    if (v >= half) {
-      v = half - 1;
-    }
-    else if (v < -half) {
-      v = -half;
+    if (delta_t == 0) {
+      break;
     }
-
-    buf[s*interleave] = v;
   }
 
   return s;
@@ -974,51 +1172,39 @@ int SID::clock_resample(cycle_count& delta_t, short* buf, int n, int interleave)
 // ----------------------------------------------------------------------------
 int SID::clock_resample_fastmem(cycle_count& delta_t, short* buf, int n, int interleave)
 {
-  int s;
+  int index[RESAMPLE_BLOCK];
+  cycle_count offset[RESAMPLE_BLOCK];
+  int s = 0;
 
-  for (s = 0; s < n; s++) {
-    cycle_count next_sample_offset = sample_offset + cycles_per_sample;
-    cycle_count delta_t_sample = next_sample_offset >> FIXP_SHIFT;
+  while (s < n) {
+    int m = clock_ring(delta_t, index, offset,
+                       n - s < RESAMPLE_BLOCK ? n - s : RESAMPLE_BLOCK);
 
-    if (delta_t_sample > delta_t) {
-      delta_t_sample = delta_t;
-    }
+    for (int b = 0; b < m; b++, s++) {
+      int fir_offset = offset[b]*fir_RES >> FIXP_SHIFT;
+      short* fir_start = fir + fir_offset*fir_N;
+      short* sample_start = sample + index[b] - fir_N + RINGSIZE;
 
-    for (int i = 0; i < delta_t_sample; i++) {
-      clock();
-      sample[sample_index] = sample[sample_index + RINGSIZE] = output();
-      ++sample_index &= RINGMASK;
-    }
+      // Convolution with filter impulse response.
+      int v = convolve(sample_start, fir_start, fir_N);
 
-    if ((delta_t -= delta_t_sample) == 0) {
-      sample_offset -= delta_t_sample << FIXP_SHIFT;
-      break;
-    }
+      v >>= FIR_SHIFT;
 
-    sample_offset = next_sample_offset & FIXP_MASK;
-
-    int fir_offset = sample_offset*fir_RES >> FIXP_SHIFT;
-    short* fir_start = fir + fir_offset*fir_N;
-    short* sample_start = sample + sample_index - fir_N + RINGSIZE;
+      // Saturated arithmetics to guard against 16 bit sample overflow.
+      const int half = 1 << 15;
+      if (v >= half) {
+        v = half - 1;
+      }
+      else if (v < -half) {
+        v = -half;
+      }
 
-    // Convolution with filter impulse response.
-    int v = 0;
-    for (int j = 0; j < fir_N; j++) {
-      v += sample_start[j]*fir_start[j];
+      buf[s*interleave] = v;
     }
 
-    v >>= FIR_SHIFT;
-
-    // Saturated arithmetics to guard against 16 bit sample overflow.
-    const int half = 1 << 15;
-    if (v >= half) {
-      v = half - 1;
-    }
-    else if (v < -half) {
-      v = -half;
+    if (delta_t == 0) {
+      break;
     }
-
-    buf[s*interleave] = v;
   }
 
   return s;
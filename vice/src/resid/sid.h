@@ -53,6 +53,7 @@ public:
 
   void clock();
   void clock(cycle_count delta_t);
+  void clock_silent(cycle_count delta_t);
   int clock(cycle_count& delta_t, short* buf, int n, int interleave = 1);
   void reset();
 
@@ -102,10 +103,12 @@ public:
 
  protected:
   static double I0(double x);
+  void clock_voices(cycle_count delta_t);
   int clock_fast(cycle_count& delta_t, short* buf, int n, int interleave);
   int clock_interpolate(cycle_count& delta_t, short* buf, int n, int interleave);
   int clock_resample(cycle_count& delta_t, short* buf, int n, int interleave);
   int clock_resample_fastmem(cycle_count& delta_t, short* buf, int n, int interleave);
+  int clock_ring(cycle_count& delta_t, int* index, cycle_count* offset, int n);
   void write();
 
   chip_model sid_model;
@@ -143,6 +146,10 @@ public:
     RINGSIZE = 1 << 14,
     RINGMASK = RINGSIZE - 1,
 
+    // Maximum number of output samples clocked into the ring buffer
+    // before their convolutions are done.
+    RESAMPLE_BLOCK = 256,
+
     // Fixed point constants (16.16 bits).
     FIXP_SHIFT = 16,
     FIXP_MASK = 0xffff
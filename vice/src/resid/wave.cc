@@ -21,6 +21,7 @@
 
 #include "wave.h"
 #include "dac.h"
+#include <string.h>
 
 namespace reSID
 {
@@ -42,7 +43,7 @@ const cycle_count FLOATING_OUTPUT_TTL_6581 = 200000;  // ~200ms
 const cycle_count FLOATING_OUTPUT_TTL_8580 = 5000000; // ~5s
 
 // Waveform lookup tables.
-unsigned short WaveformGenerator::model_wave[2][8][1 << 12] = {
+unsigned short WaveformGenerator::model_wave_data[2][8][1 << 12] = {
   {
     {0},
     {0},
@@ -67,42 +68,27 @@ unsigned short WaveformGenerator::model_wave[2][8][1 << 12] = {
 
 
 // DAC lookup tables.
-unsigned short WaveformGenerator::model_dac[2][1 << 12] = {
+unsigned short WaveformGenerator::model_dac_data[2][1 << 12] = {
   {0},
   {0},
 };
 
+// The tables in use, either the ones above or ones passed to use_tables().
+const unsigned short (*WaveformGenerator::model_wave)[8][1 << 12];
+const unsigned short (*WaveformGenerator::model_dac)[1 << 12];
+
+// "rSWT" and the version of the table layout and calculation.
+#define WAVE_TABLES_MAGIC 0x72535754
+#define WAVE_TABLES_VERSION 1
+
 
 // ----------------------------------------------------------------------------
 // Constructor.
 // ----------------------------------------------------------------------------
 WaveformGenerator::WaveformGenerator()
 {
-  static bool class_init;
-
-  if (!class_init) {
-    // Calculate tables for normal waveforms.
-    accumulator = 0;
-    for (int i = 0; i < (1 << 12); i++) {
-      reg24 msb = accumulator & 0x800000;
-
-      // Noise mask, triangle, sawtooth, pulse mask.
-      // The triangle calculation is made branch-free, just for the hell of it.
-      model_wave[0][0][i] = model_wave[1][0][i] = 0xfff;
-      model_wave[0][1][i] = model_wave[1][1][i] = ((accumulator ^ -!!msb) >> 11) & 0xffe;
-      model_wave[0][2][i] = model_wave[1][2][i] = accumulator >> 12;
-      model_wave[0][4][i] = model_wave[1][4][i] = 0xfff;
-
-      accumulator += 0x1000;
-    }
-
-    // Build DAC lookup tables for 12-bit DACs.
-    // MOS 6581: 2R/R ~ 2.20, missing termination resistor.
-    build_dac_table(model_dac[0], 12, 2.20, false);
-    // MOS 8580: 2R/R ~ 2.00, correct termination.
-    build_dac_table(model_dac[1], 12, 2.00, true);
-
-    class_init = true;
+  if (!model_wave) {
+    build_tables();
   }
 
   sync_source = this;
@@ -118,6 +104,104 @@ WaveformGenerator::WaveformGenerator()
 }
 
 
+// ----------------------------------------------------------------------------
+// Model tables.
+// Like the filter tables (see filter.cc), these can be stored by one process
+// and passed to use_tables() by later ones before the first
+// WaveformGenerator is constructed, so that every process maps the same
+// read-only pages instead of keeping its own copy.
+// ----------------------------------------------------------------------------
+unsigned int WaveformGenerator::tables_size()
+{
+  return sizeof(tables_t);
+}
+
+const void* WaveformGenerator::tables_data()
+{
+  static tables_t* tables;
+
+  if (!model_wave) {
+    build_tables();
+  }
+  if (!tables) {
+    tables = new tables_t;
+    tables->magic = WAVE_TABLES_MAGIC;
+    tables->version = WAVE_TABLES_VERSION;
+    tables->size = sizeof(tables_t);
+    tables->params = tables_params();
+    memcpy(tables->model_wave, model_wave, sizeof(tables->model_wave));
+    memcpy(tables->model_dac, model_dac, sizeof(tables->model_dac));
+  }
+  return tables;
+}
+
+bool WaveformGenerator::use_tables(const void* data, unsigned int size)
+{
+  const tables_t* t = (const tables_t*)data;
+
+  if (model_wave || size != sizeof(tables_t)
+      || t->magic != WAVE_TABLES_MAGIC
+      || t->version != WAVE_TABLES_VERSION
+      || t->size != sizeof(tables_t)
+      || t->params != tables_params())
+  {
+    return false;
+  }
+
+  model_wave = t->model_wave;
+  model_dac = t->model_dac;
+
+  return true;
+}
+
+// Hash of the sampled combined waveforms.
+unsigned int WaveformGenerator::tables_params()
+{
+  unsigned int hash = 2166136261u;
+
+  for (int m = 0; m < 2; m++) {
+    for (int w = 3; w < 8; w++) {
+      if (w == 4) {
+        continue;
+      }
+      const unsigned char* p = (const unsigned char*)model_wave_data[m][w];
+      for (unsigned int i = 0; i < sizeof(model_wave_data[m][w]); i++) {
+        hash = (hash ^ p[i])*16777619u;
+      }
+    }
+  }
+
+  return hash;
+}
+
+void WaveformGenerator::build_tables()
+{
+  // Calculate tables for normal waveforms.
+  reg24 accumulator = 0;
+  for (int i = 0; i < (1 << 12); i++) {
+    reg24 msb = accumulator & 0x800000;
+
+    // Noise mask, triangle, sawtooth, pulse mask.
+    // The triangle calculation is made branch-free, just for the hell of it.
+    model_wave_data[0][0][i] = model_wave_data[1][0][i] = 0xfff;
+    model_wave_data[0][1][i] = model_wave_data[1][1][i] = ((accumulator ^ -!!msb) >> 11) & 0xffe;
+    model_wave_data[0][2][i] = model_wave_data[1][2][i] = accumulator >> 12;
+    model_wave_data[0][4][i] = model_wave_data[1][4][i] = 0xfff;
+
+    accumulator += 0x1000;
+  }
+
+  // Build DAC lookup tables for 12-bit DACs.
+  // MOS 6581: 2R/R ~ 2.20, missing termination resistor.
+  build_dac_table(model_dac_data[0], 12, 2.20, false);
+  // MOS 8580: 2R/R ~ 2.00, correct termination.
+  build_dac_table(model_dac_data[1], 12, 2.00, true);
+
+  model_wave = model_wave_data;
+  model_dac = model_dac_data;
+}
+
+
 // ----------------------------------------------------------------------------
 // Set sync source.
 // ----------------------------------------------------------------------------
@@ -60,6 +60,12 @@ public:
   void set_waveform_output();
   void set_waveform_output(cycle_count delta_t);
 
+  // The waveform and DAC tables as one block of memory, which can be stored
+  // and used by later processes (see Filter::tables_size()).
+  static unsigned int tables_size();
+  static const void* tables_data();
+  static bool use_tables(const void* data, unsigned int size);
+
 protected:
   void clock_shift_register();
   void write_shift_register();
@@ -116,10 +122,29 @@ protected:
   chip_model sid_model;
 
   // Sample data for waveforms, not including noise.
-  unsigned short* wave;
-  static unsigned short model_wave[2][8][1 << 12];
+  const unsigned short* wave;
+  static const unsigned short (*model_wave)[8][1 << 12];
   // DAC lookup tables.
-  static unsigned short model_dac[2][1 << 12];
+  static const unsigned short (*model_dac)[1 << 12];
+
+  typedef struct {
+    // Identifies the layout and the combined waveforms the tables were
+    // calculated with.
+    unsigned int magic;
+    unsigned int version;
+    unsigned int size;
+    unsigned int params;
+
+    unsigned short model_wave[2][8][1 << 12];
+    unsigned short model_dac[2][1 << 12];
+  } tables_t;
+
+  static void build_tables();
+  static unsigned int tables_params();
+
+  // Tables calculated by this process.
+  static unsigned short model_wave_data[2][8][1 << 12];
+  static unsigned short model_dac_data[2][1 << 12];
 
 friend class Voice;
 friend class SID;
@@ -0,0 +1,463 @@
+/*
+ * rewind.c - Keep the recent machine state in memory to go back to.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/* Every `RewindInterval' frames a snapshot of the machine (without ROMs
+   and disk images) is written to memory.  Only the newest one is kept as
+   it is; each older one is stored as the difference to the one after it:
+   the two snapshots are XORed, which leaves mostly zeros as little of the
+   RAM and chip state changes within a few frames, and the result is stored
+   as runs of zeros and literal bytes.  Going back one point therefore only
+   takes one pass over a snapshot, and the oldest point can be dropped
+   without touching the others.  */
+
+#include "vice.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "cmdline.h"
+#include "interrupt.h"
+#include "lib.h"
+#include "log.h"
+#include "machine.h"
+#include "resources.h"
+#include "rewind.h"
+#include "snapshot.h"
+#include "translate.h"
+#include "types.h"
+#include "vsync.h"
+
+/* Runs of zeros shorter than this are kept in a literal run.  */
+#define REWIND_MIN_RUN  8
+
+typedef struct rewind_point_s {
+    /* Difference to the next newer snapshot, see rewind_encode().  */
+    uint8_t *data;
+    size_t size;
+
+    /* Size of the snapshot itself.  */
+    size_t snapshot_size;
+} rewind_point_t;
+
+static int rewind_enabled;
+static int rewind_seconds;
+static int rewind_interval;
+
+/* Older points in a ring of `points_max' entries, oldest first.  */
+static rewind_point_t *points = NULL;
+static int points_max = 0;
+static int points_first = 0;
+static int points_num = 0;
+
+/* Newest point, `size' is 0 if there is none yet.  */
+static snapshot_memory_t newest = { NULL, 0, 0, 0 };
+
+/* Buffers for snapshots being written or decoded.  */
+static snapshot_memory_t work = { NULL, 0, 0, 0 };
+static snapshot_memory_t spare = { NULL, 0, 0, 0 };
+
+static uint8_t *encode_buffer = NULL;
+static size_t encode_alloc = 0;
+
+/* Frames since the last point was taken.  */
+static int frames = 0;
+static int trap_pending = 0;
+
+static log_t rewind_log = LOG_ERR;
+
+/* ------------------------------------------------------------------------- */
+
+static void rewind_reserve(snapshot_memory_t *mem, size_t size)
+{
+    if (mem->alloc < size) {
+        mem->data = lib_realloc(mem->data, size);
+        mem->alloc = size;
+    }
+}
+
+static void rewind_swap(snapshot_memory_t *a, snapshot_memory_t *b)
+{
+    snapshot_memory_t tmp = *a;
+
+    *a = *b;
+    *b = tmp;
+}
+
+static uint8_t *rewind_put_count(uint8_t *p, size_t n)
+{
+    while (n >= 0x80) {
+        *p++ = (uint8_t)(n | 0x80);
+        n >>= 7;
+    }
+    *p++ = (uint8_t)n;
+
+    return p;
+}
+
+static const uint8_t *rewind_get_count(const uint8_t *p, const uint8_t *end,
+                                       size_t *n)
+{
+    unsigned int shift = 0;
+
+    *n = 0;
+    while (p < end && shift < sizeof(size_t) * 8) {
+        *n |= (size_t)(*p & 0x7f) << shift;
+        if (!(*p++ & 0x80)) {
+            return p;
+        }
+        shift += 7;
+    }
+
+    return NULL;
+}
+
+/* Byte `i' of `mem', with the snapshot padded with zeros.  */
+#define REWIND_BYTE(mem, i) ((i) < (mem)->size ? (mem)->data[(i)] : 0)
+
+/* Encode `old' as the difference to `new' into `encode_buffer'.  The result
+   is a sequence of (number of zeros, number of literal bytes, literal
+   bytes), the bytes being `old' XOR `new'.  Return its size.  */
+static size_t rewind_encode(const snapshot_memory_t *old,
+                            const snapshot_memory_t *new)
+{
+    size_t i = 0, j, k, run;
+    uint8_t *p;
+
+    /* Every run of zeros but the first saves more than the two counts
+       cost, so this is enough.  */
+    if (encode_alloc < old->size + 32) {
+        encode_alloc = old->size + 32;
+        encode_buffer = lib_realloc(encode_buffer, encode_alloc);
+    }
+    p = encode_buffer;
+
+    while (i < old->size) {
+        for (j = i; j < old->size && old->data[j] == REWIND_BYTE(new, j); j++) {
+        }
+        for (k = j; k < old->size; k += run) {
+            if (old->data[k] != REWIND_BYTE(new, k)) {
+                run = 1;
+                continue;
+            }
+            for (run = 0; k + run < old->size
+                 && old->data[k + run] == REWIND_BYTE(new, k + run); run++) {
+            }
+            if (run >= REWIND_MIN_RUN || k + run == old->size) {
+                break;
+            }
+        }
+
+        p = rewind_put_count(p, j - i);
+        p = rewind_put_count(p, k - j);
+        for (; j < k; j++) {
+            *p++ = old->data[j] ^ REWIND_BYTE(new, j);
+        }
+        i = k;
+    }
+
+    return (size_t)(p - encode_buffer);
+}
+
+/* Decode `point' against the newer snapshot `new' into `out'.  */
+static int rewind_decode(const rewind_point_t *point,
+                         const snapshot_memory_t *new, snapshot_memory_t *out)
+{
+    const uint8_t *p = point->data, *end = point->data + point->size;
+    size_t i = 0, n, same;
+
+    rewind_reserve(out, point->snapshot_size);
+    out->size = point->snapshot_size;
+
+    while (p < end) {
+        p = rewind_get_count(p, end, &n);
+        if (p == NULL || n > out->size - i) {
+            return -1;
+        }
+        if (i < new->size) {
+            same = (n < new->size - i) ? n : new->size - i;
+            memcpy(out->data + i, new->data + i, same);
+            memset(out->data + i + same, 0, n - same);
+        } else {
+            memset(out->data + i, 0, n);
+        }
+        i += n;
+
+        p = rewind_get_count(p, end, &n);
+        if (p == NULL || n > out->size - i || n > (size_t)(end - p)) {
+            return -1;
+        }
+        for (; n > 0; n--, i++) {
+            out->data[i] = *p++ ^ REWIND_BYTE(new, i);
+        }
+    }
+
+    return (i == out->size) ? 0 : -1;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static void rewind_drop_newest(int count)
+{
+    int idx;
+
+    while (count-- > 0 && points_num > 0) {
+        idx = (points_first + points_num - 1) % points_max;
+        lib_free(points[idx].data);
+        points[idx].data = NULL;
+        points_num--;
+    }
+}
+
+static void rewind_free(void)
+{
+    rewind_drop_newest(points_num);
+    lib_free(points);
+    points = NULL;
+    points_max = 0;
+    points_first = 0;
+    newest.size = 0;
+    frames = 0;
+}
+
+static void rewind_add_point(void)
+{
+    double rate = vsync_get_refresh_frequency();
+    rewind_point_t *point;
+    size_t size;
+
+    if (points == NULL) {
+        /* The newest point is not in the ring.  */
+        points_max = (int)((double)rewind_seconds * rate / rewind_interval);
+        if (points_max < 1) {
+            points_max = 1;
+        }
+        points = lib_calloc((size_t)points_max, sizeof(rewind_point_t));
+        points_first = 0;
+        points_num = 0;
+    }
+
+    if (points_num == points_max) {
+        lib_free(points[points_first].data);
+        points[points_first].data = NULL;
+        points_first = (points_first + 1) % points_max;
+        points_num--;
+    }
+
+    size = rewind_encode(&newest, &work);
+
+    point = &points[(points_first + points_num) % points_max];
+    point->data = lib_malloc(size);
+    memcpy(point->data, encode_buffer, size);
+    point->size = size;
+    point->snapshot_size = newest.size;
+    points_num++;
+}
+
+static void rewind_take(void)
+{
+    int retval;
+
+    snapshot_set_memory(&work);
+    retval = machine_write_snapshot("", 0, 0, 0);
+    snapshot_set_memory(NULL);
+
+    if (retval < 0) {
+        log_error(rewind_log, "Cannot write snapshot, rewinding disabled.");
+        resources_set_int("RewindEnabled", 0);
+        return;
+    }
+
+    if (newest.size > 0) {
+        rewind_add_point();
+    }
+    rewind_swap(&newest, &work);
+}
+
+static void rewind_trap(uint16_t addr, void *data)
+{
+    trap_pending = 0;
+
+    if (rewind_enabled) {
+        rewind_take();
+    }
+}
+
+/* Called at the end of every frame.  */
+void rewind_vsync_hook(void)
+{
+    if (!rewind_enabled || trap_pending) {
+        return;
+    }
+
+    if (++frames >= rewind_interval) {
+        frames = 0;
+        trap_pending = 1;
+        interrupt_maincpu_trigger_trap(rewind_trap, NULL);
+    }
+}
+
+/* Number of points that can be gone back to.  */
+int rewind_points(void)
+{
+    return points_num + (newest.size > 0 ? 1 : 0);
+}
+
+/* Restore the `count'th newest point, 1 being the newest one, and forget
+   the newer ones.  Must be called while the CPU is stopped at an
+   instruction boundary, e.g. from a trap or the monitor.  */
+int rewind_restore(int count)
+{
+    int n, retval;
+
+    if (count < 1 || count > rewind_points()) {
+        return -1;
+    }
+
+    rewind_reserve(&work, newest.size);
+    memcpy(work.data, newest.data, newest.size);
+    work.size = newest.size;
+
+    for (n = 1; n < count; n++) {
+        if (rewind_decode(&points[(points_first + points_num - n) % points_max],
+                          &work, &spare) < 0) {
+            log_error(rewind_log, "Corrupt rewind point.");
+            return -1;
+        }
+        rewind_swap(&work, &spare);
+    }
+
+    snapshot_set_memory(&work);
+    retval = machine_read_snapshot("", 0);
+    snapshot_set_memory(NULL);
+
+    if (retval < 0) {
+        log_error(rewind_log, "Cannot read snapshot.");
+        return -1;
+    }
+
+    rewind_drop_newest(count - 1);
+    rewind_swap(&newest, &work);
+    frames = 0;
+
+    return 0;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static int set_rewind_enabled(int val, void *param)
+{
+    rewind_enabled = val ? 1 : 0;
+
+    if (rewind_log == LOG_ERR) {
+        rewind_log = log_open("Rewind");
+    }
+
+    if (!rewind_enabled) {
+        rewind_free();
+    }
+
+    return 0;
+}
+
+static int set_rewind_seconds(int val, void *param)
+{
+    if (val < 1) {
+        return -1;
+    }
+
+    if (val != rewind_seconds) {
+        rewind_seconds = val;
+        rewind_free();
+    }
+
+    return 0;
+}
+
+static int set_rewind_interval(int val, void *param)
+{
+    if (val < 1) {
+        return -1;
+    }
+
+    if (val != rewind_interval) {
+        rewind_interval = val;
+        rewind_free();
+    }
+
+    return 0;
+}
+
+static const resource_int_t resources_int[] = {
+    { "RewindEnabled", 0, RES_EVENT_NO, NULL,
+      &rewind_enabled, set_rewind_enabled, NULL },
+    { "RewindSeconds", 10, RES_EVENT_NO, NULL,
+      &rewind_seconds, set_rewind_seconds, NULL },
+    { "RewindInterval", 10, RES_EVENT_NO, NULL,
+      &rewind_interval, set_rewind_interval, NULL },
+    RESOURCE_INT_LIST_END
+};
+
+int rewind_resources_init(void)
+{
+    return resources_register_int(resources_int);
+}
+
+void rewind_shutdown(void)
+{
+    rewind_free();
+    lib_free(newest.data);
+    lib_free(work.data);
+    lib_free(spare.data);
+    lib_free(encode_buffer);
+    newest.data = work.data = spare.data = encode_buffer = NULL;
+    newest.alloc = work.alloc = spare.alloc = encode_alloc = 0;
+}
+
+static const cmdline_option_t cmdline_options[] = {
+    { "-rewind", SET_RESOURCE, 0,
+      NULL, NULL, "RewindEnabled", (resource_value_t)1,
+      USE_PARAM_STRING, USE_DESCRIPTION_STRING,
+      IDCLS_UNUSED, IDCLS_UNUSED,
+      NULL, "Keep the recent machine state in memory to rewind to" },
+    { "+rewind", SET_RESOURCE, 0,
+      NULL, NULL, "RewindEnabled", (resource_value_t)0,
+      USE_PARAM_STRING, USE_DESCRIPTION_STRING,
+      IDCLS_UNUSED, IDCLS_UNUSED,
+      NULL, "Do not keep the recent machine state in memory" },
+    { "-rewindseconds", SET_RESOURCE, 1,
+      NULL, NULL, "RewindSeconds", NULL,
+      USE_PARAM_STRING, USE_DESCRIPTION_STRING,
+      IDCLS_UNUSED, IDCLS_UNUSED,
+      "<seconds>", "Number of seconds that can be rewound" },
+    { "-rewindinterval", SET_RESOURCE, 1,
+      NULL, NULL, "RewindInterval", NULL,
+      USE_PARAM_STRING, USE_DESCRIPTION_STRING,
+      IDCLS_UNUSED, IDCLS_UNUSED,
+      "<frames>", "Number of frames between rewind points" },
+    CMDLINE_LIST_END
+};
+
+int rewind_cmdline_options_init(void)
+{
+    return cmdline_register_options(cmdline_options);
+}
@@ -78,6 +78,15 @@ int tap_seek_start(tap_t *tap)
     return 0;
 }
 
+long tap_read_data(tap_t *tap, long pos, uint8_t *buf, long len)
+{
+    return 0;
+}
+
+void tap_discard_buffer(tap_t *tap)
+{
+}
+
 int tape_image_create(const char *name, unsigned int type)
 {
     return 0;
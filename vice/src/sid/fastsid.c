@@ -1093,7 +1093,8 @@ sid_engine_t fastsid_hooks =
     fastsid_prevent_clk_overflow,
     fastsid_dump_state,
     fastsid_resid_state_read,
-    fastsid_resid_state_write
+    fastsid_resid_state_write,
+    NULL
 };
 
 /* ---------------------------------------------------------------------*/
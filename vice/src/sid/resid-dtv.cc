@@ -302,7 +302,8 @@ sid_engine_t resid_hooks =
     resid_prevent_clk_overflow,
     resid_dump_state,
     resid_state_read,
-    resid_state_write
+    resid_state_write,
+    NULL
 };
 
 } // extern "C"
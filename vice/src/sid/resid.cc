@@ -59,13 +59,26 @@ extern "C" {
 extern char *strcpy(char *s1, char *s2);
 #endif
 
+#include <stdio.h>
+
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
 #include "sid/sid.h" /* sid_engine_t */
+#include "archdep.h"
+#include "ioutil.h"
 #include "lib.h"
 #include "log.h"
 #include "resid.h"
 #include "resources.h"
 #include "sid-snapshot.h"
 #include "types.h"
+#include "util.h"
 
 } // extern "C"
 
@@ -104,11 +117,108 @@ static short *getbuf(int len)
     return buf;
 }
 
+/* Calculating the filter tables takes a noticeable part of the startup
+   time.  With `SidResidTableFile' set, they are mapped from that file
+   instead, together with the waveform and DAC tables, so that all
+   processes using the file share the same read-only pages.  If it does
+   not exist yet or was written by another version, the tables are
+   calculated and the file is (re)written for the next process.  The file
+   holds the waveform tables followed by the filter tables (if the filter
+   supports storing them).  */
+static void resid_tables_init(void)
+{
+    static int done = 0;
+    const char *filename;
+    char *tmpname;
+    unsigned int wave_size = WaveformGenerator::tables_size();
+    unsigned int filter_size = Filter::tables_size();
+    unsigned int size = wave_size + filter_size;
+    char *data = NULL;
+    FILE *fd;
+    int ok, wave_ok, filter_ok;
+
+    if (done) {
+        return;
+    }
+    done = 1;
+
+    if (resources_get_string("SidResidTableFile", &filename) < 0
+        || filename == NULL || *filename == '\0') {
+        return;
+    }
+
+    fd = fopen(filename, MODE_READ);
+    if (fd != NULL) {
+        if (util_file_length(fd) == size) {
+#ifdef HAVE_SYS_MMAN_H
+            data = (char *)mmap(NULL, size, PROT_READ, MAP_SHARED, fileno(fd), 0);
+            if (data == MAP_FAILED) {
+                data = NULL;
+            }
+#else
+            data = (char *)lib_malloc(size);
+            if (fread(data, 1, size, fd) != size) {
+                lib_free(data);
+                data = NULL;
+            }
+#endif
+        }
+        fclose(fd);
+
+        if (data != NULL) {
+            wave_ok = WaveformGenerator::use_tables(data, wave_size);
+            filter_ok = filter_size > 0
+                        && Filter::use_tables(data + wave_size, filter_size);
+            if (wave_ok && (filter_ok || filter_size == 0)) {
+                log_message(LOG_DEFAULT, "reSID: Using the tables in `%s'.", filename);
+                return;
+            }
+            /* Keep the data if one of the blocks is in use.  */
+            if (!wave_ok && !filter_ok) {
+#ifdef HAVE_SYS_MMAN_H
+                munmap(data, size);
+#else
+                lib_free(data);
+#endif
+            }
+        }
+    }
+
+    /* Write to a temporary file first, so that other processes never see
+       a partly written one.  */
+#ifdef HAVE_UNISTD_H
+    tmpname = lib_msprintf("%s.%lu.tmp", filename, (unsigned long)getpid());
+#else
+    tmpname = util_concat(filename, ".tmp", NULL);
+#endif
+    fd = fopen(tmpname, MODE_WRITE);
+    if (fd != NULL) {
+        ok = fwrite(WaveformGenerator::tables_data(), 1, wave_size, fd) == wave_size;
+        if (filter_size > 0) {
+            ok = fwrite(Filter::tables_data(), 1, filter_size, fd) == filter_size && ok;
+        }
+        if (fclose(fd) != 0) {
+            ok = 0;
+        }
+        if (ok && archdep_rename(tmpname, filename) == 0) {
+            log_message(LOG_DEFAULT, "reSID: Stored the tables in `%s'.", filename);
+        } else {
+            log_warning(LOG_DEFAULT, "reSID: Cannot store the tables in `%s'.", filename);
+            ioutil_remove(tmpname);
+        }
+    } else {
+        log_warning(LOG_DEFAULT, "reSID: Cannot store the tables in `%s'.", filename);
+    }
+    lib_free(tmpname);
+}
+
 static sound_t *resid_open(uint8_t *sidstate)
 {
     sound_t *psid;
     int i;
 
+    resid_tables_init();
+
     psid = new sound_t;
     psid->sid = new reSID::SID;
 
@@ -269,6 +379,11 @@ static int resid_calculate_samples(sound_t *psid, short *pbuf, int nr,
     return retval;
 }
 
+static void resid_clock_silent(sound_t *psid, int delta_t)
+{
+    psid->sid->clock_silent(delta_t);
+}
+
 static void resid_prevent_clk_overflow(sound_t *psid, CLOCK sub)
 {
 }
@@ -365,7 +480,8 @@ sid_engine_t resid_hooks =
     resid_prevent_clk_overflow,
     resid_dump_state,
     resid_state_read,
-    resid_state_write
+    resid_state_write,
+    resid_clock_silent
 };
 
 } // extern "C"
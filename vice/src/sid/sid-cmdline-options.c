@@ -174,6 +174,21 @@ static const cmdline_option_t resid_cmdline_options[] = {
       USE_PARAM_ID, USE_DESCRIPTION_ID,
       IDCLS_P_NUMBER, IDCLS_RESID_FILTER_BIAS,
       NULL, NULL, },
+    { "-residtablefile", SET_RESOURCE, 1,
+      NULL, NULL, "SidResidTableFile", NULL,
+      USE_PARAM_STRING, USE_DESCRIPTION_STRING,
+      IDCLS_UNUSED, IDCLS_UNUSED,
+      "<Name>", "Map the reSID tables from the given file, storing them there first if needed" },
+    { "-sidworkerthreads", SET_RESOURCE, 0,
+      NULL, NULL, "SidWorkerThreads", (void *)1,
+      USE_PARAM_STRING, USE_DESCRIPTION_STRING,
+      IDCLS_UNUSED, IDCLS_UNUSED,
+      NULL, "Calculate the samples of multiple SIDs on worker threads" },
+    { "+sidworkerthreads", SET_RESOURCE, 0,
+      NULL, NULL, "SidWorkerThreads", (void *)0,
+      USE_PARAM_STRING, USE_DESCRIPTION_STRING,
+      IDCLS_UNUSED, IDCLS_UNUSED,
+      NULL, "Calculate the samples of all SIDs on the main thread" },
     CMDLINE_LIST_END
 };
 #endif
@@ -33,6 +33,7 @@
 
 #include "catweaselmkiii.h"
 #include "hardsid.h"
+#include "lib.h"
 #include "log.h"
 #include "machine.h"
 #ifdef HAVE_PARSID
@@ -41,9 +42,11 @@
 #include "resources.h"
 #include "sid-resources.h"
 #include "sid.h"
+#include "sidthread.h"
 #include "ssi2001.h"
 #include "sound.h"
 #include "types.h"
+#include "util.h"
 
 /* Resource handling -- Added by Ettore 98-04-26.  */
 
@@ -59,6 +62,7 @@ static int sid_resid_sampling;
 static int sid_resid_passband;
 static int sid_resid_gain;
 static int sid_resid_filter_bias;
+static char *sid_resid_table_file = NULL;
 #endif
 int sid_stereo = 0;
 int checking_sid_stereo;
@@ -362,6 +366,19 @@ static int set_sid_resid_filter_bias(int i, void *param)
     return 0;
 }
 
+
+static int set_sid_resid_table_file(const char *val, void *param)
+{
+    util_string_set(&sid_resid_table_file, val);
+    return 0;
+}
+
+static int set_sid_worker_threads(int val, void *param)
+{
+    sidthread_enabled = val ? 1 : 0;
+
+    return 0;
+}
 #endif
 
 #ifdef HAVE_HARDSID
@@ -403,6 +420,14 @@ void sid_set_enable(int value)
 }
 #endif
 
+#ifdef HAVE_RESID
+static const resource_string_t resid_resources_string[] = {
+    { "SidResidTableFile", "", RES_EVENT_NO, NULL,
+      &sid_resid_table_file, set_sid_resid_table_file, NULL },
+    RESOURCE_STRING_LIST_END
+};
+#endif
+
 #if defined(HAVE_RESID) || defined(HAVE_RESID_DTV)
 static const resource_int_t resid_resources_int[] = {
     { "SidResidSampling", SID_RESID_SAMPLING_RESAMPLING, RES_EVENT_NO, NULL,
@@ -413,6 +438,8 @@ static const resource_int_t resid_resources_int[] = {
       &sid_resid_gain, set_sid_resid_gain, NULL },
     { "SidResidFilterBias", 500, RES_EVENT_NO, NULL,
       &sid_resid_filter_bias, set_sid_resid_filter_bias, NULL },
+    { "SidWorkerThreads", 0, RES_EVENT_NO, NULL,
+      &sidthread_enabled, set_sid_worker_threads, NULL },
     RESOURCE_INT_LIST_END
 };
 #endif
@@ -452,6 +479,11 @@ int sid_resources_init(void)
         return -1;
     }
 #endif
+#ifdef HAVE_RESID
+    if (resources_register_string(resid_resources_string) < 0) {
+        return -1;
+    }
+#endif
 
     if (resources_register_int(stereo_resources_int) < 0) {
         return -1;
@@ -460,6 +492,14 @@ int sid_resources_init(void)
     return sid_common_resources_init();
 }
 
+void sid_resources_shutdown(void)
+{
+#ifdef HAVE_RESID
+    lib_free(sid_resid_table_file);
+    sid_resid_table_file = NULL;
+#endif
+}
+
 /* ------------------------------------------------------------------------- */
 
 #ifdef SID_SETTINGS_DIALOG
@@ -45,6 +45,7 @@
 #include "sid-resources.h"
 #include "sid-snapshot.h"
 #include "sid.h"
+#include "sidthread.h"
 #include "sound.h"
 #include "ssi2001.h"
 #include "types.h"
@@ -574,18 +575,26 @@ static int16_t *getbuf7(int len)
     }
     return buf7;
 }
+
+/* Set when a SID cartridge runs the engine at a different speed; its
+   calculate_samples() then shares a temporary buffer.  */
+static int sid_vbr = 0;
+
 int sid_sound_machine_init_vbr(sound_t *psid, int speed, int cycles_per_sec, int factor)
 {
+    sid_vbr = (factor != 1000);
     return sid_engine.init(psid, speed * factor / 1000, cycles_per_sec, factor);
 }
 
 int sid_sound_machine_init(sound_t *psid, int speed, int cycles_per_sec)
 {
+    sid_vbr = 0;
     return sid_engine.init(psid, speed, cycles_per_sec, 1000);
 }
 
 void sid_sound_machine_close(sound_t *psid)
 {
+    sidthread_shutdown();
     sid_engine.close(psid);
     /* free the temp. buffers */
     if (buf1) {
@@ -630,9 +639,23 @@ void sid_sound_machine_store(sound_t *psid, uint16_t addr, uint8_t byte)
 
 void sid_sound_machine_reset(sound_t *psid, CLOCK cpu_clk)
 {
+    sidthread_discard(-1);
     sid_engine.reset(psid, cpu_clk);
 }
 
+static int sid_calculate_chip_samples(sound_t **psid, int chipno, int16_t *pbuf, int nr, int interleave, int *delta_t)
+{
+    int tmp_nr;
+
+    /* Samples may already have been calculated on a worker thread.  */
+    tmp_nr = sidthread_fetch(chipno, pbuf, interleave, delta_t);
+    if (tmp_nr >= 0) {
+        return tmp_nr;
+    }
+
+    return sid_engine.calculate_samples(psid[chipno], pbuf, nr, interleave, delta_t);
+}
+
 int sid_sound_machine_calculate_samples(sound_t **psid, int16_t *pbuf, int nr, int soc, int scc, int *delta_t)
 {
     int i;
@@ -646,13 +669,30 @@ int sid_sound_machine_calculate_samples(sound_t **psid, int16_t *pbuf, int nr, i
     int tmp_nr = 0;
     int tmp_delta_t = *delta_t;
 
+    /* Only the registers that can be read back have to be kept up to date
+       when the samples are thrown away anyway.  Other sound chips are
+       clocked by the number of samples returned here, so this is only
+       done when the SID is the only one.  */
+    if (sid_engine.clock_silent != NULL && sound_is_silent()
+        && !sidthread_pending() && sound_machine_chips_active() == 1) {
+        for (i = 0; i < scc; i++) {
+            sid_engine.clock_silent(psid[i], *delta_t);
+        }
+        *delta_t = 0;
+        return 0;
+    }
+
+    if (sid_sound_machine_cycle_based() && !sid_vbr) {
+        sidthread_render(&sid_engine, psid, nr, scc, *delta_t);
+    }
+
     if (soc == 1 && scc == 1) {
-        return sid_engine.calculate_samples(psid[0], pbuf, nr, 1, delta_t);
+        return sid_calculate_chip_samples(psid, 0, pbuf, nr, 1, delta_t);
     }
     if (soc == 1 && scc == 2) {
         tmp_buf1 = getbuf1(2 * nr);
-        tmp_nr = sid_engine.calculate_samples(psid[0], tmp_buf1, nr, 1, &tmp_delta_t);
-        tmp_nr = sid_engine.calculate_samples(psid[1], pbuf, nr, 1, delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 0, tmp_buf1, nr, 1, &tmp_delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 1, pbuf, nr, 1, delta_t);
         for (i = 0; i < tmp_nr; i++) {
             pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf1[i]);
         }
@@ -661,10 +701,10 @@ int sid_sound_machine_calculate_samples(sound_t **psid, int16_t *pbuf, int nr, i
     if (soc == 1 && scc == 3) {
         tmp_buf1 = getbuf1(2 * nr);
         tmp_buf2 = getbuf2(2 * nr);
-        tmp_nr = sid_engine.calculate_samples(psid[0], tmp_buf1, nr, 1, &tmp_delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 0, tmp_buf1, nr, 1, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[2], tmp_buf2, nr, 1, &tmp_delta_t);
-        tmp_nr = sid_engine.calculate_samples(psid[1], pbuf, nr, 1, delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 2, tmp_buf2, nr, 1, &tmp_delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 1, pbuf, nr, 1, delta_t);
         for (i = 0; i < tmp_nr; i++) {
             pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf1[i]);
             pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf2[i]);
@@ -675,12 +715,12 @@ int sid_sound_machine_calculate_samples(sound_t **psid, int16_t *pbuf, int nr, i
         tmp_buf1 = getbuf1(2 * nr);
         tmp_buf2 = getbuf2(2 * nr);
         tmp_buf3 = getbuf3(2 * nr);
-        tmp_nr = sid_engine.calculate_samples(psid[0], tmp_buf1, nr, 1, &tmp_delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 0, tmp_buf1, nr, 1, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[2], tmp_buf2, nr, 1, &tmp_delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 2, tmp_buf2, nr, 1, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[3], tmp_buf3, nr, 1, &tmp_delta_t);
-        tmp_nr = sid_engine.calculate_samples(psid[1], pbuf, nr, 1, delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 3, tmp_buf3, nr, 1, &tmp_delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 1, pbuf, nr, 1, delta_t);
         for (i = 0; i < tmp_nr; i++) {
             pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf1[i]);
             pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf2[i]);
@@ -693,14 +733,14 @@ int sid_sound_machine_calculate_samples(sound_t **psid, int16_t *pbuf, int nr, i
         tmp_buf2 = getbuf2(2 * nr);
         tmp_buf3 = getbuf3(2 * nr);
         tmp_buf4 = getbuf4(2 * nr);
-        tmp_nr = sid_engine.calculate_samples(psid[0], tmp_buf1, nr, 1, &tmp_delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 0, tmp_buf1, nr, 1, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[2], tmp_buf2, nr, 1, &tmp_delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 2, tmp_buf2, nr, 1, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[3], tmp_buf3, nr, 1, &tmp_delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 3, tmp_buf3, nr, 1, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[4], tmp_buf4, nr, 1, &tmp_delta_t);
-        tmp_nr = sid_engine.calculate_samples(psid[1], pbuf, nr, 1, delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 4, tmp_buf4, nr, 1, &tmp_delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 1, pbuf, nr, 1, delta_t);
         for (i = 0; i < tmp_nr; i++) {
             pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf1[i]);
             pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf2[i]);
@@ -715,16 +755,16 @@ int sid_sound_machine_calculate_samples(sound_t **psid, int16_t *pbuf, int nr, i
         tmp_buf3 = getbuf3(2 * nr);
         tmp_buf4 = getbuf4(2 * nr);
         tmp_buf5 = getbuf5(2 * nr);
-        tmp_nr = sid_engine.calculate_samples(psid[0], tmp_buf1, nr, 1, &tmp_delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 0, tmp_buf1, nr, 1, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[2], tmp_buf2, nr, 1, &tmp_delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 2, tmp_buf2, nr, 1, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[3], tmp_buf3, nr, 1, &tmp_delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 3, tmp_buf3, nr, 1, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[4], tmp_buf4, nr, 1, &tmp_delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 4, tmp_buf4, nr, 1, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[5], tmp_buf5, nr, 1, &tmp_delta_t);
-        tmp_nr = sid_engine.calculate_samples(psid[1], pbuf, nr, 1, delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 5, tmp_buf5, nr, 1, &tmp_delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 1, pbuf, nr, 1, delta_t);
         for (i = 0; i < tmp_nr; i++) {
             pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf1[i]);
             pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf2[i]);
@@ -741,18 +781,18 @@ int sid_sound_machine_calculate_samples(sound_t **psid, int16_t *pbuf, int nr, i
         tmp_buf4 = getbuf4(2 * nr);
         tmp_buf5 = getbuf5(2 * nr);
         tmp_buf6 = getbuf6(2 * nr);
-        tmp_nr = sid_engine.calculate_samples(psid[0], tmp_buf1, nr, 1, &tmp_delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 0, tmp_buf1, nr, 1, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[2], tmp_buf2, nr, 1, &tmp_delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 2, tmp_buf2, nr, 1, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[3], tmp_buf3, nr, 1, &tmp_delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 3, tmp_buf3, nr, 1, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[4], tmp_buf4, nr, 1, &tmp_delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 4, tmp_buf4, nr, 1, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[5], tmp_buf5, nr, 1, &tmp_delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 5, tmp_buf5, nr, 1, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[6], tmp_buf6, nr, 1, &tmp_delta_t);
-        tmp_nr = sid_engine.calculate_samples(psid[1], pbuf, nr, 1, delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 6, tmp_buf6, nr, 1, &tmp_delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 1, pbuf, nr, 1, delta_t);
         for (i = 0; i < tmp_nr; i++) {
             pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf1[i]);
             pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf2[i]);
@@ -771,20 +811,20 @@ int sid_sound_machine_calculate_samples(sound_t **psid, int16_t *pbuf, int nr, i
         tmp_buf5 = getbuf5(2 * nr);
         tmp_buf6 = getbuf6(2 * nr);
         tmp_buf7 = getbuf7(2 * nr);
-        tmp_nr = sid_engine.calculate_samples(psid[0], tmp_buf1, nr, 1, &tmp_delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 0, tmp_buf1, nr, 1, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[2], tmp_buf2, nr, 1, &tmp_delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 2, tmp_buf2, nr, 1, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[3], tmp_buf3, nr, 1, &tmp_delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 3, tmp_buf3, nr, 1, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[4], tmp_buf4, nr, 1, &tmp_delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 4, tmp_buf4, nr, 1, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[5], tmp_buf5, nr, 1, &tmp_delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 5, tmp_buf5, nr, 1, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[6], tmp_buf6, nr, 1, &tmp_delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 6, tmp_buf6, nr, 1, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[7], tmp_buf7, nr, 1, &tmp_delta_t);
-        tmp_nr = sid_engine.calculate_samples(psid[1], pbuf, nr, 1, delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 7, tmp_buf7, nr, 1, &tmp_delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 1, pbuf, nr, 1, delta_t);
         for (i = 0; i < tmp_nr; i++) {
             pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf1[i]);
             pbuf[i] = sound_audio_mix(pbuf[i], tmp_buf2[i]);
@@ -797,23 +837,23 @@ int sid_sound_machine_calculate_samples(sound_t **psid, int16_t *pbuf, int nr, i
         return tmp_nr;
     }
     if (soc == 2 && scc == 1) {
-        tmp_nr = sid_engine.calculate_samples(psid[0], pbuf, nr, 2, delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 0, pbuf, nr, 2, delta_t);
         for (i = 0; i < tmp_nr; i++) {
             pbuf[(i * 2) + 1] = pbuf[i * 2];
         }
         return tmp_nr;
     }
     if (soc == 2 && scc == 2) {
-        tmp_nr = sid_engine.calculate_samples(psid[0], pbuf, nr, 2, &tmp_delta_t);
-        tmp_nr = sid_engine.calculate_samples(psid[1], pbuf + 1, nr, 2, delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 0, pbuf, nr, 2, &tmp_delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 1, pbuf + 1, nr, 2, delta_t);
         return tmp_nr;
     }
     if (soc == 2 && scc == 3) {
         tmp_buf1 = getbuf1(2 * nr);
-        tmp_nr = sid_engine.calculate_samples(psid[2], tmp_buf1, nr, 1, &tmp_delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 2, tmp_buf1, nr, 1, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[0], pbuf, nr, 2, &tmp_delta_t);
-        tmp_nr = sid_engine.calculate_samples(psid[1], pbuf + 1, nr, 2, delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 0, pbuf, nr, 2, &tmp_delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 1, pbuf + 1, nr, 2, delta_t);
         for (i = 0; i < tmp_nr; i++) {
             pbuf[i * 2] = sound_audio_mix(pbuf[i * 2], tmp_buf1[i]);
             // pbuf[(i * 2) + 1] = sound_audio_mix(pbuf[(i * 2) + 1], tmp_buf1[i]);
@@ -821,12 +861,12 @@ int sid_sound_machine_calculate_samples(sound_t **psid, int16_t *pbuf, int nr, i
     }
     if (soc == 2 && scc == 4) {
         tmp_buf1 = getbuf1(2 * nr);
-        tmp_nr = sid_engine.calculate_samples(psid[2], tmp_buf1, nr, 2, &tmp_delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 2, tmp_buf1, nr, 2, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[3], tmp_buf1 + 1, nr, 2, &tmp_delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 3, tmp_buf1 + 1, nr, 2, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[0], pbuf, nr, 2, &tmp_delta_t);
-        tmp_nr = sid_engine.calculate_samples(psid[1], pbuf + 1, nr, 2, delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 0, pbuf, nr, 2, &tmp_delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 1, pbuf + 1, nr, 2, delta_t);
         for (i = 0; i < tmp_nr; i++) {
             pbuf[i * 2] = sound_audio_mix(pbuf[i * 2], tmp_buf1[i * 2]);
             pbuf[(i * 2) + 1] = sound_audio_mix(pbuf[(i * 2) + 1], tmp_buf1[(i * 2) + 1]);
@@ -835,15 +875,15 @@ int sid_sound_machine_calculate_samples(sound_t **psid, int16_t *pbuf, int nr, i
     if (soc == 2 && scc == 5) {
         tmp_buf1 = getbuf1(2 * nr);
         tmp_buf2 = getbuf2(2 * nr);
-        tmp_nr = sid_engine.calculate_samples(psid[2], tmp_buf1, nr, 2, &tmp_delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 2, tmp_buf1, nr, 2, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[3], tmp_buf1 + 1, nr, 2, &tmp_delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 3, tmp_buf1 + 1, nr, 2, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[4], tmp_buf2, nr, 2, &tmp_delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 4, tmp_buf2, nr, 2, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[0], pbuf, nr, 2, &tmp_delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 0, pbuf, nr, 2, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[1], pbuf + 1, nr, 2, delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 1, pbuf + 1, nr, 2, delta_t);
         for (i = 0; i < tmp_nr; i++) {
             pbuf[i * 2] = sound_audio_mix(pbuf[i * 2], tmp_buf1[i * 2]);
             pbuf[(i * 2) + 1] = sound_audio_mix(pbuf[(i * 2) + 1], tmp_buf1[(i * 2) + 1]);
@@ -856,17 +896,17 @@ int sid_sound_machine_calculate_samples(sound_t **psid, int16_t *pbuf, int nr, i
     if (soc == 2 && scc == 6) {
         tmp_buf1 = getbuf1(2 * nr);
         tmp_buf2 = getbuf2(2 * nr);
-        tmp_nr = sid_engine.calculate_samples(psid[2], tmp_buf1, nr, 2, &tmp_delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 2, tmp_buf1, nr, 2, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[3], tmp_buf1 + 1, nr, 2, &tmp_delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 3, tmp_buf1 + 1, nr, 2, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[4], tmp_buf2, nr, 2, &tmp_delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 4, tmp_buf2, nr, 2, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[5], tmp_buf2 + 1, nr, 2, &tmp_delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 5, tmp_buf2 + 1, nr, 2, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[0], pbuf, nr, 2, &tmp_delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 0, pbuf, nr, 2, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[1], pbuf + 1, nr, 2, delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 1, pbuf + 1, nr, 2, delta_t);
         for (i = 0; i < tmp_nr; i++) {
             pbuf[i * 2] = sound_audio_mix(pbuf[i * 2], tmp_buf1[i * 2]);
             pbuf[(i * 2) + 1] = sound_audio_mix(pbuf[(i * 2) + 1], tmp_buf1[(i * 2) + 1]);
@@ -880,19 +920,19 @@ int sid_sound_machine_calculate_samples(sound_t **psid, int16_t *pbuf, int nr, i
         tmp_buf1 = getbuf1(2 * nr);
         tmp_buf2 = getbuf2(2 * nr);
         tmp_buf3 = getbuf3(2 * nr);
-        tmp_nr = sid_engine.calculate_samples(psid[2], tmp_buf1, nr, 2, &tmp_delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 2, tmp_buf1, nr, 2, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[3], tmp_buf1 + 1, nr, 2, &tmp_delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 3, tmp_buf1 + 1, nr, 2, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[4], tmp_buf2, nr, 2, &tmp_delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 4, tmp_buf2, nr, 2, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[5], tmp_buf2 + 1, nr, 2, &tmp_delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 5, tmp_buf2 + 1, nr, 2, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[6], tmp_buf3, nr, 2, &tmp_delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 6, tmp_buf3, nr, 2, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[0], pbuf, nr, 2, &tmp_delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 0, pbuf, nr, 2, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[1], pbuf + 1, nr, 2, delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 1, pbuf + 1, nr, 2, delta_t);
         for (i = 0; i < tmp_nr; i++) {
             pbuf[i * 2] = sound_audio_mix(pbuf[i * 2], tmp_buf1[i * 2]);
             pbuf[(i * 2) + 1] = sound_audio_mix(pbuf[(i * 2) + 1], tmp_buf1[(i * 2) + 1]);
@@ -910,21 +950,21 @@ int sid_sound_machine_calculate_samples(sound_t **psid, int16_t *pbuf, int nr, i
         tmp_buf1 = getbuf1(2 * nr);
         tmp_buf2 = getbuf2(2 * nr);
         tmp_buf3 = getbuf3(2 * nr);
-        tmp_nr = sid_engine.calculate_samples(psid[2], tmp_buf1, nr, 2, &tmp_delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 2, tmp_buf1, nr, 2, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[3], tmp_buf1 + 1, nr, 2, &tmp_delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 3, tmp_buf1 + 1, nr, 2, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[4], tmp_buf2, nr, 2, &tmp_delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 4, tmp_buf2, nr, 2, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[5], tmp_buf2 + 1, nr, 2, &tmp_delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 5, tmp_buf2 + 1, nr, 2, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[6], tmp_buf3, nr, 2, &tmp_delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 6, tmp_buf3, nr, 2, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[7], tmp_buf3 + 1, nr, 2, &tmp_delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 7, tmp_buf3 + 1, nr, 2, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[0], pbuf, nr, 2, &tmp_delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 0, pbuf, nr, 2, &tmp_delta_t);
         tmp_delta_t = *delta_t;
-        tmp_nr = sid_engine.calculate_samples(psid[1], pbuf + 1, nr, 2, delta_t);
+        tmp_nr = sid_calculate_chip_samples(psid, 1, pbuf + 1, nr, 2, delta_t);
         for (i = 0; i < tmp_nr; i++) {
             pbuf[i * 2] = sound_audio_mix(pbuf[i * 2], tmp_buf1[i * 2]);
             pbuf[(i * 2) + 1] = sound_audio_mix(pbuf[(i * 2) + 1], tmp_buf1[(i * 2) + 1]);
@@ -990,6 +1030,16 @@ int sid_sound_machine_channels(void)
     return channels + 1;
 }
 
+#ifdef HAVE_RESID
+/* Stores may be queued and done by the SID worker threads.  */
+static void sid_store_queued(uint16_t addr, uint8_t val, int chipno)
+{
+    if (!sidthread_store(addr, val, chipno)) {
+        sound_store(addr, val, chipno);
+    }
+}
+#endif
+
 static void set_sound_func(void)
 {
     if (sid_enable) {
@@ -1001,7 +1051,7 @@ static void set_sound_func(void)
 #ifdef HAVE_RESID
         if (sid_engine_type == SID_ENGINE_RESID) {
             sid_read_func = sound_read;
-            sid_store_func = sound_store;
+            sid_store_func = sid_store_queued;
             sid_dump_func = sound_dump;
         }
 #endif
@@ -1112,6 +1162,7 @@ void sid_state_read(unsigned int channel, sid_snapshot_state_t *sid_state)
 
 void sid_state_write(unsigned int channel, sid_snapshot_state_t *sid_state)
 {
+    sidthread_discard((int)channel);
     sid_engine.state_write(sound_get_psid(channel), sid_state);
 }
 
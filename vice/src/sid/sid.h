@@ -122,6 +122,7 @@ struct sid_engine_s {
                        struct sid_snapshot_state_s *sid_state);
     void (*state_write)(struct sound_s *psid,
                         struct sid_snapshot_state_s *sid_state);
+    void (*clock_silent)(struct sound_s *psid, int delta_t);
 };
 typedef struct sid_engine_s sid_engine_t;
 
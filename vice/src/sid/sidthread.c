@@ -0,0 +1,422 @@
+/*
+ * sidthread.c - Calculate the samples of multiple SIDs on worker threads.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/* Normally every store to a SID first brings all SIDs up to date, so with
+   several chips the samples are calculated in many small pieces, one chip
+   after the other.  When enabled, stores to the SIDs are instead queued
+   with their clock value, and the samples are only calculated when the
+   sound code asks for them (once per frame, or earlier when a SID is read
+   or another sound chip is written to).  Each chip then runs on its own
+   worker thread, replaying its queued stores at the right cycles, and the
+   main thread mixes the finished buffers as usual.  Since a SID only
+   depends on its own stores, the output is identical.  */
+
+#include "vice.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "clkguard.h"
+#include "lib.h"
+#include "log.h"
+#include "maincpu.h"
+#include "sid.h"
+#include "sidthread.h"
+#include "sound.h"
+#include "types.h"
+
+#ifdef USE_WORKER_THREADS
+#include <pthread.h>
+#endif
+
+int sidthread_enabled = 0;
+
+#ifdef USE_WORKER_THREADS
+
+/* Windows shorter than this many cycles are calculated on the main thread,
+   replaying the queued stores.  */
+#define SIDTHREAD_MIN_CYCLES  1000
+
+/* Number of stores that can be queued per chip.  When the queue is full
+   the store is done the normal way, which empties it.  */
+#define SIDTHREAD_QUEUE_SIZE  1024
+
+typedef struct sidthread_store_s {
+    CLOCK clk;
+    uint16_t addr;
+    uint8_t val;
+} sidthread_store_t;
+
+typedef struct sidthread_chip_s {
+    sound_t *psid;
+
+    /* Queued stores, in clock order.  */
+    sidthread_store_t queue[SIDTHREAD_QUEUE_SIZE];
+    int queued;
+
+    /* Samples calculated by the last sidthread_render().  */
+    int16_t *buffer;
+    int buffer_size;
+    int nr;
+    int delta_t;
+    int ready;
+
+    pthread_t thread;
+    int created;
+
+    /* Job number this thread has last picked up.  */
+    unsigned int job;
+} sidthread_chip_t;
+
+static sidthread_chip_t chips[SOUND_SIDS_MAX];
+
+/* Number of chips stores are queued for, 0 if stores are not queued.  */
+static int queue_chips = 0;
+
+static int guard_added = 0;
+
+/* Parameters of the current job.  */
+static sid_engine_t *job_engine;
+static int job_nr;
+static int job_delta_t;
+static CLOCK job_start;
+static int job_chips;
+static unsigned int job_count = 0;
+static int job_busy = 0;
+
+static pthread_mutex_t sidthread_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t sidthread_cond = PTHREAD_COND_INITIALIZER;
+static int quit = 0;
+
+static log_t sidthread_log = LOG_ERR;
+
+/* Calculate `job_delta_t' cycles of samples for `c', doing its queued
+   stores at their cycle.  */
+static void sidthread_render_chip(sidthread_chip_t *c)
+{
+    CLOCK pos = job_start;
+    CLOCK end = job_start + (CLOCK)job_delta_t;
+    int lost = 0, nr = 0;
+    int i, dt;
+
+    for (i = 0; i < c->queued; i++) {
+        if (c->queue[i].clk > end) {
+            break;
+        }
+        if (c->queue[i].clk > pos) {
+            dt = (int)(c->queue[i].clk - pos);
+            pos = c->queue[i].clk;
+            nr += job_engine->calculate_samples(c->psid, c->buffer + nr,
+                                                job_nr - nr, 1, &dt);
+            lost += dt;
+        }
+        job_engine->store(c->psid, c->queue[i].addr, c->queue[i].val);
+    }
+
+    /* Keep stores beyond the end of the window for the next one.  */
+    if (i < c->queued) {
+        memmove(c->queue, c->queue + i,
+                (c->queued - i) * sizeof(sidthread_store_t));
+    }
+    c->queued -= i;
+
+    dt = (int)(end - pos);
+    nr += job_engine->calculate_samples(c->psid, c->buffer + nr, job_nr - nr,
+                                        1, &dt);
+    lost += dt;
+
+    c->nr = nr;
+    c->delta_t = lost;
+    c->ready = 1;
+}
+
+static void *sidthread_main(void *arg)
+{
+    unsigned int chipno = vice_ptr_to_uint(arg);
+    sidthread_chip_t *c = &chips[chipno];
+
+    pthread_mutex_lock(&sidthread_lock);
+
+    for (;;) {
+        while (!quit && c->job == job_count) {
+            pthread_cond_wait(&sidthread_cond, &sidthread_lock);
+        }
+        if (quit) {
+            break;
+        }
+        c->job = job_count;
+
+        if (chipno >= (unsigned int)job_chips) {
+            continue;
+        }
+
+        pthread_mutex_unlock(&sidthread_lock);
+        sidthread_render_chip(c);
+        pthread_mutex_lock(&sidthread_lock);
+
+        if (--job_busy == 0) {
+            pthread_cond_broadcast(&sidthread_cond);
+        }
+    }
+
+    pthread_mutex_unlock(&sidthread_lock);
+
+    return NULL;
+}
+
+static int sidthread_create(unsigned int chipno)
+{
+    sidthread_chip_t *c = &chips[chipno];
+
+    if (c->created) {
+        return 0;
+    }
+
+    if (sidthread_log == LOG_ERR) {
+        sidthread_log = log_open("SidThread");
+    }
+
+    c->job = job_count;
+
+    if (pthread_create(&c->thread, NULL, sidthread_main,
+                       uint_to_void_ptr(chipno)) != 0) {
+        log_error(sidthread_log, "Cannot create worker thread for SID #%u.",
+                  chipno + 1);
+        return -1;
+    }
+    c->created = 1;
+
+    return 0;
+}
+
+static void clk_overflow_callback(CLOCK sub, void *data)
+{
+    int c, i;
+
+    for (c = 0; c < SOUND_SIDS_MAX; c++) {
+        for (i = 0; i < chips[c].queued; i++) {
+            chips[c].queue[i].clk -= sub;
+        }
+    }
+}
+
+/* Queue a store to SID `chipno'.  Return 0 if the store has to be done
+   right away instead.  */
+int sidthread_store(uint16_t addr, uint8_t val, int chipno)
+{
+    sidthread_chip_t *c;
+
+    if (chipno >= queue_chips || !sound_can_queue_stores()) {
+        return 0;
+    }
+
+    c = &chips[chipno];
+
+    if (c->queued == SIDTHREAD_QUEUE_SIZE) {
+        return 0;
+    }
+
+    if (!guard_added) {
+        clk_guard_add_callback(maincpu_clk_guard, clk_overflow_callback, NULL);
+        guard_added = 1;
+    }
+
+    c->queue[c->queued].clk = maincpu_clk;
+    c->queue[c->queued].addr = addr;
+    c->queue[c->queued].val = val;
+    c->queued++;
+
+    return 1;
+}
+
+/* Calculate up to `nr' samples covering the last `delta_t' cycles for each
+   of the first `count' chips, to be picked up with sidthread_fetch().
+   Return -1 if the caller has to calculate them itself.  */
+int sidthread_render(sid_engine_t *engine, sound_t **psid, int nr, int count,
+                     int delta_t)
+{
+    int i, pending = 0;
+
+    for (i = 0; i < SOUND_SIDS_MAX; i++) {
+        chips[i].ready = 0;
+        pending += chips[i].queued;
+    }
+
+    if (!pending && (!sidthread_enabled || count < 2)) {
+        queue_chips = 0;
+        return -1;
+    }
+
+    for (i = 0; i < count; i++) {
+        chips[i].psid = psid[i];
+        if (chips[i].buffer_size < nr) {
+            chips[i].buffer = lib_realloc(chips[i].buffer, nr * sizeof(int16_t));
+            chips[i].buffer_size = nr;
+        }
+    }
+
+    job_engine = engine;
+    job_nr = nr;
+    job_delta_t = delta_t;
+    job_start = maincpu_clk - (CLOCK)delta_t;
+
+    if (sidthread_enabled && count > 1 && delta_t >= SIDTHREAD_MIN_CYCLES) {
+        for (i = 1; i < count; i++) {
+            if (sidthread_create(i) < 0) {
+                break;
+            }
+        }
+    } else {
+        i = 0;
+    }
+
+    if (i == count) {
+        pthread_mutex_lock(&sidthread_lock);
+        job_chips = count;
+        job_busy = count - 1;
+        job_count++;
+        pthread_cond_broadcast(&sidthread_cond);
+        pthread_mutex_unlock(&sidthread_lock);
+
+        sidthread_render_chip(&chips[0]);
+
+        pthread_mutex_lock(&sidthread_lock);
+        while (job_busy > 0) {
+            pthread_cond_wait(&sidthread_cond, &sidthread_lock);
+        }
+        pthread_mutex_unlock(&sidthread_lock);
+    } else {
+        for (i = 0; i < count; i++) {
+            sidthread_render_chip(&chips[i]);
+        }
+    }
+
+    queue_chips = sidthread_enabled ? count : 0;
+
+    return 0;
+}
+
+/* Copy the samples of `chipno' calculated by sidthread_render() to `pbuf'.
+   Return -1 if there are none.  */
+int sidthread_fetch(int chipno, int16_t *pbuf, int interleave, int *delta_t)
+{
+    sidthread_chip_t *c = &chips[chipno];
+    int i;
+
+    if (!c->ready) {
+        return -1;
+    }
+
+    for (i = 0; i < c->nr; i++) {
+        pbuf[i * interleave] = c->buffer[i];
+    }
+    *delta_t = c->delta_t;
+    c->ready = 0;
+
+    return c->nr;
+}
+
+/* Return nonzero if there are queued stores.  */
+int sidthread_pending(void)
+{
+    int i;
+
+    for (i = 0; i < SOUND_SIDS_MAX; i++) {
+        if (chips[i].queued) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/* Drop the queued stores of `chipno', or of all chips if it is -1.  */
+void sidthread_discard(int chipno)
+{
+    int i;
+
+    for (i = 0; i < SOUND_SIDS_MAX; i++) {
+        if (chipno < 0 || chipno == i) {
+            chips[i].queued = 0;
+            chips[i].ready = 0;
+        }
+    }
+}
+
+void sidthread_shutdown(void)
+{
+    int i;
+
+    sidthread_discard(-1);
+    queue_chips = 0;
+
+    pthread_mutex_lock(&sidthread_lock);
+    quit = 1;
+    pthread_cond_broadcast(&sidthread_cond);
+    pthread_mutex_unlock(&sidthread_lock);
+
+    for (i = 0; i < SOUND_SIDS_MAX; i++) {
+        if (chips[i].created) {
+            pthread_join(chips[i].thread, NULL);
+            chips[i].created = 0;
+        }
+        lib_free(chips[i].buffer);
+        chips[i].buffer = NULL;
+        chips[i].buffer_size = 0;
+    }
+
+    quit = 0;
+}
+
+#else
+
+int sidthread_store(uint16_t addr, uint8_t val, int chipno)
+{
+    return 0;
+}
+
+int sidthread_render(sid_engine_t *engine, sound_t **psid, int nr, int count,
+                     int delta_t)
+{
+    return -1;
+}
+
+int sidthread_fetch(int chipno, int16_t *pbuf, int interleave, int *delta_t)
+{
+    return -1;
+}
+
+int sidthread_pending(void)
+{
+    return 0;
+}
+
+void sidthread_discard(int chipno)
+{
+}
+
+void sidthread_shutdown(void)
+{
+}
+
+#endif
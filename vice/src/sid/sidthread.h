@@ -0,0 +1,44 @@
+/*
+ * sidthread.h - Calculate the samples of multiple SIDs on worker threads.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#ifndef VICE_SIDTHREAD_H
+#define VICE_SIDTHREAD_H
+
+#include "sound.h"
+#include "types.h"
+
+struct sid_engine_s;
+
+/* Value of the `SidWorkerThreads' resource.  */
+extern int sidthread_enabled;
+
+extern int sidthread_store(uint16_t addr, uint8_t val, int chipno);
+extern int sidthread_render(struct sid_engine_s *engine, sound_t **psid,
+                            int nr, int chips, int delta_t);
+extern int sidthread_fetch(int chipno, int16_t *pbuf, int interleave,
+                           int *delta_t);
+extern int sidthread_pending(void);
+extern void sidthread_discard(int chipno);
+extern void sidthread_shutdown(void);
+
+#endif
@@ -28,6 +28,8 @@
 #ifndef SNAPSHOT_H
 #define SNAPSHOT_H
 
+#include <stddef.h>
+
 #include "types.h"
 
 #define SNAPSHOT_MACHINE_NAME_LEN       16
@@ -63,6 +65,14 @@
 typedef struct snapshot_module_s snapshot_module_t;
 typedef struct snapshot_s snapshot_t;
 
+/* Snapshot kept in memory, see snapshot_set_memory().  */
+typedef struct snapshot_memory_s {
+    uint8_t *data;
+    size_t size;
+    size_t alloc;
+    size_t pos;
+} snapshot_memory_t;
+
 extern void snapshot_display_error(void);
 
 extern int snapshot_module_write_byte(snapshot_module_t *m, uint8_t data);
@@ -145,6 +155,8 @@ extern snapshot_t *snapshot_open(const char *filename,
                                  const char *snapshot_machine_name);
 extern int snapshot_close(snapshot_t *s);
 
+extern void snapshot_set_memory(snapshot_memory_t *mem);
+
 extern void snapshot_set_error(int error);
 
 extern int snapshot_version_at_least(uint8_t major_version, uint8_t minor_version, uint8_t major_version_required, uint8_t minor_version_required);
@@ -41,6 +41,7 @@
 #endif
 
 #include "archdep.h"
+#include "benchmark.h"
 #include "clkguard.h"
 #include "cmdline.h"
 #include "debug.h"
@@ -274,6 +275,20 @@ static int sound_machine_calculate_samples(sound_t **psid, int16_t *pbuf, int nr
     return temp;
 }
 
+/* Return the number of sound chips sound_machine_calculate_samples() asks
+   for samples.  */
+int sound_machine_chips_active(void)
+{
+    int i, count = 0;
+
+    for (i = 0; i < (offset >> 5); i++) {
+        if (sound_calls[i]->chip_enabled || (i == 0 && sound_calls[0]->cycle_based())) {
+            count++;
+        }
+    }
+    return count;
+}
+
 static void sound_machine_store(sound_t *psid, uint16_t addr, uint8_t val)
 {
     sound_calls[addr >> 5]->store(psid, (uint16_t)(addr & 0x1f), val);
@@ -341,6 +356,7 @@ static int volume;
 static int amp;
 static int fragment_size;
 static int output_option;
+static int output_thread;
 
 /* divisors for fragment size calculation */
 static int fragment_divisor[] = {
@@ -527,6 +543,13 @@ static int set_volume(int val, void *param)
     return 0;
 }
 
+static int set_output_thread(int val, void *param)
+{
+    output_thread = val ? 1 : 0;
+    sound_state_changed = TRUE;
+    return 0;
+}
+
 static const resource_string_t resources_string[] = {
     { "SoundDeviceName", "", RES_EVENT_NO, NULL,
       &device_name, set_device_name, NULL },
@@ -556,6 +579,8 @@ static const resource_int_t resources_int[] = {
       (void *)&volume, set_volume, NULL },
     { "SoundOutput", ARCHDEP_SOUND_OUTPUT_MODE, RES_EVENT_NO, NULL,
       (void *)&output_option, set_output_option, NULL },
+    { "SoundOutputThread", 0, RES_EVENT_NO, NULL,
+      (void *)&output_thread, set_output_thread, NULL },
     RESOURCE_INT_LIST_END
 };
 
@@ -626,6 +651,16 @@ static const cmdline_option_t cmdline_options[] = {
       USE_PARAM_ID, USE_DESCRIPTION_ID,
       IDCLS_P_VOLUME, IDCLS_SOUND_VOLUME,
       NULL, NULL },
+    { "-soundoutputthread", SET_RESOURCE, 0,
+      NULL, NULL, "SoundOutputThread", (resource_value_t)1,
+      USE_PARAM_STRING, USE_DESCRIPTION_STRING,
+      IDCLS_UNUSED, IDCLS_UNUSED,
+      NULL, "Write to the sound device from a separate output thread" },
+    { "+soundoutputthread", SET_RESOURCE, 0,
+      NULL, NULL, "SoundOutputThread", (resource_value_t)0,
+      USE_PARAM_STRING, USE_DESCRIPTION_STRING,
+      IDCLS_UNUSED, IDCLS_UNUSED,
+      NULL, "Write to the sound device from the emulation thread" },
     CMDLINE_LIST_END
 };
 
@@ -1247,12 +1282,14 @@ static int sound_run_sound(void)
     if (cycle_based) {
         delta_t = maincpu_clk - snddata.lastclk;
         bufferptr = snddata.buffer + snddata.bufptr * snddata.sound_output_channels;
+        BENCHMARK_ENTER(BENCHMARK_SOUND);
         nr = sound_machine_calculate_samples(snddata.psid,
                                              bufferptr,
                                              SOUND_BUFSIZE - snddata.bufptr,
                                              snddata.sound_output_channels,
                                              snddata.sound_chip_channels,
                                              &delta_t);
+        BENCHMARK_LEAVE();
         if (delta_t) {
             if (overflow_warning_count < 25) {
                 log_warning(sound_log, "%s", translate_text(IDGS_SOUND_BUFFER_OVERFLOW_CYCLE));
@@ -1279,12 +1316,14 @@ static int sound_run_sound(void)
 #endif
         }
         bufferptr = snddata.buffer + snddata.bufptr * snddata.sound_output_channels;
+        BENCHMARK_ENTER(BENCHMARK_SOUND);
         sound_machine_calculate_samples(snddata.psid,
                                         bufferptr,
                                         nr,
                                         snddata.sound_output_channels,
                                         snddata.sound_chip_channels,
                                         &delta_t);
+        BENCHMARK_LEAVE();
         snddata.fclk += nr * snddata.clkstep;
     }
 
@@ -1377,7 +1416,7 @@ double sound_flush()
         sid_state_changed = FALSE;
     }
 
-    if (warp_mode_enabled && snddata.recdev == NULL) {
+    if (sound_is_silent()) {
         snddata.bufptr = 0;
         return 0;
     }
@@ -1694,6 +1733,22 @@ void sound_store(uint16_t addr, uint8_t val, int chipno)
     }
 }
 
+/* Return nonzero if stores to the sound chips may be delayed until the
+   samples up to the store are calculated, i.e. when sound is running and
+   the device does not need to see every store as it happens.  */
+int sound_can_queue_stores(void)
+{
+    return playback_enabled && !(suspend_time > 0 && disabletime)
+           && snddata.playdev != NULL && snddata.playdev->dump == NULL
+           && !sound_is_silent();
+}
+
+/* Return nonzero if the calculated samples are thrown away, i.e. in warp
+   mode while no sound is recorded.  */
+int sound_is_silent(void)
+{
+    return warp_mode_enabled && snddata.recdev == NULL;
+}
 
 void sound_set_relative_speed(int value)
 {
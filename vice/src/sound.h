@@ -225,6 +225,9 @@ extern int sound_register_device(sound_device_t *pdevice);
 /* other internal functions used around sound -code */
 extern int sound_read(uint16_t addr, int chipno);
 extern void sound_store(uint16_t addr, uint8_t val, int chipno);
+extern int sound_can_queue_stores(void);
+extern int sound_is_silent(void);
+extern int sound_machine_chips_active(void);
 extern long sound_sample_position(void);
 extern int sound_dump(int chipno);
 
@@ -35,6 +35,7 @@
 #include "debug.h"
 #include "log.h"
 #include "sound.h"
+#include "soundring.h"
 
 /* NetBSD doesn't define ESTRPIPE, this fix I noticed in gstreamer code */
 #ifndef ESTRPIPE
@@ -46,11 +47,15 @@ static int alsa_bufsize;
 static int alsa_fragsize;
 static int alsa_channels;
 static int alsa_can_pause;
+static soundring_t *alsa_ring = NULL;
+
+static int alsa_device_write(int16_t *pbuf, size_t nr);
 
 static int alsa_init(const char *param, int *speed, int *fragsize, int *fragnr, int *channels)
 {
     int err, dir;
     unsigned int rate, periods;
+    int use_ring;
     snd_pcm_uframes_t period_size;
     snd_pcm_hw_params_t *hwparams;
 
@@ -110,13 +115,19 @@ static int alsa_init(const char *param, int *speed, int *fragsize, int *fragnr,
     /* number of periods according to the buffer size we wanted, nearest val */
     *fragnr = (alsa_bufsize + *fragsize / 2) / *fragsize;
 
-    periods = (unsigned int)*fragnr;
+    /* With the output thread, most of the buffer is kept in the ring and
+       the device only gets a few periods.  */
+    use_ring = soundring_available() && *fragnr > SOUNDRING_DEVICE_FRAGMENTS;
+
+    periods = (unsigned int)(use_ring ? SOUNDRING_DEVICE_FRAGMENTS : *fragnr);
     dir = 0;
     if ((err = snd_pcm_hw_params_set_periods_near(handle, hwparams, &periods, &dir)) < 0) {
         log_message(LOG_DEFAULT, "Unable to set periods %i for playback: %s", periods, snd_strerror(err));
         goto fail;
     }
-    *fragnr = (int)periods;
+    if (!use_ring) {
+        *fragnr = (int)periods;
+    }
 
     alsa_can_pause = snd_pcm_hw_params_can_pause(hwparams);
 
@@ -129,6 +140,15 @@ static int alsa_init(const char *param, int *speed, int *fragsize, int *fragnr,
     alsa_fragsize = *fragsize;
     alsa_channels = *channels;
 
+    if (use_ring) {
+        alsa_ring = soundring_open("ALSA", alsa_device_write, alsa_bufsize,
+                                   *fragsize, *channels);
+        if (alsa_ring == NULL) {
+            *fragnr = (int)periods;
+            alsa_bufsize = (*fragsize) * (*fragnr);
+        }
+    }
+
     return 0;
 
 fail:
@@ -159,7 +179,7 @@ static int xrun_recovery(snd_pcm_t *handle, int err)
     return err;
 }
 
-static int alsa_write(int16_t *pbuf, size_t nr)
+static int alsa_device_write(int16_t *pbuf, size_t nr)
 {
     int err;
 
@@ -181,12 +201,26 @@ static int alsa_write(int16_t *pbuf, size_t nr)
     return 0;
 }
 
+static int alsa_write(int16_t *pbuf, size_t nr)
+{
+    if (alsa_ring != NULL) {
+        return soundring_write(alsa_ring, pbuf, nr);
+    }
+    return alsa_device_write(pbuf, nr);
+}
+
 static int alsa_bufferspace(void)
 {
+    snd_pcm_sframes_t space;
+
+    if (alsa_ring != NULL) {
+        return soundring_space(alsa_ring);
+    }
+
 #ifdef HAVE_SND_PCM_AVAIL
-    snd_pcm_sframes_t space = snd_pcm_avail(handle);
+    space = snd_pcm_avail(handle);
 #else
-    snd_pcm_sframes_t space = snd_pcm_avail_update(handle);
+    space = snd_pcm_avail_update(handle);
 #endif
     /* keep alsa values real. Values < 0 mean errors, call to alsa_write
      * will resume. */
@@ -198,6 +232,10 @@ static int alsa_bufferspace(void)
 
 static void alsa_close(void)
 {
+    if (alsa_ring != NULL) {
+        soundring_close(alsa_ring);
+        alsa_ring = NULL;
+    }
     snd_pcm_close(handle);
     handle = NULL;
     alsa_bufsize = 0;
@@ -208,7 +246,8 @@ static int alsa_suspend(void)
 {
     int err;
 
-    if (!alsa_can_pause) {
+    /* The output thread owns the device while it runs.  */
+    if (!alsa_can_pause || alsa_ring != NULL) {
         return 1;
     }
 
@@ -224,7 +263,7 @@ static int alsa_resume(void)
 {
     int err;
 
-    if (!alsa_can_pause) {
+    if (!alsa_can_pause || alsa_ring != NULL) {
         return 1;
     }
 
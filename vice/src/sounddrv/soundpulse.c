@@ -30,11 +30,17 @@
 
 #include "log.h"
 #include "sound.h"
+#include "soundring.h"
 
 #include <pulse/simple.h>
 #include <pulse/error.h>
 
 static pa_simple *s = NULL;
+static soundring_t *pulsedrv_ring = NULL;
+
+static int pulsedrv_device_write(int16_t *pbuf, size_t nr);
+static int pulsedrv_bufferspace(void);
+static sound_device_t pulsedrv_device;
 
 
 /* XXX: gcc's -pedantic will warn about these initializations being invalid for
@@ -71,16 +77,39 @@ static int pulsedrv_init(const char *param, int *speed, int *fragsize, int *frag
     attr.fragsize = (uint32_t)(*fragsize * 2);
     attr.tlength = (uint32_t)(*fragsize * *fragnr * 2);
 
+    /* With the output thread, most of the buffer is kept in the ring, and
+       its free space is used for the speed adjustment like with ALSA.  */
+    if (soundring_available() && *fragnr > SOUNDRING_DEVICE_FRAGMENTS) {
+        attr.tlength = (uint32_t)(*fragsize * SOUNDRING_DEVICE_FRAGMENTS * 2);
+    }
+
     s = pa_simple_new(NULL, "VICE", PA_STREAM_PLAYBACK, NULL, "playback", &ss, NULL, &attr, &error);
     if (s == NULL) {
         log_error(LOG_DEFAULT, "pa_simple_new(): %s", pa_strerror(error));
         return 1;
     }
 
+    if (attr.tlength != (uint32_t)(*fragsize * *fragnr * 2)) {
+        pulsedrv_ring = soundring_open("Pulse", pulsedrv_device_write,
+                                       *fragsize * *fragnr, *fragsize,
+                                       *channels);
+        if (pulsedrv_ring == NULL) {
+            /* no output thread, the stream needs the whole buffer */
+            pa_simple_free(s);
+            attr.tlength = (uint32_t)(*fragsize * *fragnr * 2);
+            s = pa_simple_new(NULL, "VICE", PA_STREAM_PLAYBACK, NULL, "playback", &ss, NULL, &attr, &error);
+            if (s == NULL) {
+                log_error(LOG_DEFAULT, "pa_simple_new(): %s", pa_strerror(error));
+                return 1;
+            }
+        }
+    }
+    pulsedrv_device.bufferspace = pulsedrv_ring ? pulsedrv_bufferspace : NULL;
+
     return 0;
 }
 
-static int pulsedrv_write(int16_t *pbuf, size_t nr)
+static int pulsedrv_device_write(int16_t *pbuf, size_t nr)
 {
     int error = 0;
     if (pa_simple_write(s, pbuf, nr * 2, &error)) {
@@ -91,9 +120,27 @@ static int pulsedrv_write(int16_t *pbuf, size_t nr)
     return 0;
 }
 
+static int pulsedrv_write(int16_t *pbuf, size_t nr)
+{
+    if (pulsedrv_ring != NULL) {
+        return soundring_write(pulsedrv_ring, pbuf, nr);
+    }
+    return pulsedrv_device_write(pbuf, nr);
+}
+
+static int pulsedrv_bufferspace(void)
+{
+    return soundring_space(pulsedrv_ring);
+}
+
 static int pulsedrv_suspend(void)
 {
     int error = 0;
+
+    /* The output thread owns the stream while it runs.  */
+    if (pulsedrv_ring != NULL) {
+        return 1;
+    }
     if (pa_simple_flush(s, &error)) {
         log_error(LOG_DEFAULT, "pa_simple_flush(): %s", pa_strerror(error));
         return 1;
@@ -104,6 +151,11 @@ static int pulsedrv_suspend(void)
 static void pulsedrv_close(void)
 {
     int error = 0;
+
+    if (pulsedrv_ring != NULL) {
+        soundring_close(pulsedrv_ring);
+        pulsedrv_ring = NULL;
+    }
     if (pa_simple_flush(s, &error)) {
         log_error(LOG_DEFAULT, "pa_simple_flush(): %s", pa_strerror(error));
         /* don't stop */
@@ -0,0 +1,298 @@
+/*
+ * soundring.c - Lock-free ring buffer and output thread for sound drivers.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/* Drivers with a blocking write function can hand their samples to a ring
+   buffer instead, which is emptied by a separate output thread doing the
+   blocking writes.  The emulation thread is the only producer and the
+   output thread the only consumer, so the read and write positions are
+   plain counters updated with acquire/release semantics, and neither side
+   takes a lock to move samples.  A mutex and condition variable are only
+   used to let the output thread sleep while the ring is empty.
+
+   The ring holds the buffer requested with `SoundBufferSize', while the
+   device itself only queues SOUNDRING_DEVICE_FRAGMENTS fragments, so the
+   total latency is about the same as without the thread.  The driver
+   reports the free space of the ring as its buffer space, so the
+   speed adjustment in sound.c keeps working unchanged.  */
+
+#include "vice.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "lib.h"
+#include "log.h"
+#include "resources.h"
+#include "soundring.h"
+#include "types.h"
+
+#if defined(USE_WORKER_THREADS) && defined(__GNUC__)
+
+#include <pthread.h>
+
+#define RING_LOAD(x)        __atomic_load_n(&(x), __ATOMIC_ACQUIRE)
+#define RING_STORE(x, v)    __atomic_store_n(&(x), (v), __ATOMIC_RELEASE)
+
+struct soundring_s {
+    int16_t *buffer;
+
+    /* Size of `buffer' in samples, a power of two.  */
+    unsigned int size;
+
+    /* Number of samples that may be queued, at most `size'.  */
+    unsigned int limit;
+
+    /* Number of samples written to the device at once.  */
+    unsigned int fragment;
+
+    unsigned int channels;
+
+    /* Total number of samples written and read so far.  Only the emulation
+       thread stores `write_pos', only the output thread `read_pos'.  */
+    unsigned int write_pos;
+    unsigned int read_pos;
+
+    int (*device_write)(int16_t *pbuf, size_t nr);
+
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int waiting;
+    int quit;
+    int error;
+
+    /* Number of times the ring ran dry while playing, and number of times
+       samples had to be dropped because it was full.  */
+    unsigned int underruns;
+    unsigned int overruns;
+
+    char *name;
+};
+
+static log_t soundring_log = LOG_ERR;
+
+static void *soundring_main(void *arg)
+{
+    soundring_t *ring = (soundring_t *)arg;
+    unsigned int r, fill, n;
+    int playing = 0;
+
+    for (;;) {
+        if (RING_LOAD(ring->quit)) {
+            break;
+        }
+
+        r = ring->read_pos;
+        fill = RING_LOAD(ring->write_pos) - r;
+
+        if (fill < ring->fragment) {
+            pthread_mutex_lock(&ring->lock);
+            ring->waiting = 1;
+            while (!ring->quit
+                   && RING_LOAD(ring->write_pos) - r < ring->fragment) {
+                if (playing && RING_LOAD(ring->write_pos) == r) {
+                    ring->underruns++;
+                    playing = 0;
+                }
+                pthread_cond_wait(&ring->cond, &ring->lock);
+            }
+            ring->waiting = 0;
+            pthread_mutex_unlock(&ring->lock);
+            continue;
+        }
+
+        /* Write one fragment, or up to the end of the buffer.  */
+        n = ring->size - (r & (ring->size - 1));
+        if (n > ring->fragment) {
+            n = ring->fragment;
+        }
+
+        if (ring->device_write(ring->buffer + (r & (ring->size - 1)), n)) {
+            RING_STORE(ring->error, 1);
+            break;
+        }
+        playing = 1;
+
+        RING_STORE(ring->read_pos, r + n);
+    }
+
+    return NULL;
+}
+
+int soundring_available(void)
+{
+    int enabled = 0;
+
+    resources_get_int("SoundOutputThread", &enabled);
+
+    return enabled;
+}
+
+/* Start an output thread calling `write' with fragments of `fragsize'
+   frames, buffering up to `frames' frames.  Return NULL if the driver has
+   to write to the device itself.  */
+soundring_t *soundring_open(const char *name,
+                            int (*write)(int16_t *pbuf, size_t nr),
+                            int frames, int fragsize, int channels)
+{
+    soundring_t *ring;
+    unsigned int size;
+
+    if (!soundring_available()) {
+        return NULL;
+    }
+
+    if (soundring_log == LOG_ERR) {
+        soundring_log = log_open("SoundRing");
+    }
+
+    ring = lib_calloc(1, sizeof(soundring_t));
+
+    ring->channels = (unsigned int)channels;
+    ring->limit = (unsigned int)(frames * channels);
+    ring->fragment = (unsigned int)(fragsize * channels);
+
+    /* The fragments are written in one piece unless they wrap around.  */
+    for (size = 1; size < ring->limit; size <<= 1) {
+    }
+    ring->size = size;
+    ring->buffer = lib_malloc(size * sizeof(int16_t));
+
+    ring->device_write = write;
+    ring->name = lib_stralloc(name);
+
+    pthread_mutex_init(&ring->lock, NULL);
+    pthread_cond_init(&ring->cond, NULL);
+
+    if (pthread_create(&ring->thread, NULL, soundring_main, ring) != 0) {
+        log_error(soundring_log, "Cannot create output thread for %s.", name);
+        pthread_mutex_destroy(&ring->lock);
+        pthread_cond_destroy(&ring->cond);
+        lib_free(ring->buffer);
+        lib_free(ring->name);
+        lib_free(ring);
+        return NULL;
+    }
+
+    log_message(soundring_log, "%s: output thread buffers %d frames, device %d.",
+                name, frames, fragsize * SOUNDRING_DEVICE_FRAGMENTS);
+
+    return ring;
+}
+
+/* Queue `nr' samples.  This never blocks; samples that do not fit are
+   dropped.  */
+int soundring_write(soundring_t *ring, int16_t *pbuf, size_t nr)
+{
+    unsigned int w, space, n, idx;
+
+    if (RING_LOAD(ring->error)) {
+        return 1;
+    }
+
+    w = ring->write_pos;
+    space = ring->limit - (w - RING_LOAD(ring->read_pos));
+
+    if (nr > space) {
+        ring->overruns++;
+        nr = space;
+    }
+
+    idx = w & (ring->size - 1);
+    n = ring->size - idx;
+    if (n > nr) {
+        n = (unsigned int)nr;
+    }
+    memcpy(ring->buffer + idx, pbuf, n * sizeof(int16_t));
+    memcpy(ring->buffer, pbuf + n, (nr - n) * sizeof(int16_t));
+
+    RING_STORE(ring->write_pos, w + (unsigned int)nr);
+
+    pthread_mutex_lock(&ring->lock);
+    if (ring->waiting) {
+        pthread_cond_signal(&ring->cond);
+    }
+    pthread_mutex_unlock(&ring->lock);
+
+    return 0;
+}
+
+/* Return the number of frames that can be queued.  */
+int soundring_space(soundring_t *ring)
+{
+    unsigned int fill = ring->write_pos - RING_LOAD(ring->read_pos);
+
+    return (int)((ring->limit - fill) / ring->channels);
+}
+
+/* Stop the output thread, dropping the samples not written yet.  */
+void soundring_close(soundring_t *ring)
+{
+    pthread_mutex_lock(&ring->lock);
+    ring->quit = 1;
+    pthread_cond_signal(&ring->cond);
+    pthread_mutex_unlock(&ring->lock);
+
+    pthread_join(ring->thread, NULL);
+
+    if (ring->underruns > 0 || ring->overruns > 0) {
+        log_warning(soundring_log, "%s: %u underruns, %u overruns.",
+                    ring->name, ring->underruns, ring->overruns);
+    }
+
+    pthread_mutex_destroy(&ring->lock);
+    pthread_cond_destroy(&ring->cond);
+    lib_free(ring->buffer);
+    lib_free(ring->name);
+    lib_free(ring);
+}
+
+#else
+
+int soundring_available(void)
+{
+    return 0;
+}
+
+soundring_t *soundring_open(const char *name,
+                            int (*write)(int16_t *pbuf, size_t nr),
+                            int frames, int fragsize, int channels)
+{
+    return NULL;
+}
+
+int soundring_write(soundring_t *ring, int16_t *pbuf, size_t nr)
+{
+    return 1;
+}
+
+int soundring_space(soundring_t *ring)
+{
+    return 0;
+}
+
+void soundring_close(soundring_t *ring)
+{
+}
+
+#endif
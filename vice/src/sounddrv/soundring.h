@@ -0,0 +1,46 @@
+/*
+ * soundring.h - Lock-free ring buffer and output thread for sound drivers.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#ifndef VICE_SOUNDRING_H
+#define VICE_SOUNDRING_H
+
+#include <stddef.h>
+
+#include "types.h"
+
+/* Number of fragments queued in the device itself when the output thread
+   is used.  The rest of the requested buffer lives in the ring.  */
+#define SOUNDRING_DEVICE_FRAGMENTS  2
+
+struct soundring_s;
+typedef struct soundring_s soundring_t;
+
+extern int soundring_available(void);
+extern soundring_t *soundring_open(const char *name,
+                                   int (*write)(int16_t *pbuf, size_t nr),
+                                   int frames, int fragsize, int channels);
+extern int soundring_write(soundring_t *ring, int16_t *pbuf, size_t nr);
+extern int soundring_space(soundring_t *ring);
+extern void soundring_close(soundring_t *ring);
+
+#endif
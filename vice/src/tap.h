@@ -41,6 +41,7 @@
 
 struct tape_init_s;
 struct tape_file_record_s;
+struct tap_file_index_s;
 
 typedef struct tap_s {
     /* File name.  */
@@ -95,6 +96,20 @@ typedef struct tap_s {
 
     /* Has the tap changed? We correct the size then.  */
     int has_changed;
+
+    /* Part of the image read ahead, see tap_read_data().  */
+    uint8_t *buffer;
+    long buffer_start;
+    long buffer_len;
+
+    /* Position of the next pulse read when looking for files.  */
+    long read_pos;
+
+    /* Files found so far, by file number.  */
+    struct tap_file_index_s *file_index;
+    int file_index_num;
+    int file_index_max;
+    int file_index_generation;
 } tap_t;
 
 extern void tap_init(const struct tape_init_s *init);
@@ -110,4 +125,7 @@ extern struct tape_file_record_s *tap_get_current_file_record(tap_t *tap);
 
 extern int tap_read(tap_t *tap, uint8_t *buf, size_t size);
 
+extern long tap_read_data(tap_t *tap, long pos, uint8_t *buf, long len);
+extern void tap_discard_buffer(tap_t *tap);
+
 #endif
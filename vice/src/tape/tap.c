@@ -75,6 +75,22 @@ static int tap_pulse_tt_short_max = 0x22;
 static int tap_pulse_tt_long_min = 0x23;
 static int tap_pulse_tt_long_max = 0x36;
 
+/* Incremented by tap_init(), as files may be found at other places with
+   other pulse lengths.  */
+static int tap_file_index_generation = 0;
+
+/* Size of the buffer the image is read through.  */
+#define TAP_BUFFER_SIZE 0x10000
+
+/* Start of a file found on the tape, see tap_seek_to_file().  */
+struct tap_file_index_s {
+    /* Position of the header in the image.  */
+    long pos;
+
+    /* Contents of the header.  */
+    tape_file_record_t record;
+};
+
 
 static int tap_header_read(tap_t *tap, FILE *fd)
 {
@@ -97,6 +113,96 @@ static int tap_header_read(tap_t *tap, FILE *fd)
     return 0;
 }
 
+/* ------------------------------------------------------------------------- */
+
+/* Read `len' bytes at position `pos' of the image file into `buf'.  Small
+   reads are served from a buffer, so reading the image a pulse at a time
+   does not cost a call into stdio each.  Return the number of bytes read,
+   or -1 if seeking failed.  */
+long tap_read_data(tap_t *tap, long pos, uint8_t *buf, long len)
+{
+    long n, done = 0;
+
+    if (len >= TAP_BUFFER_SIZE) {
+        if (fseek(tap->fd, pos, SEEK_SET) != 0) {
+            return -1;
+        }
+        return (long)fread(buf, 1, (size_t)len, tap->fd);
+    }
+
+    while (len > 0) {
+        if (pos < tap->buffer_start
+            || pos >= tap->buffer_start + tap->buffer_len) {
+            if (tap->buffer == NULL) {
+                tap->buffer = lib_malloc(TAP_BUFFER_SIZE);
+            }
+            tap->buffer_start = pos;
+            tap->buffer_len = 0;
+            if (fseek(tap->fd, pos, SEEK_SET) != 0) {
+                return done ? done : -1;
+            }
+            tap->buffer_len = (long)fread(tap->buffer, 1, TAP_BUFFER_SIZE,
+                                          tap->fd);
+            if (tap->buffer_len == 0) {
+                break;
+            }
+        }
+        n = tap->buffer_start + tap->buffer_len - pos;
+        if (n > len) {
+            n = len;
+        }
+        memcpy(buf + done, tap->buffer + (pos - tap->buffer_start), (size_t)n);
+        pos += n;
+        done += n;
+        len -= n;
+    }
+
+    return done;
+}
+
+/* Forget the buffered data and the files found so far, after the image
+   has been written to.  */
+void tap_discard_buffer(tap_t *tap)
+{
+    tap->buffer_len = 0;
+    tap->file_index_num = 0;
+}
+
+/* Stand-ins for fread(), fseek() and ftell() on the image, using the
+   buffer.  */
+static size_t tap_fread(tap_t *tap, void *ptr, size_t size, size_t nmemb)
+{
+    long n;
+
+    n = tap_read_data(tap, tap->read_pos, ptr, (long)(size * nmemb));
+    if (n < 0) {
+        return 0;
+    }
+    tap->read_pos += n;
+
+    return (size_t)n / size;
+}
+
+static int tap_fseek(tap_t *tap, long offset, int whence)
+{
+    if (whence == SEEK_CUR) {
+        offset += tap->read_pos;
+    }
+    if (offset < 0) {
+        return -1;
+    }
+    tap->read_pos = offset;
+
+    return 0;
+}
+
+static long tap_ftell(tap_t *tap)
+{
+    return tap->read_pos;
+}
+
+/* ------------------------------------------------------------------------- */
+
 static tap_t *tap_new(void)
 {
     tap_t *tap;
@@ -108,6 +214,7 @@ static tap_t *tap_new(void)
     tap->current_file_seek_position = 0;
     tap->mode = DATASETTE_CONTROL_STOP;
     tap->offset = TAP_HDR_SIZE;
+    tap->read_pos = tap->offset;
     tap->has_changed = 0;
     tap->current_file_number = -1;
     tap->current_file_data = NULL;
@@ -184,6 +291,8 @@ int tap_close(tap_t *tap)
     lib_free(tap->current_file_data);
     lib_free(tap->file_name);
     lib_free(tap->tap_file_record);
+    lib_free(tap->buffer);
+    lib_free(tap->file_index);
     lib_free(tap);
 
     return retval;
@@ -233,7 +342,7 @@ inline static int tap_get_pulse(tap_t *tap, int *pos_advance)
     size_t res;
 
     *pos_advance = 0;
-    res = fread(&data, 1, 1, tap->fd);
+    res = tap_fread(tap, &data, 1, 1);
 
     if (res == 0) {
         return -1;
@@ -246,7 +355,7 @@ inline static int tap_get_pulse(tap_t *tap, int *pos_advance)
             pulse_length = 256;
         } else if ((tap->version == 1) || (tap->version == 2)) {
             uint8_t size[3];
-            res = fread(size, 3, 1, tap->fd);
+            res = tap_fread(tap, size, 3, 1);
             if (res == 0) {
                 return -1;
             }
@@ -261,7 +370,7 @@ inline static int tap_get_pulse(tap_t *tap, int *pos_advance)
     if (tap->version == 2) {
         uint32_t pulse_length2;
 
-        res = fread(&data, 1, 1, tap->fd);
+        res = tap_fread(tap, &data, 1, 1);
 
         if (res == 0) {
             return -1;
@@ -269,7 +378,7 @@ inline static int tap_get_pulse(tap_t *tap, int *pos_advance)
         *pos_advance += (int)res;
         if (data == 0) {
             uint8_t size[3];
-            res = fread(size, 3, 1, tap->fd);
+            res = tap_fread(tap, size, 3, 1);
             if (res == 0) {
                 return -1;
             }
@@ -382,7 +491,7 @@ static int tap_cbm_skip_pilot(tap_t *tap)
 
     errors = 0;
     counter = 0;
-    current_filepos = ftell(tap->fd);
+    current_filepos = tap_ftell(tap);
     while (1) {
         /*  Save file position */
         fpos = current_filepos;
@@ -391,7 +500,7 @@ static int tap_cbm_skip_pilot(tap_t *tap)
         fpos2 = current_filepos;
         if (TAP_PULSE_LONG(data)) {
             /* found an L pulse, try to read a byte */
-            fseek(tap->fd, fpos, SEEK_SET);
+            tap_fseek(tap, fpos, SEEK_SET);
             current_filepos = fpos;
             data = tap_cbm_read_byte(tap);
             if (data == -1) {
@@ -404,12 +513,12 @@ static int tap_cbm_skip_pilot(tap_t *tap)
                 }
 
                 /* Start over after the L pulse */
-                fseek(tap->fd, fpos2, SEEK_SET);
+                tap_fseek(tap, fpos2, SEEK_SET);
                 current_filepos = fpos2;
                 counter = 0;
             } else {
                 /* success.  Go back to start of byte and return */
-                fseek(tap->fd, fpos, SEEK_SET);
+                tap_fseek(tap, fpos, SEEK_SET);
                 current_filepos = fpos;
                 return 0;
             }
@@ -766,13 +875,13 @@ static int tap_cbm_skip_file(tap_t *tap)
         int ret;
 
         while (1) {
-            fpos = ftell(tap->fd);
+            fpos = tap_ftell(tap);
 
             /* find next pilot */
             ret = tap_find_pilot(tap, PILOT_TYPE_CBM);
             if (ret < 0) {
                 /* no more pilot found => end of data */
-                fseek(tap->fd, fpos, SEEK_SET);
+                tap_fseek(tap, fpos, SEEK_SET);
                 break;
             }
 
@@ -780,7 +889,7 @@ static int tap_cbm_skip_file(tap_t *tap)
             ret = tap_cbm_read_block(tap, buffer, 193);
             if (ret < 1 || buffer[0] != 2) {
                 /* next block is not a data continuation block => end of data */
-                fseek(tap->fd, fpos, SEEK_SET);
+                tap_fseek(tap, fpos, SEEK_SET);
                 break;
             }
         }
@@ -847,7 +956,7 @@ static int tap_tt_skip_pilot(tap_t *tap)
     int data;
 
 #if TAP_DEBUG > 1
-    log_debug("\nTAP_TT_SKIP_PILOT(0x%X", ftell(tap->fd));
+    log_debug("\nTAP_TT_SKIP_PILOT(0x%X", tap_ftell(tap));
 #endif
 
     /* turbo-tape pilot is just repeats of value 0x02 */
@@ -860,12 +969,12 @@ static int tap_tt_skip_pilot(tap_t *tap)
         if (data != 2) {
             /* value != 0x02, we found the end of the pilot.  Go back
                so byte can be read again */
-            fseek(tap->fd, -8, SEEK_CUR);
+            tap_fseek(tap, -8, SEEK_CUR);
         }
     } while (data == 2);
 
 #if TAP_DEBUG > 1
-    log_debug("-0x%X) ", ftell(tap->fd));
+    log_debug("-0x%X) ", tap_ftell(tap));
 #endif
 
     return 0;
@@ -1103,7 +1212,7 @@ static int tap_find_pilot(tap_t *tap, int type)
        file */
     minCBM = (type == PILOT_TYPE_ANY) ? 1000 : PILOT_MIN_LENGTH_CBM;
 
-    startCBM = ftell(tap->fd);
+    startCBM = tap_ftell(tap);
     startTT = startCBM;
     countCBM = 0;
     countTT = 0;
@@ -1114,8 +1223,8 @@ static int tap_find_pilot(tap_t *tap, int type)
 
     while ((countCBM < minCBM) && (countTT < PILOT_MIN_LENGTH_TT * 8)) {
 /*        count = fread(&data, 1, 256, tap->fd); */
-        int startpos = ftell(tap->fd);
-        int readlen = (int)fread(buffer, 1, 256, tap->fd);
+        int startpos = tap_ftell(tap);
+        int readlen = (int)tap_fread(tap, buffer, 1, 256);
         uint32_t pulse_length = 0;
         int j = 0;
         int needed;
@@ -1136,7 +1245,7 @@ static int tap_find_pilot(tap_t *tap, int type)
                         /* There is not enough in the buffer
                            Read some more */
                         memcpy(buffer, buffer + i + 1, still_in_buffer);
-                        res = (int)fread(buffer + still_in_buffer, 1, needed, tap->fd);
+                        res = (int)tap_fread(tap, buffer + still_in_buffer, 1, needed);
                         i = readlen;
                         if (res == 0) {
                             continue;
@@ -1154,7 +1263,7 @@ static int tap_find_pilot(tap_t *tap, int type)
                 uint32_t pulse_length2;
                 /*  Read one more byte if run out of buffer */
                 if (i == readlen) {
-                    readlen = (int)fread(buffer, 1, 1, tap->fd);
+                    readlen = (int)tap_fread(tap, buffer, 1, 1);
                     if (readlen == 0) {
                         continue;
                     }
@@ -1170,7 +1279,7 @@ static int tap_find_pilot(tap_t *tap, int type)
                         /* There is not enough in the buffer
                            Read some more */
                         memcpy(buffer, buffer + i + 1, still_in_buffer);
-                        res = (int)fread(buffer + still_in_buffer, 1, needed, tap->fd);
+                        res = (int)tap_fread(tap, buffer + still_in_buffer, 1, needed);
                         i = readlen;
                         if (res == 0) {
                             continue;
@@ -1186,7 +1295,7 @@ static int tap_find_pilot(tap_t *tap, int type)
             j++;
         }
         count = j;
-        pos[j] = ftell(tap->fd);
+        pos[j] = tap_ftell(tap);
 
 /*        for (i = 0, count = 0; i < 256; i++, count++) {
             pos[i] = ftell(tap->fd);
@@ -1254,10 +1363,10 @@ static int tap_find_pilot(tap_t *tap, int type)
         /* startTT points to a '1' bit which we assume to be part of the
            value 00000010.  Skip over the 1 and following 0 so we start
            at the beginning of a 00000010 sequence */
-        fseek(tap->fd, startTT + 2, SEEK_SET);
+        tap_fseek(tap, startTT + 2, SEEK_SET);
         return 1;
     } else {
-        fseek(tap->fd, startCBM, SEEK_SET);
+        tap_fseek(tap, startCBM, SEEK_SET);
         return 0;
     }
 }
@@ -1277,21 +1386,21 @@ static int tap_find_header(tap_t *tap)
         }
 
         /* store current position in TAP file */
-        fpos = ftell(tap->fd);
+        fpos = tap_ftell(tap);
 
         /* try to read a header */
         if (type == PILOT_TYPE_CBM) {
             res = tap_cbm_read_header(tap);
             if (res < 0) {
                 int pos_advance;
-                fseek(tap->fd, fpos, SEEK_SET);
+                tap_fseek(tap, fpos, SEEK_SET);
                 while (TAP_PULSE_SHORT(tap_get_pulse(tap, &pos_advance))) {
                 }
             }
         } else if (type == PILOT_TYPE_TT) {
             res = tap_tt_read_header(tap);
             if (res < 0) {
-                fseek(tap->fd, fpos, SEEK_SET);
+                tap_fseek(tap, fpos, SEEK_SET);
                 tap_tt_skip_pilot(tap);
             }
         } else {
@@ -1305,7 +1414,7 @@ static int tap_find_header(tap_t *tap)
             }
 
             /* success.  Rewind to start of header and return. */
-            fseek(tap->fd, fpos, SEEK_SET);
+            tap_fseek(tap, fpos, SEEK_SET);
             tap->current_file_seek_position = fpos;
             return type;
         }
@@ -1323,7 +1432,7 @@ static int tap_read_file(tap_t *tap)
 #endif
 
     /* store current position in TAP file */
-    fpos = ftell(tap->fd);
+    fpos = tap_ftell(tap);
 
     /* clear old file data */
     tap->current_file_size = 0;
@@ -1349,7 +1458,7 @@ static int tap_read_file(tap_t *tap)
     }
 
     /* go back to previous position in TAP file */
-    fseek(tap->fd, fpos, SEEK_SET);
+    tap_fseek(tap, fpos, SEEK_SET);
 
 #if TAP_DEBUG > 0
     log_debug("\nTAP_READ_FILE(END%i)\n", ret);
@@ -1407,13 +1516,34 @@ int tap_seek_start(tap_t *tap)
 
     tap->current_file_number = -1;
     tap->current_file_seek_position = 0;
-    fseek(tap->fd, tap->offset, SEEK_SET);
+    tap_fseek(tap, tap->offset, SEEK_SET);
     return 0;
 }
 
 int tap_seek_to_file(tap_t *tap, unsigned int file_number)
 {
+    struct tap_file_index_s *entry;
+
     tap_seek_start(tap);
+
+    if (tap->file_index_generation != tap_file_index_generation) {
+        tap->file_index_num = 0;
+    }
+
+    /* Go straight to the file, or to the last one found so far, instead of
+       searching from the start of the tape.  */
+    if (tap->file_index_num > 0) {
+        if ((int)file_number < tap->file_index_num) {
+            entry = &tap->file_index[file_number];
+        } else {
+            entry = &tap->file_index[tap->file_index_num - 1];
+        }
+        tap->current_file_number = (int)(entry - tap->file_index);
+        tap->current_file_seek_position = entry->pos;
+        tap_fseek(tap, entry->pos, SEEK_SET);
+        *tap->tap_file_record = entry->record;
+    }
+
     while ((int) file_number > tap->current_file_number) {
         if (tap_seek_to_next_file(tap, 0) < 0) {
             return -1;
@@ -1452,6 +1582,24 @@ int tap_seek_to_next_file(tap_t *tap, unsigned int allow_rewind)
     }
 
     tap->current_file_number++;
+
+    /* Remember where the file starts.  The file numbers always count from
+       the start of the tape, see tap_seek_start().  */
+    if (tap->file_index_generation != tap_file_index_generation) {
+        tap->file_index_num = 0;
+        tap->file_index_generation = tap_file_index_generation;
+    }
+    if (tap->current_file_number == tap->file_index_num) {
+        if (tap->file_index_num == tap->file_index_max) {
+            tap->file_index_max = tap->file_index_max ? tap->file_index_max * 2 : 16;
+            tap->file_index = lib_realloc(tap->file_index,
+                                          tap->file_index_max * sizeof(struct tap_file_index_s));
+        }
+        tap->file_index[tap->file_index_num].pos = tap->current_file_seek_position;
+        tap->file_index[tap->file_index_num].record = *tap->tap_file_record;
+        tap->file_index_num++;
+    }
+
     return 0;
 }
 
@@ -1506,4 +1654,6 @@ void tap_init(const tape_init_t *init)
     tap_pulse_middle_max = init->pulse_middle_max / 8;
     tap_pulse_long_min = init->pulse_long_min / 8;
     tap_pulse_long_max = init->pulse_long_max / 8;
+
+    tap_file_index_generation++;
 }
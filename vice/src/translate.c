@@ -105,16 +105,38 @@ static int language_cp_table[] = {
 
 /* --------------------------------------------------------------------- */
 
-static char *get_string_by_id(int id)
+/* The ids are consecutive, from ID_START_65536 up to ID_END, so the text
+   of every id is kept at its offset in `string_index'.  It is filled in
+   one pass over `string_table' on first use.  */
+static char *string_index[ID_END - ID_START_65536];
+static int string_index_done = 0;
+
+static void string_index_init(void)
 {
     unsigned int k;
-
-    for (k = 0; k < countof(string_table); k++) {
-        if (string_table[k].resource_id == id) {
-            return string_table[k].text;
+    int id;
+
+    /* Go backwards so the first entry of an id wins, as it did when the
+       table was searched.  */
+    for (k = countof(string_table); k-- > 0; ) {
+        id = string_table[k].resource_id;
+        if (id > ID_START_65536 && id < ID_END) {
+            string_index[id - ID_START_65536] = string_table[k].text;
         }
     }
-    return NULL;
+    string_index_done = 1;
+}
+
+static char *get_string_by_id(int id)
+{
+    if (!string_index_done) {
+        string_index_init();
+    }
+
+    if (id <= ID_START_65536 || id >= ID_END) {
+        return NULL;
+    }
+    return string_index[id - ID_START_65536];
 }
 
 static char *sid_return = NULL;
@@ -200,6 +222,12 @@ static char *translate_and_build_sid_cmdline_option(int en_resource)
 
 static char *text_table[countof(translate_text_table)][countof(language_table)];
 
+/* Both translate.h and `translate_text_table' are generated from
+   translate.txt: row `i' of the table holds the ids following
+   IDCLS_UNUSED + 1 + i * (number of languages), one per language.  */
+#define TRANSLATE_ROW(id) \
+    ((unsigned int)((id) - (IDCLS_UNUSED + 1)) / countof(language_table))
+
 static void translate_text_init(void)
 {
     unsigned int i, j;
@@ -242,16 +270,16 @@ char *translate_text(int en_resource)
 
     if (en_resource < 0x10000) {
         retval = intl_translate_text(en_resource);
-    } else {
-        for (i = 0; i < countof(translate_text_table); i++) {
-            if (translate_text_table[i][0] == en_resource) {
-                if (translate_text_table[i][current_language_index] != 0 &&
-                    text_table[i][current_language_index] != NULL &&
-                    strlen(text_table[i][current_language_index]) != 0) {
-                    retval = text_table[i][current_language_index];
-                } else {
-                    retval = text_table[i][0];
-                }
+    } else if (en_resource > IDCLS_UNUSED) {
+        i = TRANSLATE_ROW(en_resource);
+        if (i < countof(translate_text_table)
+            && translate_text_table[i][0] == en_resource) {
+            if (translate_text_table[i][current_language_index] != 0 &&
+                text_table[i][current_language_index] != NULL &&
+                strlen(text_table[i][current_language_index]) != 0) {
+                retval = text_table[i][current_language_index];
+            } else {
+                retval = text_table[i][0];
             }
         }
     }
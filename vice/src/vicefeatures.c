@@ -644,6 +644,13 @@ static feature_list_t featurelist[] = {
         1 },
 #endif
 #endif
+/* (all) */
+    { "USE_WORKER_THREADS", "Enable worker threads for drive, sound and video emulation.",
+#ifndef USE_WORKER_THREADS
+        0 },
+#else
+        1 },
+#endif
 #ifdef UNIX /* (unix) */
     { "USE_XAW3D", "Enable Xaw3d.",
 #ifndef USE_XAW3D
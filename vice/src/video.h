@@ -93,6 +93,9 @@ struct draw_buffer_s {
     unsigned int visible_width;
     /* Height of the visible subset of draw_buffer, in pixels */
     unsigned int visible_height;
+    /* Copy of draw_buffer the video worker thread renders from, NULL when
+       rendering from draw_buffer itself */
+    uint8_t *render_buffer;
 };
 typedef struct draw_buffer_s draw_buffer_t;
 
@@ -152,9 +155,20 @@ struct video_render_color_tables_s {
     /* YUV table for hardware rendering: (Y << 16) | (U << 8) | V */
     int yuv_updated;            /* yuv table updated for packed mode */
     uint32_t yuv_table[512];
+
+    /* Line buffers of the renderers; these have to stay last, as the
+       render threads only copy the tables before them (see
+       renderthread.c) */
     int32_t line_yuv_0[VIDEO_MAX_OUTPUT_WIDTH * 3];
     int16_t prevrgbline[VIDEO_MAX_OUTPUT_WIDTH * 3];
     uint8_t rgbscratchbuffer[VIDEO_MAX_OUTPUT_WIDTH * 4];
+
+    /* YUV of the current line and RGB of the previous one for the 32 bit
+       CRT and PAL renderers (see rendersimd.c) */
+    int32_t line_y[VIDEO_MAX_OUTPUT_WIDTH];
+    int32_t line_u[VIDEO_MAX_OUTPUT_WIDTH];
+    int32_t line_v[VIDEO_MAX_OUTPUT_WIDTH];
+    int32_t prevrgbline_32[3][VIDEO_MAX_OUTPUT_WIDTH];
 };
 typedef struct video_render_color_tables_s video_render_color_tables_t;
 
@@ -252,6 +266,33 @@ extern void video_viewport_title_set(struct video_canvas_s *canvas,
                                      const char *title);
 extern void video_viewport_title_free(struct viewport_s *viewport);
 
+/* Rendering on the video worker thread (`VideoWorkerThread').  */
+extern int videothread_enabled;
+extern int videothread_refresh(struct video_canvas_s *canvas, int all,
+                               unsigned int xs, unsigned int ys,
+                               unsigned int xi, unsigned int yi,
+                               unsigned int w, unsigned int h);
+extern int videothread_render(struct video_canvas_s *canvas, uint8_t *trg,
+                              int width, int height, int xs, int ys,
+                              int xt, int yt, int pitcht, int depth);
+extern void videothread_sync(void);
+extern void videothread_shutdown(void);
+
+/* Frames presented and dropped by the video worker thread since the
+   start, and the time from queuing to presenting them in milliseconds.  */
+typedef struct videothread_stats_s {
+    unsigned long presented;
+    unsigned long dropped;
+    double latency_average;
+    double latency_max;
+} videothread_stats_t;
+
+extern void videothread_get_stats(videothread_stats_t *stats);
+
+/* Number of threads rendering an area (`VideoRenderThreads').  */
+extern int renderthread_count;
+extern void renderthread_shutdown(void);
+
 typedef struct video_draw_buffer_callback_s {
     int (*draw_buffer_alloc)(struct video_canvas_s *canvas, uint8_t **draw_buffer,
                              unsigned int fb_width, unsigned int fb_height,
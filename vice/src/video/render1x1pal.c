@@ -26,7 +26,10 @@
 
 #include "vice.h"
 
+#include <stdio.h>
+
 #include "render1x1pal.h"
+#include "rendersimd.h"
 #include "types.h"
 #include "video-color.h"
 
@@ -87,22 +90,6 @@ void store_pixel_3(uint8_t *trg, int32_t y1, int32_t u1, int32_t v1, int32_t y2,
     trg[5] = (uint8_t) tmp;
 }
 
-static inline
-void store_pixel_4(uint8_t *trg, int32_t y1, int32_t u1, int32_t v1, int32_t y2, int32_t u2, int32_t v2)
-{
-    uint32_t *tmp;
-    int32_t red;
-    int32_t grn;
-    int32_t blu;
-
-    yuv_to_rgb(y1, u1, v1, &red, &grn, &blu);
-    tmp = (uint32_t *) trg;
-    tmp[0] = gamma_red[256 + red] | gamma_grn[256 + grn] | gamma_blu[256 + blu] | alpha;
-
-    yuv_to_rgb(y2, u2, v2, &red, &grn, &blu);
-    tmp[1] = gamma_red[256 + red] | gamma_grn[256 + grn] | gamma_blu[256 + blu] | alpha;
-}
-
 static inline
 void store_pixel_UYVY(uint8_t *trg, int32_t y1_, int32_t u1, int32_t v1, int32_t y2_, int32_t u2, int32_t v2)
 {
@@ -167,7 +154,7 @@ render_generic_1x1_pal(video_render_color_tables_t *color_tab, const uint8_t *sr
     const int32_t *ytableh = color_tab->ytableh;
     const uint8_t *tmpsrc;
     uint8_t *tmptrg;
-    unsigned int x, y;
+    unsigned int x, y, count;
     int32_t *line, l1, l2, u1, u2, v1, v2, unew, vnew;
     uint8_t cl0, cl1, cl2, cl3;
     int off, off_flip;
@@ -216,6 +203,7 @@ render_generic_1x1_pal(video_render_color_tables_t *color_tab, const uint8_t *sr
         tmptrg = trg;
 
         line = color_tab->line_yuv_0;
+        count = 0;
 
         if (y & 1) { /* odd sourceline */
             off_flip = off;
@@ -257,8 +245,16 @@ render_generic_1x1_pal(video_render_color_tables_t *color_tab, const uint8_t *sr
             line[1] = vnew;
             line += 2;
 
-            store_func(tmptrg, l1, u1, v1, l2, u2, v2);
-            tmptrg += pixelstride;
+            if (store_func == NULL) {
+                render_simd_put(color_tab, count++, l1, u1, v1);
+                render_simd_put(color_tab, count++, l2, u2, v2);
+            } else {
+                store_func(tmptrg, l1, u1, v1, l2, u2, v2);
+                tmptrg += pixelstride;
+            }
+        }
+        if (store_func == NULL) {
+            render_simd_line_32(color_tab, (uint32_t *)tmptrg, NULL, count);
         }
 
         src += pitchs;
@@ -341,5 +337,5 @@ render_32_1x1_pal(video_render_color_tables_t *color_tab,
 {
     render_generic_1x1_pal(color_tab, src, trg, width, height, xs, ys, xt, yt,
                            pitchs, pitcht,
-                           8, store_pixel_4, 0, config);
+                           8, NULL, 0, config);
 }
@@ -31,6 +31,7 @@
 
 #include "render1x2.h"
 #include "render1x2crt.h"
+#include "rendersimd.h"
 #include "types.h"
 #include "video-color.h"
 
@@ -60,7 +61,8 @@ void yuv_to_rgb(int32_t y, int32_t u, int32_t v, int16_t *red, int16_t *grn, int
 /* Often required function that stores gamma-corrected pixel to current line,
  * averages the current rgb with the contents of previous non-scanline-line,
  * stores the gamma-corrected scanline, and updates the prevline rgb buffer.
- * The variants 4, 3, 2 refer to pixel width of output. */
+ * The variants 3, 2 refer to pixel width of output, 32 bit output is done
+ * by render_simd_line_32(). */
 
 static inline
 void store_line_and_scanline_2(
@@ -151,43 +153,6 @@ void store_line_and_scanline_3(
     prevline[5] = blu;
 }
 
-static inline
-void store_line_and_scanline_4(
-    uint8_t *const line, uint8_t *const scanline,
-    int16_t *const prevline, const int shade, /* ignored by RGB modes */
-    const int32_t y, const int32_t u, const int32_t v, const int32_t y2, const int32_t u2, const int32_t v2)
-{
-    int16_t red, grn, blu;
-    uint32_t *tmp1, *tmp2;
-    yuv_to_rgb(y, u, v, &red, &grn, &blu);
-
-    tmp1 = (uint32_t *) scanline;
-    tmp2 = (uint32_t *) line;
-    *tmp1++ = gamma_red_fac[512 + red + prevline[0]]
-              | gamma_grn_fac[512 + grn + prevline[1]]
-              | gamma_blu_fac[512 + blu + prevline[2]]
-              | alpha;
-    *tmp2++ = gamma_red[256 + red] | gamma_grn[256 + grn] | gamma_blu[256 + blu]
-              | alpha;
-
-    prevline[0] = red;
-    prevline[1] = grn;
-    prevline[2] = blu;
-
-    yuv_to_rgb(y2, u2, v2, &red, &grn, &blu);
-
-    *tmp1 = gamma_red_fac[512 + red + prevline[3]]
-            | gamma_grn_fac[512 + grn + prevline[4]]
-            | gamma_blu_fac[512 + blu + prevline[5]]
-            | alpha;
-    *tmp2 = gamma_red[256 + red] | gamma_grn[256 + grn] | gamma_blu[256 + blu]
-            | alpha;
-
-    prevline[3] = red;
-    prevline[4] = grn;
-    prevline[5] = blu;
-}
-
 static inline
 void store_line_and_scanline_UYVY(
     uint8_t *const line, uint8_t *const scanline,
@@ -350,6 +315,7 @@ void render_generic_1x2_crt(video_render_color_tables_t *color_tab,
                             const int write_interpolated_pixels, video_render_config_t *config)
 {
     int16_t *prevrgblineptr;
+    unsigned int count;
     const int32_t *ytablel = color_tab->ytablel;
     const int32_t *ytableh = color_tab->ytableh;
     const uint8_t *tmpsrc;
@@ -427,6 +393,7 @@ void render_generic_1x2_crt(video_render_color_tables_t *color_tab,
 
         /* actual line */
         prevrgblineptr = &color_tab->prevrgbline[0];
+        count = 0;
         if (wfirst) {
             l2 = ytablel[tmpsrc[1]] + ytableh[tmpsrc[2]] + ytablel[tmpsrc[3]];
             unew += cbtable[tmpsrc[3]];
@@ -474,10 +441,15 @@ void render_generic_1x2_crt(video_render_color_tables_t *color_tab,
                 break;
             }
 #if 1
-            store_func(tmptrg, tmptrgscanline, prevrgblineptr, shade, l, u, v, l2, u2, v2);
-            tmptrgscanline += pixelstride * 2;
-            tmptrg += pixelstride * 2;
-            prevrgblineptr += 6;
+            if (store_func == NULL) {
+                render_simd_put(color_tab, count++, l, u, v);
+                render_simd_put(color_tab, count++, l2, u2, v2);
+            } else {
+                store_func(tmptrg, tmptrgscanline, prevrgblineptr, shade, l, u, v, l2, u2, v2);
+                tmptrgscanline += pixelstride * 2;
+                tmptrg += pixelstride * 2;
+                prevrgblineptr += 6;
+            }
 #endif
             l2 = ytablel[tmpsrc[1]] + ytableh[tmpsrc[2]] + ytablel[tmpsrc[3]];
             unew += cbtable[tmpsrc[3]];
@@ -492,7 +464,16 @@ void render_generic_1x2_crt(video_render_color_tables_t *color_tab,
             v = v2;
         }
         if (wlast) {
-            store_func(tmptrg, tmptrgscanline, prevrgblineptr, shade, l, u, v, l2, u2, v2);
+            if (store_func == NULL) {
+                render_simd_put(color_tab, count++, l, u, v);
+                render_simd_put(color_tab, count++, l2, u2, v2);
+            } else {
+                store_func(tmptrg, tmptrgscanline, prevrgblineptr, shade, l, u, v, l2, u2, v2);
+            }
+        }
+        if (store_func == NULL) {
+            render_simd_line_32(color_tab, (uint32_t *)tmptrg,
+                                (uint32_t *)tmptrgscanline, count);
         }
 
         src += pitchs;
@@ -575,5 +556,5 @@ void render_32_1x2_crt(video_render_color_tables_t *color_tab,
 {
     render_generic_1x2_crt(color_tab, src, trg, width, height, xs, ys,
                            xt, yt, pitchs, pitcht, viewport,
-                           4, store_line_and_scanline_4, 1, config);
+                           4, NULL, 1, config);
 }
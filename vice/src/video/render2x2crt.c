@@ -31,6 +31,7 @@
 
 #include "render2x2.h"
 #include "render2x2crt.h"
+#include "rendersimd.h"
 #include "types.h"
 #include "video-color.h"
 
@@ -60,7 +61,8 @@ void yuv_to_rgb(int32_t y, int32_t u, int32_t v, int16_t *red, int16_t *grn, int
 /* Often required function that stores gamma-corrected pixel to current line,
  * averages the current rgb with the contents of previous non-scanline-line,
  * stores the gamma-corrected scanline, and updates the prevline rgb buffer.
- * The variants 4, 3, 2 refer to pixel width of output. */
+ * The variants 3, 2 refer to pixel width of output, 32 bit output is done
+ * by render_simd_line_32(). */
 
 static inline
 void store_line_and_scanline_2(
@@ -117,30 +119,6 @@ void store_line_and_scanline_3(
     prevline[2] = blu;
 }
 
-static inline
-void store_line_and_scanline_4(
-    uint8_t *const line, uint8_t *const scanline,
-    int16_t *const prevline, const int shade, /* ignored by RGB modes */
-    const int32_t y, const int32_t u, const int32_t v)
-{
-    int16_t red, grn, blu;
-    uint32_t *tmp1, *tmp2;
-    yuv_to_rgb(y, u, v, &red, &grn, &blu);
-
-    tmp1 = (uint32_t *) scanline;
-    tmp2 = (uint32_t *) line;
-    *tmp1 = gamma_red_fac[512 + red + prevline[0]]
-            | gamma_grn_fac[512 + grn + prevline[1]]
-            | gamma_blu_fac[512 + blu + prevline[2]]
-            | alpha;
-    *tmp2 = gamma_red[256 + red] | gamma_grn[256 + grn] | gamma_blu[256 + blu]
-            | alpha;
-
-    prevline[0] = red;
-    prevline[1] = grn;
-    prevline[2] = blu;
-}
-
 static inline
 void store_line_and_scanline_UYVY(
     uint8_t *const line, uint8_t *const scanline,
@@ -281,6 +259,7 @@ void render_generic_2x2_crt(video_render_color_tables_t *color_tab,
                             const int write_interpolated_pixels, video_render_config_t *config)
 {
     int16_t *prevrgblineptr;
+    unsigned int count;
     const int32_t *ytablel = color_tab->ytablel;
     const int32_t *ytableh = color_tab->ytableh;
     const uint8_t *tmpsrc;
@@ -355,6 +334,7 @@ void render_generic_2x2_crt(video_render_color_tables_t *color_tab,
 
         /* actual line */
         prevrgblineptr = &color_tab->prevrgbline[0];
+        count = 0;
         if (wfirst) {
             l2 = ytablel[tmpsrc[1]] + ytableh[tmpsrc[2]] + ytablel[tmpsrc[3]];
             unew += cbtable[tmpsrc[3]];
@@ -365,10 +345,14 @@ void render_generic_2x2_crt(video_render_color_tables_t *color_tab,
             tmpsrc += 1;
 #if 1
             if (write_interpolated_pixels) {
-                store_func(tmptrg, tmptrgscanline, prevrgblineptr, shade, (l + l2) >> 1, (u + u2) >> 1, (v + v2) >> 1);
-                tmptrgscanline += pixelstride;
-                tmptrg += pixelstride;
-                prevrgblineptr += 3;
+                if (store_func == NULL) {
+                    render_simd_put(color_tab, count++, (l + l2) >> 1, (u + u2) >> 1, (v + v2) >> 1);
+                } else {
+                    store_func(tmptrg, tmptrgscanline, prevrgblineptr, shade, (l + l2) >> 1, (u + u2) >> 1, (v + v2) >> 1);
+                    tmptrgscanline += pixelstride;
+                    tmptrg += pixelstride;
+                    prevrgblineptr += 3;
+                }
             }
 #endif
             l = l2;
@@ -377,10 +361,14 @@ void render_generic_2x2_crt(video_render_color_tables_t *color_tab,
         }
         for (x = 0; x < width; x++) {
 #if 1
-            store_func(tmptrg, tmptrgscanline, prevrgblineptr, shade, l, u, v);
-            tmptrgscanline += pixelstride;
-            tmptrg += pixelstride;
-            prevrgblineptr += 3;
+            if (store_func == NULL) {
+                render_simd_put(color_tab, count++, l, u, v);
+            } else {
+                store_func(tmptrg, tmptrgscanline, prevrgblineptr, shade, l, u, v);
+                tmptrgscanline += pixelstride;
+                tmptrg += pixelstride;
+                prevrgblineptr += 3;
+            }
 #endif
             l2 = ytablel[tmpsrc[1]] + ytableh[tmpsrc[2]] + ytablel[tmpsrc[3]];
             unew += cbtable[tmpsrc[3]];
@@ -391,10 +379,14 @@ void render_generic_2x2_crt(video_render_color_tables_t *color_tab,
             tmpsrc += 1;
 #if 1
             if (write_interpolated_pixels) {
-                store_func(tmptrg, tmptrgscanline, prevrgblineptr, shade, (l + l2) >> 1, (u + u2) >> 1, (v + v2) >> 1);
-                tmptrgscanline += pixelstride;
-                tmptrg += pixelstride;
-                prevrgblineptr += 3;
+                if (store_func == NULL) {
+                    render_simd_put(color_tab, count++, (l + l2) >> 1, (u + u2) >> 1, (v + v2) >> 1);
+                } else {
+                    store_func(tmptrg, tmptrgscanline, prevrgblineptr, shade, (l + l2) >> 1, (u + u2) >> 1, (v + v2) >> 1);
+                    tmptrgscanline += pixelstride;
+                    tmptrg += pixelstride;
+                    prevrgblineptr += 3;
+                }
             }
 #endif
             l = l2;
@@ -402,7 +394,15 @@ void render_generic_2x2_crt(video_render_color_tables_t *color_tab,
             v = v2;
         }
         if (wlast) {
-            store_func(tmptrg, tmptrgscanline, prevrgblineptr, shade, l, u, v);
+            if (store_func == NULL) {
+                render_simd_put(color_tab, count++, l, u, v);
+            } else {
+                store_func(tmptrg, tmptrgscanline, prevrgblineptr, shade, l, u, v);
+            }
+        }
+        if (store_func == NULL) {
+            render_simd_line_32(color_tab, (uint32_t *)tmptrg,
+                                (uint32_t *)tmptrgscanline, count);
         }
 
         src += pitchs;
@@ -485,5 +485,5 @@ void render_32_2x2_crt(video_render_color_tables_t *color_tab,
 {
     render_generic_2x2_crt(color_tab, src, trg, width, height, xs, ys,
                            xt, yt, pitchs, pitcht, viewport,
-                           4, store_line_and_scanline_4, 1, config);
+                           4, NULL, 1, config);
 }
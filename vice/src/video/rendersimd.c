@@ -0,0 +1,172 @@
+/*
+ * rendersimd.c - 32 bit line kernels for the CRT and PAL renderers.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/* The 32 bit CRT and PAL renderers first calculate the YUV values of a
+   whole line, and then convert them to gamma corrected RGB (and the
+   scanline in between) here, where the pixels do not depend on each other.
+   On x86 CPUs with AVX2 a version that converts and looks up 8 pixels at a
+   time is picked at runtime; it gives exactly the same output as the plain
+   C one, which `make check' verifies (rendersimdtest.c).  Without a gather
+   instruction (SSE2) most of the work is the table lookups, and a vector
+   version is not faster than the C one.  */
+
+#include "vice.h"
+
+#include <stdio.h>
+
+#include "rendersimd.h"
+#include "types.h"
+#include "video-color.h"
+#include "video.h"
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__)) \
+    && (__GNUC__ >= 5 || defined(__clang__))
+#define RENDER_SIMD_X86
+#include <immintrin.h>
+#endif
+
+void (*render_simd_line_32)(video_render_color_tables_t *color_tab,
+                            uint32_t *line, uint32_t *scanline,
+                            unsigned int count);
+
+static inline
+void render_pixel_32(video_render_color_tables_t *color_tab,
+                     uint32_t *line, uint32_t *scanline, unsigned int i)
+{
+    int32_t y = color_tab->line_y[i];
+    int32_t u = color_tab->line_u[i];
+    int32_t v = color_tab->line_v[i];
+    int16_t red, grn, blu;
+
+#ifdef _MSC_VER
+# pragma warning( push )
+# pragma warning( disable: 4244 )
+#endif
+
+    red = (y + v) >> 16;
+    blu = (y + u) >> 16;
+    grn = (y - ((50 * u + 130 * v) >> 8)) >> 16;
+
+#ifdef _MSC_VER
+# pragma warning( pop )
+#endif
+
+    if (scanline != NULL) {
+        scanline[i] = gamma_red_fac[512 + red + color_tab->prevrgbline_32[0][i]]
+                      | gamma_grn_fac[512 + grn + color_tab->prevrgbline_32[1][i]]
+                      | gamma_blu_fac[512 + blu + color_tab->prevrgbline_32[2][i]]
+                      | alpha;
+        color_tab->prevrgbline_32[0][i] = red;
+        color_tab->prevrgbline_32[1][i] = grn;
+        color_tab->prevrgbline_32[2][i] = blu;
+    }
+    line[i] = gamma_red[256 + red] | gamma_grn[256 + grn] | gamma_blu[256 + blu]
+              | alpha;
+}
+
+static void render_line_32(video_render_color_tables_t *color_tab,
+                           uint32_t *line, uint32_t *scanline,
+                           unsigned int count)
+{
+    unsigned int i;
+
+    for (i = 0; i < count; i++) {
+        render_pixel_32(color_tab, line, scanline, i);
+    }
+}
+
+#ifdef RENDER_SIMD_X86
+
+__attribute__((target("avx2")))
+static void render_line_32_avx2(video_render_color_tables_t *color_tab,
+                                uint32_t *line, uint32_t *scanline,
+                                unsigned int count)
+{
+    const __m256i off_line = _mm256_set1_epi32(256);
+    const __m256i off_scanline = _mm256_set1_epi32(512);
+    const __m256i a = _mm256_set1_epi32((int)alpha);
+    unsigned int i;
+
+    for (i = 0; i + 8 <= count; i += 8) {
+        __m256i y = _mm256_loadu_si256((const __m256i *)&color_tab->line_y[i]);
+        __m256i u = _mm256_loadu_si256((const __m256i *)&color_tab->line_u[i]);
+        __m256i v = _mm256_loadu_si256((const __m256i *)&color_tab->line_v[i]);
+        __m256i uv, red, grn, blu, pixel;
+
+        uv = _mm256_add_epi32(_mm256_mullo_epi32(u, _mm256_set1_epi32(50)),
+                              _mm256_mullo_epi32(v, _mm256_set1_epi32(130)));
+
+        red = _mm256_srai_epi32(_mm256_add_epi32(y, v), 16);
+        blu = _mm256_srai_epi32(_mm256_add_epi32(y, u), 16);
+        grn = _mm256_srai_epi32(_mm256_sub_epi32(y, _mm256_srai_epi32(uv, 8)), 16);
+
+        /* truncate to 16 bit like the C version */
+        red = _mm256_srai_epi32(_mm256_slli_epi32(red, 16), 16);
+        grn = _mm256_srai_epi32(_mm256_slli_epi32(grn, 16), 16);
+        blu = _mm256_srai_epi32(_mm256_slli_epi32(blu, 16), 16);
+
+        if (scanline != NULL) {
+            __m256i *prev0 = (__m256i *)&color_tab->prevrgbline_32[0][i];
+            __m256i *prev1 = (__m256i *)&color_tab->prevrgbline_32[1][i];
+            __m256i *prev2 = (__m256i *)&color_tab->prevrgbline_32[2][i];
+
+            pixel = _mm256_i32gather_epi32((const int *)gamma_red_fac,
+                                           _mm256_add_epi32(_mm256_add_epi32(red, _mm256_loadu_si256(prev0)), off_scanline), 4);
+            pixel = _mm256_or_si256(pixel, _mm256_i32gather_epi32((const int *)gamma_grn_fac,
+                                           _mm256_add_epi32(_mm256_add_epi32(grn, _mm256_loadu_si256(prev1)), off_scanline), 4));
+            pixel = _mm256_or_si256(pixel, _mm256_i32gather_epi32((const int *)gamma_blu_fac,
+                                           _mm256_add_epi32(_mm256_add_epi32(blu, _mm256_loadu_si256(prev2)), off_scanline), 4));
+            _mm256_storeu_si256((__m256i *)&scanline[i], _mm256_or_si256(pixel, a));
+
+            _mm256_storeu_si256(prev0, red);
+            _mm256_storeu_si256(prev1, grn);
+            _mm256_storeu_si256(prev2, blu);
+        }
+
+        pixel = _mm256_i32gather_epi32((const int *)gamma_red,
+                                       _mm256_add_epi32(red, off_line), 4);
+        pixel = _mm256_or_si256(pixel, _mm256_i32gather_epi32((const int *)gamma_grn,
+                                       _mm256_add_epi32(grn, off_line), 4));
+        pixel = _mm256_or_si256(pixel, _mm256_i32gather_epi32((const int *)gamma_blu,
+                                       _mm256_add_epi32(blu, off_line), 4));
+        _mm256_storeu_si256((__m256i *)&line[i], _mm256_or_si256(pixel, a));
+    }
+
+    for (; i < count; i++) {
+        render_pixel_32(color_tab, line, scanline, i);
+    }
+}
+
+#endif
+
+void render_simd_init(void)
+{
+    render_simd_line_32 = render_line_32;
+
+#ifdef RENDER_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        render_simd_line_32 = render_line_32_avx2;
+    }
+#endif
+}
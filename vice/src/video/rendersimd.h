@@ -0,0 +1,50 @@
+/*
+ * rendersimd.h - 32 bit line kernels for the CRT and PAL renderers.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#ifndef VICE_RENDERSIMD_H
+#define VICE_RENDERSIMD_H
+
+#include "types.h"
+#include "video.h"
+
+/* Remember the YUV value of pixel `i' of the current line.  */
+static inline
+void render_simd_put(video_render_color_tables_t *color_tab, unsigned int i,
+                     int32_t y, int32_t u, int32_t v)
+{
+    color_tab->line_y[i] = y;
+    color_tab->line_u[i] = u;
+    color_tab->line_v[i] = v;
+}
+
+/* Convert the first `count' pixels put with render_simd_put() to RGB and
+   write them to `line'.  If `scanline' is not NULL, also write the gamma
+   corrected average with the RGB of the line before to it, and remember
+   the RGB for the next line.  */
+extern void (*render_simd_line_32)(video_render_color_tables_t *color_tab,
+                                   uint32_t *line, uint32_t *scanline,
+                                   unsigned int count);
+
+extern void render_simd_init(void);
+
+#endif
@@ -0,0 +1,167 @@
+/*
+ * rendersimdtest.c - Compare the line kernels of rendersimd.c.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/* Run by `make check'.  Renders random lines with the vector kernels and
+   with the C one, and fails if the lines, the scanlines or the remembered
+   RGB of the previous line differ in any byte.  The kernels are static,
+   so rendersimd.c is included here.  Exits with 77 (skipped) if the CPU
+   has no vector kernel.  */
+
+#include "rendersimd.c"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define RENDERSIMDTEST_LINES  2000
+
+uint32_t gamma_red[256 * 3];
+uint32_t gamma_grn[256 * 3];
+uint32_t gamma_blu[256 * 3];
+uint32_t gamma_red_fac[256 * 3 * 2];
+uint32_t gamma_grn_fac[256 * 3 * 2];
+uint32_t gamma_blu_fac[256 * 3 * 2];
+uint32_t alpha = 0;
+
+static uint32_t seed = 1;
+
+/* Fixed sequence, so a failure can be reproduced.  */
+static uint32_t test_random(void)
+{
+    seed = seed * 1103515245 + 12345;
+    return seed >> 8;
+}
+
+/* Random value in [min, max].  */
+static int32_t test_random_range(int32_t min, int32_t max)
+{
+    return min + (int32_t)(test_random() % (uint32_t)(max - min + 1));
+}
+
+static void test_fill(uint32_t *table, unsigned int size)
+{
+    unsigned int i;
+
+    for (i = 0; i < size; i++) {
+        table[i] = test_random();
+    }
+}
+
+/* Put a random line into both color tables.  The ranges keep all table
+   indices of the kernels within bounds.  */
+static void test_put_line(video_render_color_tables_t *a,
+                          video_render_color_tables_t *b, unsigned int count)
+{
+    unsigned int i;
+    int32_t y, u, v;
+
+    for (i = 0; i < count; i++) {
+        y = test_random_range(0, 255 << 16);
+        u = test_random_range(-(100 << 16), 100 << 16);
+        v = test_random_range(-(100 << 16), 100 << 16);
+        render_simd_put(a, i, y, u, v);
+        render_simd_put(b, i, y, u, v);
+    }
+}
+
+static int test_kernel(const char *name,
+                       void (*kernel)(video_render_color_tables_t *,
+                                      uint32_t *, uint32_t *, unsigned int))
+{
+    video_render_color_tables_t *ref, *tab;
+    uint32_t *ref_line, *ref_scanline, *line, *scanline;
+    unsigned int n, count, with_scanline;
+    size_t size = VIDEO_MAX_OUTPUT_WIDTH * sizeof(uint32_t);
+    int failed = 0;
+
+    ref = calloc(1, sizeof(video_render_color_tables_t));
+    tab = calloc(1, sizeof(video_render_color_tables_t));
+    ref_line = calloc(1, size);
+    ref_scanline = calloc(1, size);
+    line = calloc(1, size);
+    scanline = calloc(1, size);
+
+    for (n = 0; n < RENDERSIMDTEST_LINES && !failed; n++) {
+        /* all counts up to some vectors, then random ones */
+        count = n < 64 ? n : (unsigned int)test_random_range(0, VIDEO_MAX_OUTPUT_WIDTH);
+        with_scanline = test_random() & 1;
+        alpha = (test_random() & 1) ? 0xff000000 : 0;
+
+        test_put_line(ref, tab, count);
+        memset(ref_line, 0x55, size);
+        memset(line, 0x55, size);
+        memset(ref_scanline, 0xaa, size);
+        memset(scanline, 0xaa, size);
+
+        render_line_32(ref, ref_line, with_scanline ? ref_scanline : NULL, count);
+        kernel(tab, line, with_scanline ? scanline : NULL, count);
+
+        if (memcmp(ref_line, line, size) != 0
+            || memcmp(ref_scanline, scanline, size) != 0
+            || memcmp(ref->prevrgbline_32, tab->prevrgbline_32,
+                      sizeof(ref->prevrgbline_32)) != 0) {
+            printf("%s: line %u (%u pixels%s) differs from the C kernel.\n",
+                   name, n, count, with_scanline ? ", with scanline" : "");
+            failed = 1;
+        }
+    }
+
+    if (!failed) {
+        printf("%s: %u lines match the C kernel.\n", name, n);
+    }
+
+    free(ref);
+    free(tab);
+    free(ref_line);
+    free(ref_scanline);
+    free(line);
+    free(scanline);
+
+    return failed;
+}
+
+int main(void)
+{
+    int tested = 0, failed = 0;
+
+    test_fill(gamma_red, 256 * 3);
+    test_fill(gamma_grn, 256 * 3);
+    test_fill(gamma_blu, 256 * 3);
+    test_fill(gamma_red_fac, 256 * 3 * 2);
+    test_fill(gamma_grn_fac, 256 * 3 * 2);
+    test_fill(gamma_blu_fac, 256 * 3 * 2);
+
+#ifdef RENDER_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        failed |= test_kernel("avx2", render_line_32_avx2);
+        tested = 1;
+    }
+#endif
+
+    if (!tested) {
+        printf("No vector kernel for this CPU.\n");
+        return 77;
+    }
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
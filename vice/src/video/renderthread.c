@@ -0,0 +1,309 @@
+/*
+ * renderthread.c - Render horizontal stripes of the screen on worker threads.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/* With `VideoRenderThreads' > 1, a large update area is split up into
+   horizontal stripes, one per thread, which are rendered at the same time;
+   the calling thread renders the first one itself.  Every renderer
+   initializes its delay line from the source line above its area and
+   writes the scanline below it, so the stripes give the same output as
+   one call for the whole area, as long as a stripe starts at a source
+   line.  The stripes are made a multiple of 8 lines high, as the 2x4
+   renderers take the phase of their 4 line pattern from twice the source
+   line.  Each worker renders with its own copy of the render config, so
+   that the line buffers in the color tables are not shared.  */
+
+#include "vice.h"
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "lib.h"
+#include "log.h"
+#include "types.h"
+#include "video-render.h"
+#include "video.h"
+#include "viewport.h"
+
+#ifdef USE_WORKER_THREADS
+#include <pthread.h>
+#endif
+
+int renderthread_count = 1;
+
+#ifdef USE_WORKER_THREADS
+
+/* Stripes are at least this many target lines high, and a multiple of
+   RENDERTHREAD_ALIGN lines.  */
+#define RENDERTHREAD_MIN_LINES  32
+#define RENDERTHREAD_ALIGN      8
+
+typedef struct renderthread_s {
+    pthread_t thread;
+    int created;
+
+    video_render_config_t *config;
+
+    /* Job number this thread has last picked up.  */
+    unsigned int job;
+
+    /* Stripe to render.  */
+    int height;
+    int ys;
+    int yt;
+} renderthread_t;
+
+static renderthread_t threads[RENDERTHREAD_MAX];
+
+/* Parameters of the current job.  */
+static renderthread_func_t job_func;
+static uint8_t *job_src;
+static uint8_t *job_trg;
+static int job_width;
+static int job_xs;
+static int job_xt;
+static int job_pitchs;
+static int job_pitcht;
+static int job_depth;
+static viewport_t *job_viewport;
+static int job_stripes;
+static unsigned int job_count = 0;
+static int job_busy = 0;
+
+static pthread_mutex_t renderthread_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t renderthread_cond = PTHREAD_COND_INITIALIZER;
+
+/* Held while a job is set up and rendered, the video worker thread and the
+   main thread can both render.  */
+static pthread_mutex_t renderthread_busy = PTHREAD_MUTEX_INITIALIZER;
+static int quit = 0;
+
+static log_t renderthread_log = LOG_ERR;
+
+static void *renderthread_main(void *arg)
+{
+    unsigned int i = vice_ptr_to_uint(arg);
+    renderthread_t *t = &threads[i];
+
+    pthread_mutex_lock(&renderthread_lock);
+
+    for (;;) {
+        while (!quit && t->job == job_count) {
+            pthread_cond_wait(&renderthread_cond, &renderthread_lock);
+        }
+        if (quit) {
+            break;
+        }
+        t->job = job_count;
+
+        if (i >= (unsigned int)job_stripes) {
+            continue;
+        }
+
+        pthread_mutex_unlock(&renderthread_lock);
+        job_func(t->config, job_src, job_trg, job_width, t->height,
+                 job_xs, t->ys, job_xt, t->yt, job_pitchs, job_pitcht,
+                 job_depth, job_viewport);
+        pthread_mutex_lock(&renderthread_lock);
+
+        if (--job_busy == 0) {
+            pthread_cond_broadcast(&renderthread_cond);
+        }
+    }
+
+    pthread_mutex_unlock(&renderthread_lock);
+
+    return NULL;
+}
+
+static int renderthread_create(unsigned int i)
+{
+    renderthread_t *t = &threads[i];
+
+    if (t->created) {
+        return 0;
+    }
+
+    if (renderthread_log == LOG_ERR) {
+        renderthread_log = log_open("RenderThread");
+    }
+
+    if (t->config == NULL) {
+        t->config = lib_calloc(1, sizeof(video_render_config_t));
+    }
+    t->job = job_count;
+
+    if (pthread_create(&t->thread, NULL, renderthread_main,
+                       uint_to_void_ptr(i)) != 0) {
+        log_error(renderthread_log, "Cannot create render thread #%u.", i);
+        return -1;
+    }
+    t->created = 1;
+
+    return 0;
+}
+
+/* Vertical scale factor of the renderers for `rendermode', 0 if it is
+   not rendered by video_render_main().  */
+static int renderthread_scale(int rendermode)
+{
+    switch (rendermode) {
+        case VIDEO_RENDER_PAL_1X1:
+        case VIDEO_RENDER_RGB_1X1:
+        case VIDEO_RENDER_CRT_1X1:
+            return 1;
+        case VIDEO_RENDER_RGB_1X2:
+        case VIDEO_RENDER_RGB_2X2:
+        case VIDEO_RENDER_PAL_2X2:
+        case VIDEO_RENDER_CRT_1X2:
+        case VIDEO_RENDER_CRT_2X2:
+            return 2;
+        case VIDEO_RENDER_CRT_2X4:
+            return 4;
+    }
+    return 0;
+}
+
+/* Render the area with `func', split up into stripes rendered at the same
+   time.  Return -1 if the area is not split, and the caller has to render
+   it itself; this is also the case if the threads are busy with another
+   area.  */
+int renderthread_render(renderthread_func_t func,
+                        video_render_config_t *config, uint8_t *src,
+                        uint8_t *trg, int width, int height, int xs, int ys,
+                        int xt, int yt, int pitchs, int pitcht, int depth,
+                        viewport_t *viewport)
+{
+    int scale, stripes, stripe_height, i;
+
+    if (renderthread_count < 2) {
+        return -1;
+    }
+
+    scale = renderthread_scale(config->rendermode);
+    if (scale == 0) {
+        return -1;
+    }
+
+    stripes = height / RENDERTHREAD_MIN_LINES;
+    if (stripes > renderthread_count) {
+        stripes = renderthread_count;
+    }
+    if (stripes < 2) {
+        return -1;
+    }
+
+    stripe_height = (height + stripes - 1) / stripes;
+    stripe_height = (stripe_height + RENDERTHREAD_ALIGN - 1)
+                    / RENDERTHREAD_ALIGN * RENDERTHREAD_ALIGN;
+
+    if (pthread_mutex_trylock(&renderthread_busy) != 0) {
+        return -1;
+    }
+
+    for (i = 1; i < stripes; i++) {
+        if (i * stripe_height >= height || renderthread_create(i) < 0) {
+            break;
+        }
+        threads[i].height = height - i * stripe_height;
+        if (threads[i].height > stripe_height) {
+            threads[i].height = stripe_height;
+        }
+        threads[i].ys = ys + i * stripe_height / scale;
+        threads[i].yt = yt + i * stripe_height;
+        memcpy(threads[i].config, config, VIDEO_RENDER_CONFIG_TABLES_SIZE);
+    }
+    stripes = i;
+    if (stripes < 2) {
+        pthread_mutex_unlock(&renderthread_busy);
+        return -1;
+    }
+
+    pthread_mutex_lock(&renderthread_lock);
+    job_func = func;
+    job_src = src;
+    job_trg = trg;
+    job_width = width;
+    job_xs = xs;
+    job_xt = xt;
+    job_pitchs = pitchs;
+    job_pitcht = pitcht;
+    job_depth = depth;
+    job_viewport = viewport;
+    job_stripes = stripes;
+    job_busy = stripes - 1;
+    job_count++;
+    pthread_cond_broadcast(&renderthread_cond);
+    pthread_mutex_unlock(&renderthread_lock);
+
+    func(config, src, trg, width, stripe_height, xs, ys, xt, yt, pitchs,
+         pitcht, depth, viewport);
+
+    pthread_mutex_lock(&renderthread_lock);
+    while (job_busy > 0) {
+        pthread_cond_wait(&renderthread_cond, &renderthread_lock);
+    }
+    pthread_mutex_unlock(&renderthread_lock);
+
+    pthread_mutex_unlock(&renderthread_busy);
+
+    return 0;
+}
+
+void renderthread_shutdown(void)
+{
+    int i;
+
+    pthread_mutex_lock(&renderthread_lock);
+    quit = 1;
+    pthread_cond_broadcast(&renderthread_cond);
+    pthread_mutex_unlock(&renderthread_lock);
+
+    for (i = 0; i < RENDERTHREAD_MAX; i++) {
+        if (threads[i].created) {
+            pthread_join(threads[i].thread, NULL);
+            threads[i].created = 0;
+        }
+        lib_free(threads[i].config);
+        threads[i].config = NULL;
+    }
+
+    quit = 0;
+}
+
+#else
+
+int renderthread_render(renderthread_func_t func,
+                        video_render_config_t *config, uint8_t *src,
+                        uint8_t *trg, int width, int height, int xs, int ys,
+                        int xt, int yt, int pitchs, int pitcht, int depth,
+                        viewport_t *viewport)
+{
+    return -1;
+}
+
+void renderthread_shutdown(void)
+{
+}
+
+#endif
@@ -86,27 +86,44 @@ void video_canvas_shutdown(video_canvas_t *canvas)
     }
 }
 
+static int lastmode = -1;
+
+/* Bring the color tables of `canvas' up to date.  */
+void video_canvas_update_colors(video_canvas_t *canvas)
+{
+    /* when the color encoding changed, the palette must be recalculated */
+    if (canvas->viewport->crt_type != lastmode) {
+        canvas->videoconfig->color_tables.updated = 0;
+        lastmode = canvas->viewport->crt_type;
+    }
+
+    if (!canvas->videoconfig->color_tables.updated) { /* update colors as necessary */
+        video_color_update_palette(canvas);
+    }
+}
+
 void video_canvas_render(video_canvas_t *canvas, uint8_t *trg, int width,
                          int height, int xs, int ys, int xt, int yt,
                          int pitcht, int depth)
 {
-    static int lastmode = -1;
     viewport_t *viewport = canvas->viewport;
 #ifdef VIDEO_SCALE_SOURCE
     xs /= canvas->videoconfig->scalex;
     ys /= canvas->videoconfig->scaley;
 #endif
 
-    /* when the color encoding changed, the palette must be recalculated */
-    if (viewport->crt_type != lastmode) {
-        canvas->videoconfig->color_tables.updated = 0;
-        lastmode = viewport->crt_type;
-    }
+    video_canvas_update_colors(canvas);
 
-    if (!canvas->videoconfig->color_tables.updated) { /* update colors as necessary */
-        video_color_update_palette(canvas);
+    /* the video worker thread may have rendered it already */
+    if (videothread_render(canvas, trg, width, height, xs, ys, xt, yt,
+                           pitcht, depth) == 0) {
+        return;
     }
-    video_render_main(canvas->videoconfig, canvas->draw_buffer->draw_buffer,
+
+    video_render_main(canvas->videoconfig,
+                      canvas->draw_buffer->render_buffer != NULL
+                      ? canvas->draw_buffer->render_buffer
+                      : canvas->draw_buffer->draw_buffer,
                       trg, width, height, xs, ys, xt, yt,
                       canvas->draw_buffer->draw_buffer_width, pitcht, depth,
                       viewport);
@@ -121,6 +138,8 @@ void video_canvas_refresh_all(video_canvas_t *canvas)
         return;
     }
 
+    videothread_sync();
+
     viewport = canvas->viewport;
     geometry = canvas->geometry;
 
@@ -145,6 +164,8 @@ int video_canvas_palette_set(struct video_canvas_s *canvas,
         return 0;
     }
 
+    videothread_sync();
+
     old_palette = canvas->palette;
 
     if (canvas->created) {
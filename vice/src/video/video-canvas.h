@@ -31,5 +31,6 @@ struct video_canvas_s;
 struct palette_s;
 
 extern int video_canvas_palette_set(struct video_canvas_s *canvas, struct palette_s *palette);
+extern void video_canvas_update_colors(struct video_canvas_s *canvas);
 
 #endif
@@ -53,6 +53,27 @@ static cmdline_option_t cmdline_options[] = {
 };
 #endif
 
+#ifdef USE_WORKER_THREADS
+static cmdline_option_t cmdline_options_worker_thread[] = {
+    { "-videoworkerthread", SET_RESOURCE, 0,
+      NULL, NULL, "VideoWorkerThread", (resource_value_t)1,
+      USE_PARAM_STRING, USE_DESCRIPTION_STRING,
+      IDCLS_UNUSED, IDCLS_UNUSED,
+      NULL, "Render the frames on a worker thread" },
+    { "+videoworkerthread", SET_RESOURCE, 0,
+      NULL, NULL, "VideoWorkerThread", (resource_value_t)0,
+      USE_PARAM_STRING, USE_DESCRIPTION_STRING,
+      IDCLS_UNUSED, IDCLS_UNUSED,
+      NULL, "Render the frames on the emulation thread" },
+    { "-videorenderthreads", SET_RESOURCE, 1,
+      NULL, NULL, "VideoRenderThreads", NULL,
+      USE_PARAM_STRING, USE_DESCRIPTION_STRING,
+      IDCLS_UNUSED, IDCLS_UNUSED,
+      "<number>", "Number of threads rendering a frame together (1: no extra threads)" },
+    CMDLINE_LIST_END
+};
+#endif
+
 int video_cmdline_options_init(void)
 {
 #ifdef HAVE_HWSCALE
@@ -61,6 +82,13 @@ int video_cmdline_options_init(void)
             return -1;
         }
     }
+#endif
+#ifdef USE_WORKER_THREADS
+    if (machine_class != VICE_MACHINE_VSID) {
+        if (cmdline_register_options(cmdline_options_worker_thread) < 0) {
+            return -1;
+        }
+    }
 #endif
     return video_arch_cmdline_options_init();
 }
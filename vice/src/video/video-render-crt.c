@@ -46,6 +46,7 @@
 #include "render2x4.h"
 #include "render2x4crt.h"
 #include "renderscale2x.h"
+#include "rendersimd.h"
 #include "resources.h"
 #include "types.h"
 #include "video-render.h"
@@ -262,5 +263,6 @@ static void video_render_crt_main(video_render_config_t *config,
 
 void video_render_crt_init(void)
 {
+    render_simd_init();
     video_render_crtfunc_set(video_render_crt_main);
 }
@@ -98,24 +98,15 @@ void video_render_setphysicalcolor(video_render_config_t *config, int index,
 
 static int rendermode_error = -1;
 
-void video_render_main(video_render_config_t *config, uint8_t *src, uint8_t *trg,
-                       int width, int height, int xs, int ys, int xt, int yt,
-                       int pitchs, int pitcht, int depth, viewport_t *viewport)
+static void video_render_area(video_render_config_t *config, uint8_t *src,
+                              uint8_t *trg, int width, int height,
+                              int xs, int ys, int xt, int yt,
+                              int pitchs, int pitcht, int depth,
+                              viewport_t *viewport)
 {
     const video_render_color_tables_t *colortab;
     int rendermode;
 
-#if 0
-    log_debug("w:%i h:%i xs:%i ys:%i xt:%i yt:%i ps:%i pt:%i d%i",
-              width, height, xs, ys, xt, yt, pitchs, pitcht, depth);
-
-#endif
-    if (width <= 0) {
-        return; /* some render routines don't like invalid width */
-    }
-
-    video_sound_update(config, src, width, height, xs, ys, pitchs, viewport);
-
     rendermode = config->rendermode;
     colortab = &config->color_tables;
 
@@ -175,6 +166,43 @@ void video_render_main(video_render_config_t *config, uint8_t *src, uint8_t *trg
     rendermode_error = rendermode;
 }
 
+void video_render_main(video_render_config_t *config, uint8_t *src, uint8_t *trg,
+                       int width, int height, int xs, int ys, int xt, int yt,
+                       int pitchs, int pitcht, int depth, viewport_t *viewport)
+{
+#if 0
+    log_debug("w:%i h:%i xs:%i ys:%i xt:%i yt:%i ps:%i pt:%i d%i",
+              width, height, xs, ys, xt, yt, pitchs, pitcht, depth);
+
+#endif
+    if (width <= 0) {
+        return; /* some render routines don't like invalid width */
+    }
+
+    video_sound_update(config, src, width, height, xs, ys, pitchs, viewport);
+
+    video_render_image(config, src, trg, width, height, xs, ys, xt, yt,
+                       pitchs, pitcht, depth, viewport);
+}
+
+/* Like video_render_main(), without updating the video to audio leak.  */
+void video_render_image(video_render_config_t *config, uint8_t *src,
+                        uint8_t *trg, int width, int height,
+                        int xs, int ys, int xt, int yt,
+                        int pitchs, int pitcht, int depth, viewport_t *viewport)
+{
+    if (width <= 0) {
+        return;
+    }
+
+    if (renderthread_render(video_render_area, config, src, trg, width, height,
+                            xs, ys, xt, yt, pitchs, pitcht, depth,
+                            viewport) < 0) {
+        video_render_area(config, src, trg, width, height, xs, ys, xt, yt,
+                          pitchs, pitcht, depth, viewport);
+    }
+}
+
 void video_render_1x2func_set(void (*func)(video_render_config_t *,
                                            const uint8_t *, uint8_t *,
                                            unsigned int, const unsigned int,
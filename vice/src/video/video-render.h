@@ -39,8 +39,38 @@ extern void video_render_main(struct video_render_config_s *config, uint8_t *src
                               int xs, int ys, int xt, int yt,
                               int pitchs, int pitcht, int depth,
                               viewport_t *viewport);
+extern void video_render_image(struct video_render_config_s *config,
+                               uint8_t *src, uint8_t *trg,
+                               int width, int height,
+                               int xs, int ys, int xt, int yt,
+                               int pitchs, int pitcht, int depth,
+                               viewport_t *viewport);
 extern void video_render_update_palette(struct video_canvas_s *canvas);
 
+/* Part of the render config that has to be copied for rendering on another
+   thread: everything up to the line buffers of the color tables.  */
+#define VIDEO_RENDER_CONFIG_TABLES_SIZE \
+    (offsetof(video_render_config_t, color_tables) \
+     + offsetof(video_render_color_tables_t, line_yuv_0))
+
+/* Highest value of `VideoRenderThreads'.  */
+#define RENDERTHREAD_MAX 16
+
+typedef void (*renderthread_func_t)(struct video_render_config_s *config,
+                                    uint8_t *src, uint8_t *trg,
+                                    int width, int height,
+                                    int xs, int ys, int xt, int yt,
+                                    int pitchs, int pitcht, int depth,
+                                    viewport_t *viewport);
+
+extern int renderthread_render(renderthread_func_t func,
+                               struct video_render_config_s *config,
+                               uint8_t *src, uint8_t *trg,
+                               int width, int height,
+                               int xs, int ys, int xt, int yt,
+                               int pitchs, int pitcht, int depth,
+                               viewport_t *viewport);
+
 extern void video_render_1x2func_set(void (*func)(struct video_render_config_s *,
                                                   const uint8_t *, uint8_t *,
                                                   unsigned int, const unsigned int,
@@ -45,6 +45,7 @@
 #include "machine.h"
 #include "resources.h"
 #include "video-color.h"
+#include "video-render.h"
 #include "video.h"
 #include "viewport.h"
 #include "util.h"
@@ -70,6 +71,37 @@ static resource_int_t resources_hwscale_possible[] =
 };
 #endif
 
+#ifdef USE_WORKER_THREADS
+static int set_video_worker_thread(int val, void *param)
+{
+    videothread_sync();
+    videothread_enabled = val ? 1 : 0;
+
+    return 0;
+}
+
+static int set_video_render_threads(int val, void *param)
+{
+    if (val < 1 || val > RENDERTHREAD_MAX) {
+        return -1;
+    }
+
+    videothread_sync();
+    renderthread_count = val;
+
+    return 0;
+}
+
+static resource_int_t resources_worker_thread[] =
+{
+    { "VideoWorkerThread", 0, RES_EVENT_NO, NULL,
+      &videothread_enabled, set_video_worker_thread, NULL },
+    { "VideoRenderThreads", 1, RES_EVENT_NO, NULL,
+      &renderthread_count, set_video_render_threads, NULL },
+    RESOURCE_INT_LIST_END
+};
+#endif
+
 int video_resources_init(void)
 {
 #ifdef HAVE_HWSCALE
@@ -79,6 +111,13 @@ int video_resources_init(void)
         }
     }
 #endif
+#ifdef USE_WORKER_THREADS
+    if (machine_class != VICE_MACHINE_VSID) {
+        if (resources_register_int(resources_worker_thread) < 0) {
+            return -1;
+        }
+    }
+#endif
 
     return video_arch_resources_init();
 }
@@ -63,6 +63,8 @@ void video_viewport_resize(video_canvas_t *canvas, char resize_canvas)
         return;
     }
 
+    videothread_sync();
+
     geometry = canvas->geometry;
     viewport = canvas->viewport;
 
@@ -0,0 +1,621 @@
+/*
+ * videothread.c - Render the frames on a worker thread.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/* When enabled, the end of frame refresh only copies the draw buffer, the
+   render config and the viewport of the canvas and queues the updated
+   area; a worker thread then does the palette conversion, scaling and
+   filtering (video_render_image()) into an image of its own.  The worker
+   never calls the drawing code of the port: the frame is presented on the
+   thread that queued it, at its next refresh (or at videothread_sync()),
+   through video_canvas_refresh().  While doing so, video_canvas_render()
+   copies the area from the image (videothread_render()).
+
+   The worker renders at the position the port asked for the last time the
+   same area of the canvas was presented; if there is none yet, or it has
+   changed, the frame is rendered on presenting as usual.
+
+   There are two frames.  If the worker has not started with the previous
+   frame when the next one ends, the waiting frame is replaced by the new
+   one (its update area merged in) and counted as dropped.
+
+   The palette is only updated on the main thread, and the worker only uses
+   its copies, so changing the palette or the render config does not race
+   with it.  Everything else that draws to the canvas on the main thread
+   first presents the queued frames with videothread_sync().  */
+
+#include "vice.h"
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "videoarch.h"
+
+#include "lib.h"
+#include "log.h"
+#include "types.h"
+#include "video-canvas.h"
+#include "video-render.h"
+#include "video-sound.h"
+#include "video.h"
+#include "viewport.h"
+#include "vsyncapi.h"
+
+#ifdef USE_WORKER_THREADS
+#include <pthread.h>
+#endif
+
+int videothread_enabled = 0;
+
+#ifdef USE_WORKER_THREADS
+
+#define VIDEOTHREAD_FREE       0
+#define VIDEOTHREAD_WAITING    1
+#define VIDEOTHREAD_RENDERING  2
+#define VIDEOTHREAD_RENDERED   3
+
+/* Number of canvases whose render position is remembered.  */
+#define VIDEOTHREAD_CANVASES   4
+
+/* Area to update, as passed to video_canvas_refresh(), or the whole
+   canvas with video_canvas_refresh_all().  */
+typedef struct videothread_area_s {
+    int all;
+    unsigned int xs, ys, xi, yi, w, h;
+} videothread_area_t;
+
+/* Position of an area, as passed to video_canvas_render().  */
+typedef struct videothread_target_s {
+    int width, height, xs, ys, xt, yt, depth;
+} videothread_target_t;
+
+typedef struct videothread_record_s {
+    video_canvas_t *canvas;
+    videothread_area_t area;
+    videothread_target_t target;
+} videothread_record_t;
+
+typedef struct videothread_frame_s {
+    int state;
+
+    video_canvas_t *canvas;
+    videothread_area_t area;
+
+    /* Copy of the draw buffer.  */
+    uint8_t *buffer;
+    size_t buffer_size;
+    int pitchs;
+
+    /* Copies of the render config and the viewport.  */
+    video_render_config_t *config;
+    viewport_t viewport;
+
+    /* Rendered image, if the position is known.  */
+    int target_valid;
+    videothread_target_t target;
+    uint8_t *image;
+    size_t image_size;
+    int image_pitch;
+
+    /* Set once the position has been recorded while presenting.  */
+    int recorded;
+
+    /* Order and time the frame was queued.  */
+    unsigned long number;
+    unsigned long queued;
+} videothread_frame_t;
+
+static videothread_frame_t frames[2];
+static videothread_record_t records[VIDEOTHREAD_CANVASES];
+static unsigned long frame_number = 0;
+
+/* Frame being presented on the main thread.  */
+static videothread_frame_t *presenting = NULL;
+
+static pthread_t thread;
+static int created = 0;
+static int quit = 0;
+
+static pthread_mutex_t videothread_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t videothread_cond = PTHREAD_COND_INITIALIZER;
+
+/* Statistics, for the log at shutdown.  */
+static unsigned long frames_presented = 0;
+static unsigned long frames_dropped = 0;
+static unsigned long latency_total = 0;
+static unsigned long latency_max = 0;
+
+static log_t videothread_log = LOG_ERR;
+
+static void *videothread_main(void *arg)
+{
+    videothread_frame_t *frame;
+    videothread_target_t *t;
+    int i;
+
+    pthread_mutex_lock(&videothread_lock);
+
+    for (;;) {
+        frame = NULL;
+        while (!quit) {
+            for (i = 0; i < 2; i++) {
+                if (frames[i].state == VIDEOTHREAD_WAITING) {
+                    frame = &frames[i];
+                }
+            }
+            if (frame != NULL) {
+                break;
+            }
+            pthread_cond_wait(&videothread_cond, &videothread_lock);
+        }
+        if (quit) {
+            break;
+        }
+
+        frame->state = VIDEOTHREAD_RENDERING;
+        pthread_mutex_unlock(&videothread_lock);
+
+        if (frame->target_valid) {
+            t = &frame->target;
+            video_render_image(frame->config, frame->buffer, frame->image,
+                               t->width, t->height, t->xs, t->ys, t->xt,
+                               t->yt, frame->pitchs, frame->image_pitch,
+                               t->depth, &frame->viewport);
+        }
+
+        pthread_mutex_lock(&videothread_lock);
+
+        frame->state = VIDEOTHREAD_RENDERED;
+        pthread_cond_broadcast(&videothread_cond);
+    }
+
+    pthread_mutex_unlock(&videothread_lock);
+
+    return NULL;
+}
+
+static int videothread_create(void)
+{
+    if (created) {
+        return 0;
+    }
+
+    if (videothread_log == LOG_ERR) {
+        videothread_log = log_open("VideoThread");
+    }
+
+    if (pthread_create(&thread, NULL, videothread_main, NULL) != 0) {
+        log_error(videothread_log, "Cannot create video worker thread.");
+        videothread_enabled = 0;
+        return -1;
+    }
+    created = 1;
+
+    return 0;
+}
+
+/* Present the rendered frames in the order they were queued.  Called with
+   the lock held, which is released while presenting.  */
+static void videothread_present(void)
+{
+    videothread_frame_t *frame;
+    video_canvas_t *canvas;
+    unsigned long latency;
+    int i;
+
+    for (;;) {
+        frame = NULL;
+        for (i = 0; i < 2; i++) {
+            if (frames[i].state == VIDEOTHREAD_RENDERED
+                && (frame == NULL || frames[i].number < frame->number)) {
+                frame = &frames[i];
+            }
+        }
+        if (frame == NULL) {
+            return;
+        }
+
+        pthread_mutex_unlock(&videothread_lock);
+
+        canvas = frame->canvas;
+        presenting = frame;
+        frame->recorded = 0;
+        canvas->draw_buffer->render_buffer = frame->buffer;
+        if (frame->area.all) {
+            video_canvas_refresh_all(canvas);
+        } else {
+            video_canvas_refresh(canvas, frame->area.xs, frame->area.ys,
+                                 frame->area.xi, frame->area.yi,
+                                 frame->area.w, frame->area.h);
+        }
+        canvas->draw_buffer->render_buffer = NULL;
+        presenting = NULL;
+
+        latency = vsyncarch_gettime() - frame->queued;
+
+        pthread_mutex_lock(&videothread_lock);
+
+        frame->state = VIDEOTHREAD_FREE;
+        frames_presented++;
+        latency_total += latency;
+        if (latency > latency_max) {
+            latency_max = latency;
+        }
+        pthread_cond_broadcast(&videothread_cond);
+    }
+}
+
+static int videothread_area_equal(const videothread_area_t *a,
+                                  const videothread_area_t *b)
+{
+    if (a->all || b->all) {
+        return a->all && b->all;
+    }
+    return a->xs == b->xs && a->ys == b->ys && a->xi == b->xi
+           && a->yi == b->yi && a->w == b->w && a->h == b->h;
+}
+
+/* Extend the new update area by the one of the waiting `frame', which is
+   replaced.  */
+static void videothread_merge(videothread_frame_t *frame,
+                              videothread_area_t *area)
+{
+    videothread_area_t *old = &frame->area;
+    unsigned int x1, y1, x2, y2;
+
+    if (old->all || area->all || frame->canvas == NULL
+        || old->xs - old->xi != area->xs - area->xi
+        || old->ys - old->yi != area->ys - area->yi) {
+        area->all = 1;
+        return;
+    }
+
+    x1 = old->xs < area->xs ? old->xs : area->xs;
+    y1 = old->ys < area->ys ? old->ys : area->ys;
+    x2 = old->xs + old->w > area->xs + area->w
+         ? old->xs + old->w : area->xs + area->w;
+    y2 = old->ys + old->h > area->ys + area->h
+         ? old->ys + old->h : area->ys + area->h;
+
+    area->xi -= area->xs - x1;
+    area->yi -= area->ys - y1;
+    area->xs = x1;
+    area->ys = y1;
+    area->w = x2 - x1;
+    area->h = y2 - y1;
+}
+
+/* Set up the image of `frame' at the position its area was rendered at
+   last time.  */
+static void videothread_setup_target(videothread_frame_t *frame)
+{
+    videothread_target_t *t = &frame->target;
+    size_t size;
+    int i, bpp;
+
+    frame->target_valid = 0;
+
+    for (i = 0; i < VIDEOTHREAD_CANVASES; i++) {
+        if (records[i].canvas == frame->canvas) {
+            break;
+        }
+    }
+    if (i == VIDEOTHREAD_CANVASES
+        || !videothread_area_equal(&records[i].area, &frame->area)) {
+        return;
+    }
+    *t = records[i].target;
+
+    bpp = t->depth / 8;
+    if (bpp < 1 || t->width <= 0 || t->height <= 0 || t->xt < 0 || t->yt < 0) {
+        return;
+    }
+
+    /* some room to spare for renderers writing a bit beyond the area */
+    frame->image_pitch = (t->xt + t->width + 8) * bpp;
+    size = (size_t)frame->image_pitch * (t->yt + t->height + 1);
+    if (frame->image_size < size) {
+        lib_free(frame->image);
+        frame->image = lib_malloc(size);
+        frame->image_size = size;
+    }
+    frame->target_valid = 1;
+}
+
+/* Queue the refresh of `canvas' for the worker thread, or of the whole
+   canvas if `all' is set.  Return -1 if the caller has to do it itself.  */
+int videothread_refresh(video_canvas_t *canvas, int all,
+                        unsigned int xs, unsigned int ys,
+                        unsigned int xi, unsigned int yi,
+                        unsigned int w, unsigned int h)
+{
+    draw_buffer_t *draw_buffer = canvas->draw_buffer;
+    videothread_frame_t *frame = NULL;
+    videothread_area_t area;
+    size_t size;
+    int i;
+
+    if (!videothread_enabled || draw_buffer->draw_buffer == NULL
+        || presenting != NULL) {
+        return -1;
+    }
+
+    if (videothread_create() < 0) {
+        return -1;
+    }
+
+    area.all = all;
+    area.xs = xs;
+    area.ys = ys;
+    area.xi = xi;
+    area.yi = yi;
+    area.w = w;
+    area.h = h;
+
+    size = (size_t)draw_buffer->draw_buffer_width
+           * draw_buffer->draw_buffer_height;
+
+    pthread_mutex_lock(&videothread_lock);
+
+    while (frame == NULL) {
+        videothread_present();
+
+        for (i = 0; i < 2; i++) {
+            if (frames[i].state == VIDEOTHREAD_WAITING) {
+                break;
+            }
+        }
+        if (i < 2) {
+            /* the worker has not even started with the last frame */
+            if (frames[i].canvas == canvas) {
+                frame = &frames[i];
+                videothread_merge(frame, &area);
+                frames_dropped++;
+                break;
+            }
+            /* another canvas, wait for it */
+            pthread_cond_wait(&videothread_cond, &videothread_lock);
+            continue;
+        }
+
+        for (i = 0; i < 2; i++) {
+            if (frames[i].state == VIDEOTHREAD_FREE) {
+                frame = &frames[i];
+                break;
+            }
+        }
+        if (frame == NULL) {
+            pthread_cond_wait(&videothread_cond, &videothread_lock);
+        }
+    }
+
+    if (frame->buffer_size < size) {
+        /* one more line for the scale2x renderer, like the draw buffer */
+        lib_free(frame->buffer);
+        frame->buffer = lib_malloc(size + draw_buffer->draw_buffer_width);
+        frame->buffer_size = size;
+    }
+    memcpy(frame->buffer, draw_buffer->draw_buffer, size);
+    frame->pitchs = draw_buffer->draw_buffer_width;
+
+    /* the palette is brought up to date here, not on the worker */
+    video_canvas_update_colors(canvas);
+    if (frame->config == NULL) {
+        frame->config = lib_calloc(1, sizeof(video_render_config_t));
+    }
+    memcpy(frame->config, canvas->videoconfig, VIDEO_RENDER_CONFIG_TABLES_SIZE);
+    frame->viewport = *canvas->viewport;
+
+    frame->canvas = canvas;
+    frame->area = area;
+    videothread_setup_target(frame);
+
+    if (frame->state == VIDEOTHREAD_FREE) {
+        frame->queued = vsyncarch_gettime();
+    }
+    frame->number = frame_number++;
+    frame->state = VIDEOTHREAD_WAITING;
+
+    pthread_cond_broadcast(&videothread_cond);
+    pthread_mutex_unlock(&videothread_lock);
+
+    return 0;
+}
+
+/* Called by video_canvas_render() before rendering an area of `canvas'
+   into `trg'.  While a frame is presented, copy the area from its image
+   if the worker has rendered it at that position, or else remember the
+   position for the next frames.  Return -1 if the caller has to render
+   the area itself.  */
+int videothread_render(video_canvas_t *canvas, uint8_t *trg,
+                       int width, int height, int xs, int ys,
+                       int xt, int yt, int pitcht, int depth)
+{
+    videothread_frame_t *frame = presenting;
+    videothread_target_t *t;
+    size_t offset, bytes;
+    int i;
+
+    if (frame == NULL || frame->canvas != canvas) {
+        return -1;
+    }
+
+    t = &frame->target;
+    if (frame->target_valid
+        && t->width == width && t->height == height && t->xs == xs
+        && t->ys == ys && t->xt == xt && t->yt == yt && t->depth == depth) {
+        video_sound_update(frame->config, frame->buffer, width, height,
+                           xs, ys, frame->pitchs, &frame->viewport);
+
+        bytes = (size_t)width * (depth / 8);
+        for (i = yt; i < yt + height; i++) {
+            offset = (size_t)xt * (depth / 8);
+            memcpy(trg + (size_t)i * pitcht + offset,
+                   frame->image + (size_t)i * frame->image_pitch + offset,
+                   bytes);
+        }
+        return 0;
+    }
+
+    if (!frame->recorded) {
+        frame->recorded = 1;
+        for (i = 0; i < VIDEOTHREAD_CANVASES - 1; i++) {
+            if (records[i].canvas == canvas || records[i].canvas == NULL) {
+                break;
+            }
+        }
+        records[i].canvas = canvas;
+        records[i].area = frame->area;
+        records[i].target.width = width;
+        records[i].target.height = height;
+        records[i].target.xs = xs;
+        records[i].target.ys = ys;
+        records[i].target.xt = xt;
+        records[i].target.yt = yt;
+        records[i].target.depth = depth;
+    }
+
+    return -1;
+}
+
+/* Wait until the worker thread has rendered all queued frames, and present
+   them.  */
+void videothread_sync(void)
+{
+    int i, busy;
+
+    if (!created || presenting != NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&videothread_lock);
+    for (;;) {
+        videothread_present();
+
+        busy = 0;
+        for (i = 0; i < 2; i++) {
+            if (frames[i].state == VIDEOTHREAD_WAITING
+                || frames[i].state == VIDEOTHREAD_RENDERING) {
+                busy = 1;
+            }
+        }
+        if (!busy) {
+            break;
+        }
+        pthread_cond_wait(&videothread_cond, &videothread_lock);
+    }
+    pthread_mutex_unlock(&videothread_lock);
+}
+
+void videothread_get_stats(videothread_stats_t *stats)
+{
+    double freq = (double)vsyncarch_frequency();
+
+    pthread_mutex_lock(&videothread_lock);
+    stats->presented = frames_presented;
+    stats->dropped = frames_dropped;
+    stats->latency_average = frames_presented > 0
+                             ? latency_total * 1000.0
+                               / (freq * frames_presented)
+                             : 0.0;
+    stats->latency_max = latency_max * 1000.0 / freq;
+    pthread_mutex_unlock(&videothread_lock);
+}
+
+void videothread_shutdown(void)
+{
+    videothread_stats_t stats;
+    int i;
+
+    if (!created) {
+        return;
+    }
+
+    videothread_sync();
+
+    pthread_mutex_lock(&videothread_lock);
+    quit = 1;
+    pthread_cond_broadcast(&videothread_cond);
+    pthread_mutex_unlock(&videothread_lock);
+
+    pthread_join(thread, NULL);
+    created = 0;
+    quit = 0;
+
+    for (i = 0; i < 2; i++) {
+        lib_free(frames[i].buffer);
+        frames[i].buffer = NULL;
+        frames[i].buffer_size = 0;
+        lib_free(frames[i].config);
+        frames[i].config = NULL;
+        lib_free(frames[i].image);
+        frames[i].image = NULL;
+        frames[i].image_size = 0;
+        frames[i].canvas = NULL;
+        frames[i].state = VIDEOTHREAD_FREE;
+    }
+    memset(records, 0, sizeof(records));
+
+    videothread_get_stats(&stats);
+    if (stats.presented > 0) {
+        log_message(videothread_log,
+                    "%lu frames presented, %lu dropped, latency %.2f ms average, %.2f ms max.",
+                    stats.presented, stats.dropped, stats.latency_average,
+                    stats.latency_max);
+    }
+}
+
+#else
+
+int videothread_refresh(video_canvas_t *canvas, int all,
+                        unsigned int xs, unsigned int ys,
+                        unsigned int xi, unsigned int yi,
+                        unsigned int w, unsigned int h)
+{
+    return -1;
+}
+
+int videothread_render(video_canvas_t *canvas, uint8_t *trg,
+                       int width, int height, int xs, int ys,
+                       int xt, int yt, int pitcht, int depth)
+{
+    return -1;
+}
+
+void videothread_sync(void)
+{
+}
+
+void videothread_get_stats(videothread_stats_t *stats)
+{
+    stats->presented = 0;
+    stats->dropped = 0;
+    stats->latency_average = 0.0;
+    stats->latency_max = 0.0;
+}
+
+void videothread_shutdown(void)
+{
+}
+
+#endif
@@ -56,6 +56,7 @@ int vsync_frame_counter;
 #include "videoarch.h"
 #endif
 
+#include "benchmark.h"
 #include "clkguard.h"
 #include "cmdline.h"
 #include "debug.h"
@@ -67,9 +68,11 @@ int vsync_frame_counter;
 #endif
 #include "network.h"
 #include "resources.h"
+#include "rewind.h"
 #include "sound.h"
 #include "translate.h"
 #include "types.h"
+#include "video.h"
 #include "vsync.h"
 #include "vsyncapi.h"
 
@@ -323,6 +326,8 @@ void vsync_suspend_speed_eval(void)
 {
     network_suspend();
     sound_suspend();
+    /* show the last frame rendered on the video worker thread */
+    videothread_sync();
     vsync_sync_reset();
     speed_eval_suspended = 1;
 }
@@ -371,6 +376,8 @@ int vsync_do_vsync(struct video_canvas_s *c, int been_skipped)
     int refresh_div;
 #endif
 
+    BENCHMARK_ENTER(BENCHMARK_VSYNC);
+
 #ifdef HAVE_NETWORK
     /* check if someone wants to connect remotely to the monitor */
     monitor_check_remote();
@@ -390,6 +397,7 @@ int vsync_do_vsync(struct video_canvas_s *c, int been_skipped)
     }
 
     vsync_hook();
+    rewind_vsync_hook();
 
     if (network_connected()) {
         network_hook_time = vsyncarch_gettime() - network_hook_time;
@@ -597,6 +605,9 @@ int vsync_do_vsync(struct video_canvas_s *c, int been_skipped)
     log_debug("vsync: start:%lu  delay:%ld  sound-delay:%lf  end:%lu  next-frame:%lu  frame-ticks:%lu", 
                 now, delay, sound_delay * 1000000, vsyncarch_gettime(), next_frame_start, frame_ticks);
 #endif
+
+    BENCHMARK_LEAVE();
+
     return skip_next_frame;
 }
 
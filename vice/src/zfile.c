@@ -30,6 +30,11 @@
 
 /* This code might be improved a lot...  */
 
+/* For fopencookie().  */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
 #include "vice.h"
 
 #include <ctype.h>
@@ -68,6 +73,15 @@
 #define ZDEBUG(a)
 #endif
 
+/* Uncompressed files are kept in memory and accessed through a custom
+   stdio stream where the C library allows it.  */
+#if defined(HAVE_FOPENCOOKIE) || defined(HAVE_FUNOPEN)
+#define ZFILE_MEMORY_STREAMS
+#endif
+
+/* Chunk size used for (un)compressing with zlib.  */
+#define ZFILE_CHUNK_SIZE    0x10000
+
 /* We could add more here...  */
 enum compression_type {
     COMPR_NONE,
@@ -79,10 +93,20 @@ enum compression_type {
     COMPR_TZX
 };
 
+/* Contents of an uncompressed file kept in memory.  */
+typedef struct zfile_mem_s {
+    char *data;
+    size_t size;                 /* Size of the file.  */
+    size_t alloc;                /* Size of `data'.  */
+    size_t pos;                  /* Current position.  */
+    int dirty;                   /* Non-zero if the file has been written to. */
+} zfile_mem_t;
+
 /* This defines a linked list of all the compressed files that have been
    opened.  */
 struct zfile_s {
     char *tmp_name;              /* Name of the temporary file.  */
+    zfile_mem_t *mem;            /* Contents, if kept in memory instead.  */
     char *orig_name;             /* Name of the original file.  */
     int write_mode;              /* Non-zero if the file is open for writing.*/
     FILE *stream;                /* Associated stdio-style stream.  */
@@ -134,6 +158,10 @@ static void zfile_list_destroy(void)
 
         lib_free(p->orig_name);
         lib_free(p->tmp_name);
+        if (p->mem != NULL) {
+            lib_free(p->mem->data);
+            lib_free(p->mem);
+        }
         next = p->next;
         lib_free(p);
         p = next;
@@ -157,6 +185,7 @@ static int zinit(void)
 /* Add one zfile to the list.  `orig_name' is automatically expanded to the
    complete path.  */
 static void zfile_list_add(const char *tmp_name,
+                           zfile_mem_t *mem,
                            const char *orig_name,
                            enum compression_type type,
                            int write_mode,
@@ -169,6 +198,7 @@ static void zfile_list_add(const char *tmp_name,
 
     /* The new zfile becomes first on the list.  */
     new_zfile->tmp_name = tmp_name ? lib_stralloc(tmp_name) : NULL;
+    new_zfile->mem = mem;
     new_zfile->write_mode = write_mode;
     new_zfile->stream = stream;
     new_zfile->fd = fd;
@@ -190,8 +220,246 @@ void zfile_shutdown(void)
 
 /* ------------------------------------------------------------------------ */
 
+/* Memory streams.  */
+
+#ifdef ZFILE_MEMORY_STREAMS
+
+static void zfile_mem_free(zfile_mem_t *mem)
+{
+    lib_free(mem->data);
+    lib_free(mem);
+}
+
+/* Make room for `size' bytes.  */
+static void zfile_mem_reserve(zfile_mem_t *mem, size_t size)
+{
+    if (size > mem->alloc) {
+        size_t alloc = mem->alloc ? mem->alloc : ZFILE_CHUNK_SIZE;
+
+        while (alloc < size) {
+            alloc *= 2;
+        }
+        mem->data = lib_realloc(mem->data, alloc);
+        mem->alloc = alloc;
+    }
+}
+
+/* Read the file `name' into memory.  */
+static zfile_mem_t *zfile_mem_load(const char *name)
+{
+    zfile_mem_t *mem;
+    FILE *fd;
+    size_t len;
+
+    fd = fopen(name, MODE_READ);
+    if (fd == NULL) {
+        return NULL;
+    }
+
+    mem = lib_calloc(1, sizeof(zfile_mem_t));
+
+    do {
+        zfile_mem_reserve(mem, mem->size + ZFILE_CHUNK_SIZE);
+        len = fread(mem->data + mem->size, 1, mem->alloc - mem->size, fd);
+        mem->size += len;
+    } while (len > 0);
+
+    if (ferror(fd)) {
+        fclose(fd);
+        zfile_mem_free(mem);
+        return NULL;
+    }
+
+    fclose(fd);
+    return mem;
+}
+
+/* Write the contents of `mem' into a new temporary file and return its
+   name.  */
+static char *zfile_mem_save(const zfile_mem_t *mem)
+{
+    char *tmp_name = NULL;
+    FILE *fd;
+
+    fd = archdep_mkstemp_fd(&tmp_name, MODE_WRITE);
+    if (fd == NULL) {
+        return NULL;
+    }
+
+    if (mem->size > 0 && fwrite(mem->data, mem->size, 1, fd) < 1) {
+        fclose(fd);
+        ioutil_remove(tmp_name);
+        lib_free(tmp_name);
+        return NULL;
+    }
+
+    fclose(fd);
+    return tmp_name;
+}
+
+static long zfile_mem_do_read(zfile_mem_t *mem, char *buf, size_t size)
+{
+    if (mem->pos >= mem->size) {
+        return 0;
+    }
+    if (size > mem->size - mem->pos) {
+        size = mem->size - mem->pos;
+    }
+    memcpy(buf, mem->data + mem->pos, size);
+    mem->pos += size;
+    return (long)size;
+}
+
+static long zfile_mem_do_write(zfile_mem_t *mem, const char *buf, size_t size)
+{
+    zfile_mem_reserve(mem, mem->pos + size);
+
+    /* Seeking beyond the end leaves a gap of zeroes, like with files.  */
+    if (mem->pos > mem->size) {
+        memset(mem->data + mem->size, 0, mem->pos - mem->size);
+    }
+    memcpy(mem->data + mem->pos, buf, size);
+    mem->pos += size;
+    if (mem->pos > mem->size) {
+        mem->size = mem->pos;
+    }
+    mem->dirty = 1;
+    return (long)size;
+}
+
+static long zfile_mem_do_seek(zfile_mem_t *mem, long offset, int whence)
+{
+    switch (whence) {
+        case SEEK_CUR:
+            offset += (long)mem->pos;
+            break;
+        case SEEK_END:
+            offset += (long)mem->size;
+            break;
+    }
+    if (offset < 0) {
+        return -1;
+    }
+    mem->pos = (size_t)offset;
+    return offset;
+}
+
+static int zfile_mem_close(void *cookie)
+{
+    /* The contents are freed by handle_close().  */
+    return 0;
+}
+
+#ifdef HAVE_FOPENCOOKIE
+static ssize_t zfile_mem_read(void *cookie, char *buf, size_t size)
+{
+    return (ssize_t)zfile_mem_do_read(cookie, buf, size);
+}
+
+static ssize_t zfile_mem_write(void *cookie, const char *buf, size_t size)
+{
+    return (ssize_t)zfile_mem_do_write(cookie, buf, size);
+}
+
+static int zfile_mem_seek(void *cookie, off64_t *offset, int whence)
+{
+    long pos = zfile_mem_do_seek(cookie, (long)*offset, whence);
+
+    if (pos < 0) {
+        return -1;
+    }
+    *offset = pos;
+    return 0;
+}
+#else
+static int zfile_mem_read(void *cookie, char *buf, int size)
+{
+    return (int)zfile_mem_do_read(cookie, buf, (size_t)size);
+}
+
+static int zfile_mem_write(void *cookie, const char *buf, int size)
+{
+    return (int)zfile_mem_do_write(cookie, buf, (size_t)size);
+}
+
+static fpos_t zfile_mem_seek(void *cookie, fpos_t offset, int whence)
+{
+    return (fpos_t)zfile_mem_do_seek(cookie, (long)offset, whence);
+}
+#endif
+
+/* Open a stdio stream on `mem'.  */
+static FILE *zfile_mem_open(zfile_mem_t *mem, const char *mode)
+{
+#ifdef HAVE_FOPENCOOKIE
+    cookie_io_functions_t io;
+
+    io.read = zfile_mem_read;
+    io.write = zfile_mem_write;
+    io.seek = zfile_mem_seek;
+    io.close = zfile_mem_close;
+#endif
+
+    if (strchr(mode, 'w') != NULL) {
+        mem->size = 0;
+        mem->dirty = 1;
+    }
+    mem->pos = (strchr(mode, 'a') != NULL) ? mem->size : 0;
+
+#ifdef HAVE_FOPENCOOKIE
+    return fopencookie(mem, mode, io);
+#else
+    return funopen(mem, zfile_mem_read, zfile_mem_write, zfile_mem_seek,
+                   zfile_mem_close);
+#endif
+}
+
+#endif
+
+/* ------------------------------------------------------------------------ */
+
 /* Uncompression.  */
 
+#if defined(HAVE_ZLIB) && defined(ZFILE_MEMORY_STREAMS)
+/* If `name' has a gzip-like extension, try to uncompress it into memory
+   using zlib.  */
+static zfile_mem_t *try_uncompress_with_gzip_to_memory(const char *name)
+{
+    zfile_mem_t *mem;
+    gzFile fdsrc;
+    int len;
+
+    if (!file_is_gzip(name)) {
+        return NULL;
+    }
+
+    fdsrc = gzopen(name, MODE_READ);
+    if (fdsrc == NULL) {
+        return NULL;
+    }
+
+    mem = lib_calloc(1, sizeof(zfile_mem_t));
+
+    do {
+        zfile_mem_reserve(mem, mem->size + ZFILE_CHUNK_SIZE);
+        len = gzread(fdsrc, (void *)(mem->data + mem->size),
+                     (unsigned int)(mem->alloc - mem->size));
+        if (len > 0) {
+            mem->size += (size_t)len;
+        }
+    } while (len > 0);
+
+    gzclose(fdsrc);
+
+    if (len < 0) {
+        zfile_mem_free(mem);
+        return NULL;
+    }
+
+    return mem;
+}
+#endif
+
 /* If `name' has a gzip-like extension, try to uncompress it into a temporary
    file using gzip or zlib if available.  If this succeeds, return the name
    of the temporary file; return NULL otherwise.  */
@@ -201,6 +469,7 @@ static char *try_uncompress_with_gzip(const char *name)
     FILE *fddest;
     gzFile fdsrc;
     char *tmp_name = NULL;
+    char *buf;
     int len;
 
     if (!file_is_gzip(name)) {
@@ -221,12 +490,13 @@ static char *try_uncompress_with_gzip(const char *name)
         return NULL;
     }
 
-    do {
-        char buf[256];
+    buf = lib_malloc(ZFILE_CHUNK_SIZE);
 
-        len = gzread(fdsrc, (void *)buf, 256);
+    do {
+        len = gzread(fdsrc, (void *)buf, ZFILE_CHUNK_SIZE);
         if (len > 0) {
-            if (fwrite((void *)buf, 1, (size_t)len, fddest) < len) {
+            if (fwrite((void *)buf, 1, (size_t)len, fddest) < (size_t)len) {
+                lib_free(buf);
                 gzclose(fdsrc);
                 fclose(fddest);
                 ioutil_remove(tmp_name);
@@ -236,6 +506,7 @@ static char *try_uncompress_with_gzip(const char *name)
         }
     } while (len > 0);
 
+    lib_free(buf);
     gzclose(fdsrc);
     fclose(fddest);
 
@@ -767,15 +1038,20 @@ static const valid_archives_t valid_archives[] = {
 /* Try to uncompress file `name' using the algorithms we know of.  If this is
    not possible, return `COMPR_NONE'.  Otherwise, uncompress the file into a
    temporary file, return the type of algorithm used and the name of the
-   temporary file in `tmp_name'.  If `write_mode' is non-zero and the
+   temporary file in `tmp_name', or uncompress it into memory and return the
+   contents in `mem'.  If `write_mode' is non-zero and the
    returned `tmp_name' has zero length, then the file cannot be accessed in
    write mode.  */
 static enum compression_type try_uncompress(const char *name,
                                             char **tmp_name,
+                                            zfile_mem_t **mem,
                                             int write_mode)
 {
     int i;
 
+    *tmp_name = NULL;
+    *mem = NULL;
+
     for (i = 0; valid_archives[i].program; i++) {
         if ((*tmp_name = try_uncompress_archive(name, write_mode,
                                                 valid_archives[i].program,
@@ -789,6 +1065,11 @@ static enum compression_type try_uncompress(const char *name,
     }
 
     /* need this order or .tar.gz is misunderstood */
+#if defined(HAVE_ZLIB) && defined(ZFILE_MEMORY_STREAMS)
+    if ((*mem = try_uncompress_with_gzip_to_memory(name)) != NULL) {
+        return COMPR_GZIP;
+    }
+#endif
     if ((*tmp_name = try_uncompress_with_gzip(name)) != NULL) {
         return COMPR_GZIP;
     }
@@ -816,35 +1097,53 @@ static enum compression_type try_uncompress(const char *name,
 
 /* Compression.  */
 
-/* Compress `src' into `dest' using gzip.  */
-static int compress_with_gzip(const char *src, const char *dest)
+/* Compress `src', or the contents `mem' if not NULL, into `dest' using
+   gzip.  */
+static int compress_with_gzip(const char *src, const zfile_mem_t *mem,
+                              const char *dest)
 {
 #ifdef HAVE_ZLIB
-    FILE *fdsrc;
+    FILE *fdsrc = NULL;
     gzFile fddest;
     size_t len;
+    char *buf;
 
-    fdsrc = fopen(dest, MODE_READ);
-    if (fdsrc == NULL) {
-        return -1;
+    if (mem == NULL) {
+        fdsrc = fopen(src, MODE_READ);
+        if (fdsrc == NULL) {
+            return -1;
+        }
     }
 
-    fddest = gzopen(src, MODE_WRITE "9");
+    fddest = gzopen(dest, MODE_WRITE "9");
     if (fddest == NULL) {
-        fclose(fdsrc);
+        if (fdsrc != NULL) {
+            fclose(fdsrc);
+        }
         return -1;
     }
 
-    do {
-        char buf[256];
-        len = fread((void *)buf, 256, 1, fdsrc);
-        if (len > 0) {
-            gzwrite(fddest, (void *)buf, (unsigned int)len);
+    if (mem != NULL) {
+        if (mem->size > 0
+            && gzwrite(fddest, (void *)mem->data, (unsigned int)mem->size) <= 0) {
+            gzclose(fddest);
+            return -1;
         }
-    } while (len > 0);
+    } else {
+        buf = lib_malloc(ZFILE_CHUNK_SIZE);
+        do {
+            len = fread((void *)buf, 1, ZFILE_CHUNK_SIZE, fdsrc);
+            if (len > 0) {
+                gzwrite(fddest, (void *)buf, (unsigned int)len);
+            }
+        } while (len > 0);
+        lib_free(buf);
+        fclose(fdsrc);
+    }
 
-    gzclose(fddest);
-    fclose(fdsrc);
+    if (gzclose(fddest) != Z_OK) {
+        return -1;
+    }
 
     ZDEBUG(("compress with zlib: OK."));
 
@@ -914,9 +1213,11 @@ static int compress_with_bzip(const char *src, const char *dest)
     }
 }
 
-/* Compress `src' into `dest' using algorithm `type'.  */
-static int zfile_compress(const char *src, const char *dest,
-                          enum compression_type type)
+/* Compress `src', or the contents `mem' if not NULL, into `dest' using
+   algorithm `type'.  Only gzip can compress from memory, and only with
+   zlib.  */
+static int zfile_compress(const char *src, const zfile_mem_t *mem,
+                          const char *dest, enum compression_type type)
 {
     char *dest_backup_name;
     int retval;
@@ -979,7 +1280,7 @@ static int zfile_compress(const char *src, const char *dest,
 
     switch (type) {
         case COMPR_GZIP:
-            retval = compress_with_gzip(src, dest);
+            retval = compress_with_gzip(src, mem, dest);
             break;
         case COMPR_BZIP:
             retval = compress_with_bzip(src, dest);
@@ -1025,6 +1326,7 @@ static int zfile_compress(const char *src, const char *dest,
 FILE *zfile_fopen(const char *name, const char *mode)
 {
     char *tmp_name;
+    zfile_mem_t *mem;
     FILE *stream;
     enum compression_type type;
     int write_mode = 0;
@@ -1047,26 +1349,50 @@ FILE *zfile_fopen(const char *name, const char *mode)
         return NULL;
     }
 
-    type = try_uncompress(name, &tmp_name, write_mode);
+    type = try_uncompress(name, &tmp_name, &mem, write_mode);
     if (type == COMPR_NONE) {
         stream = fopen(name, mode);
         if (stream == NULL) {
             return NULL;
         }
-        zfile_list_add(NULL, name, type, write_mode, stream, NULL);
+        zfile_list_add(NULL, NULL, name, type, write_mode, stream, NULL);
         return stream;
-    } else if (*tmp_name == '\0') {
+    } else if (mem == NULL && *tmp_name == '\0') {
+        lib_free(tmp_name);
         errno = EACCES;
         return NULL;
     }
 
+#ifdef ZFILE_MEMORY_STREAMS
+    /* Keep the uncompressed file in memory, so the temporary file (if any)
+       can go right away.  */
+    if (mem == NULL) {
+        mem = zfile_mem_load(tmp_name);
+        if (mem != NULL) {
+            ioutil_remove(tmp_name);
+            lib_free(tmp_name);
+            tmp_name = NULL;
+        }
+    }
+
+    if (mem != NULL) {
+        stream = zfile_mem_open(mem, mode);
+        if (stream == NULL) {
+            zfile_mem_free(mem);
+            return NULL;
+        }
+        zfile_list_add(NULL, mem, name, type, write_mode, stream, NULL);
+        return stream;
+    }
+#endif
+
     /* Open the uncompressed version of the file.  */
     stream = fopen(tmp_name, mode);
     if (stream == NULL) {
         return NULL;
     }
 
-    zfile_list_add(tmp_name, name, type, write_mode, stream, NULL);
+    zfile_list_add(tmp_name, NULL, name, type, write_mode, stream, NULL);
 
     /* now we don't need the archdep_tmpnam allocation any more */
     lib_free(tmp_name);
@@ -1099,6 +1425,34 @@ static int handle_close_action(zfile_t *ptr)
     return 0;
 }
 
+#ifdef ZFILE_MEMORY_STREAMS
+/* Compress the contents `mem' into `dest' using algorithm `type'.  */
+static int zfile_compress_memory(const zfile_mem_t *mem, const char *dest,
+                                 enum compression_type type)
+{
+    char *tmp_name;
+    int retval;
+
+#ifdef HAVE_ZLIB
+    if (type == COMPR_GZIP) {
+        return zfile_compress(NULL, mem, dest, type);
+    }
+#endif
+
+    tmp_name = zfile_mem_save(mem);
+    if (tmp_name == NULL) {
+        log_error(zlog, "Cannot create temporary file for `%s'.", dest);
+        return -1;
+    }
+
+    retval = zfile_compress(tmp_name, NULL, dest, type);
+
+    ioutil_remove(tmp_name);
+    lib_free(tmp_name);
+    return retval;
+}
+#endif
+
 /* Handle close of a (compressed file). `ptr' points to the zfile to close.  */
 static int handle_close(zfile_t *ptr)
 {
@@ -1110,7 +1464,7 @@ static int handle_close(zfile_t *ptr)
         /* Recompress into the original file.  */
         if (ptr->orig_name
             && ptr->write_mode
-            && zfile_compress(ptr->tmp_name, ptr->orig_name, ptr->type)) {
+            && zfile_compress(ptr->tmp_name, NULL, ptr->orig_name, ptr->type)) {
             return -1;
         }
 
@@ -1120,6 +1474,21 @@ static int handle_close(zfile_t *ptr)
         }
     }
 
+#ifdef ZFILE_MEMORY_STREAMS
+    if (ptr->mem) {
+        /* Recompress into the original file, if it was changed.  */
+        if (ptr->orig_name
+            && ptr->write_mode
+            && ptr->mem->dirty
+            && zfile_compress_memory(ptr->mem, ptr->orig_name, ptr->type)) {
+            return -1;
+        }
+
+        zfile_mem_free(ptr->mem);
+        ptr->mem = NULL;
+    }
+#endif
+
     handle_close_action(ptr);
 
     /* Remove item from list.  */